@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "engine.h"
+#include "mesh_regions.h"
+#include "skinning.h"
+
+// ---------- lite2d_alloc_check: warmed-up update()/render() must not touch the heap (CTest) ----------
+//
+// The viewer's --check-allocs needs a window. This runs the same frame loop headlessly: the GLAD
+// entry points the engine uses are pointed at a null driver that keeps buffer contents in host
+// memory and draws nothing, and the model is synthetic, so the check runs in plain ctest. The
+// executable links its own counting copy of alloc_counter.cc (see CMakeLists.txt), so it counts
+// whether or not LITE2D_COUNT_ALLOCATIONS is on.
+
+// Exit code CTest reports as skipped (SKIP_RETURN_CODE).
+constexpr int kSkipped = 77;
+
+static void printUsage(const char *argv0)
+{
+  std::cerr << "Usage: " << argv0 << " [options]\n"
+            << "Options:\n"
+            << "      --warmup=N              Frames before counting starts (default 120)\n"
+            << "  -n, --frames=N              Counted frames per skinning mode (default 300)\n"
+            << "      --meshes=N              Synthetic meshes (default 48)\n"
+            << "      --grid=N                Quads per side of each synthetic mesh (default 24)\n"
+            << "  -h, --help                  Show this help\n";
+}
+
+static bool parseOptionValue(const std::string &arg, const std::string &longName, std::string &out)
+{
+  const std::string prefix = "--" + longName + "=";
+  if (arg.rfind(prefix, 0) == 0)
+  {
+    out = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+static bool parseShortOptionValue(const std::string &arg, const std::string &shortName, std::string &out)
+{
+  const std::string prefix = "-" + shortName + "=";
+  if (arg.rfind(prefix, 0) == 0)
+  {
+    out = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+namespace
+{
+// Null GL driver state: buffer contents by name, and the buffer bound to each target.
+GLuint nextName = 1;
+std::unordered_map<GLuint, std::vector<uint8_t>> buffers;
+GLuint arrayBinding = 0, elementBinding = 0, copyReadBinding = 0, copyWriteBinding = 0, textureBinding = 0;
+uintptr_t nextSync = 1;
+
+GLuint &binding(GLenum target)
+{
+  switch (target)
+  {
+    case GL_ARRAY_BUFFER:
+      return arrayBinding;
+    case GL_ELEMENT_ARRAY_BUFFER:
+      return elementBinding;
+    case GL_COPY_READ_BUFFER:
+      return copyReadBinding;
+    case GL_COPY_WRITE_BUFFER:
+      return copyWriteBinding;
+    default:
+      return textureBinding;
+  }
+}
+
+std::vector<uint8_t> &boundStore(GLenum target)
+{
+  return buffers[binding(target)];
+}
+
+void genNames(GLsizei n, GLuint *names)
+{
+  for (GLsizei i = 0; i < n; ++i)
+    names[i] = nextName++;
+}
+
+// Points every GL entry point the engine calls at the null driver. Anything else stays null, so a
+// new GL call in the frame loop fails loudly here instead of going unchecked.
+void installNullGL()
+{
+  glad_glGenBuffers = [](GLsizei n, GLuint *names) { genNames(n, names); };
+  glad_glGenTextures = [](GLsizei n, GLuint *names) { genNames(n, names); };
+  glad_glGenVertexArrays = [](GLsizei n, GLuint *names) { genNames(n, names); };
+  glad_glDeleteBuffers = [](GLsizei n, const GLuint *names)
+  {
+    for (GLsizei i = 0; i < n; ++i)
+      buffers.erase(names[i]);
+  };
+  glad_glBindBuffer = [](GLenum target, GLuint buffer) { binding(target) = buffer; };
+  // Respecifying a store with the same size (orphaning) keeps its memory, as a driver would.
+  glad_glBufferData = [](GLenum target, GLsizeiptr size, const void *data, GLenum)
+  {
+    std::vector<uint8_t> &store = boundStore(target);
+    store.resize(size_t(size));
+    if (data)
+      std::memcpy(store.data(), data, size_t(size));
+  };
+  glad_glBufferSubData = [](GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+  { std::memcpy(boundStore(target).data() + offset, data, size_t(size)); };
+  glad_glCopyBufferSubData = [](GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset,
+                                GLsizeiptr size)
+  {
+    std::memcpy(boundStore(writeTarget).data() + writeOffset, boundStore(readTarget).data() + readOffset,
+                size_t(size));
+  };
+  glad_glMapBufferRange = [](GLenum target, GLintptr offset, GLsizeiptr, GLbitfield) -> void *
+  { return boundStore(target).data() + offset; };
+  glad_glFlushMappedBufferRange = [](GLenum, GLintptr, GLsizeiptr) {};
+  glad_glUnmapBuffer = [](GLenum) -> GLboolean { return GL_TRUE; };
+  glad_glFenceSync = [](GLenum, GLbitfield) { return reinterpret_cast<GLsync>(nextSync++); };
+  glad_glClientWaitSync = [](GLsync, GLbitfield, GLuint64) -> GLenum { return GL_ALREADY_SIGNALED; };
+  glad_glDeleteSync = [](GLsync) {};
+
+  glad_glCreateShader = [](GLenum) { return nextName++; };
+  glad_glCreateProgram = []() { return nextName++; };
+  glad_glShaderSource = [](GLuint, GLsizei, const GLchar *const *, const GLint *) {};
+  glad_glCompileShader = [](GLuint) {};
+  glad_glAttachShader = [](GLuint, GLuint) {};
+  glad_glLinkProgram = [](GLuint) {};
+  glad_glDeleteShader = [](GLuint) {};
+  // Every shader compiles and links, with an empty info log.
+  glad_glGetShaderiv = [](GLuint, GLenum pname, GLint *params)
+  { *params = pname == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE; };
+  glad_glGetProgramiv = [](GLuint, GLenum pname, GLint *params)
+  { *params = pname == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE; };
+  glad_glGetShaderInfoLog = [](GLuint, GLsizei, GLsizei *, GLchar *) {};
+  glad_glGetProgramInfoLog = [](GLuint, GLsizei, GLsizei *, GLchar *) {};
+  glad_glIsProgram = [](GLuint program) -> GLboolean { return program != 0; };
+  glad_glUseProgram = [](GLuint) {};
+  glad_glGetUniformLocation = [](GLuint, const GLchar *) -> GLint { return 0; };
+  glad_glUniform1i = [](GLint, GLint) {};
+  glad_glUniformMatrix4fv = [](GLint, GLsizei, GLboolean, const GLfloat *) {};
+
+  glad_glGetError = []() -> GLenum { return GL_NO_ERROR; };
+  // GL 3.3 without extensions, and a stencil buffer so clipped meshes take the stencil path.
+  glad_glGetIntegerv = [](GLenum pname, GLint *data)
+  {
+    switch (pname)
+    {
+      case GL_MAJOR_VERSION:
+        *data = 3;
+        break;
+      case GL_MINOR_VERSION:
+        *data = 3;
+        break;
+      case GL_STENCIL_BITS:
+        *data = 8;
+        break;
+      default:
+        *data = 0;
+        break;
+    }
+  };
+  glad_glGetStringi = [](GLenum, GLuint) -> const GLubyte * { return nullptr; };
+
+  glad_glBindVertexArray = [](GLuint) {};
+  glad_glEnableVertexAttribArray = [](GLuint) {};
+  glad_glVertexAttribPointer = [](GLuint, GLint, GLenum, GLboolean, GLsizei, const void *) {};
+  glad_glVertexAttribIPointer = [](GLuint, GLint, GLenum, GLsizei, const void *) {};
+  glad_glActiveTexture = [](GLenum) {};
+  glad_glBindTexture = [](GLenum, GLuint) {};
+  glad_glTexBuffer = [](GLenum, GLenum, GLuint) {};
+  glad_glTexImage2D = [](GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void *) {};
+  glad_glTexParameteri = [](GLenum, GLenum, GLint) {};
+
+  glad_glViewport = [](GLint, GLint, GLsizei, GLsizei) {};
+  glad_glClearColor = [](GLfloat, GLfloat, GLfloat, GLfloat) {};
+  glad_glClear = [](GLbitfield) {};
+  glad_glEnable = [](GLenum) {};
+  glad_glDisable = [](GLenum) {};
+  glad_glBlendFunc = [](GLenum, GLenum) {};
+  glad_glColorMask = [](GLboolean, GLboolean, GLboolean, GLboolean) {};
+  glad_glStencilFunc = [](GLenum, GLint, GLuint) {};
+  glad_glStencilOp = [](GLenum, GLenum, GLenum) {};
+  glad_glStencilMask = [](GLuint) {};
+  glad_glDrawElementsBaseVertex = [](GLenum, GLsizei, GLenum, const void *, GLint) {};
+  glad_glMultiDrawElementsBaseVertex = [](GLenum, const GLsizei *, GLenum, const void *const *, GLsizei,
+                                          const GLint *) {};
+}
+
+// A deformer chain and grid meshes bound to pairs of its links, with eye and mouth regions so the
+// idle animation changes their pose, one clip mask and a clipped mesh, all on the checker texture.
+void makeSyntheticModel(Model &model, int meshCount, int grid)
+{
+  constexpr int kDeformers = 8;
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+
+  model.initParams();
+  AnimationClip idle;
+  idle.name = "idle";
+  idle.duration = 2.0f;
+  Track sway;
+  sway.param_id = "ParamAngleZ";
+  sway.keys = {{0.0f, -10.0f}, {1.0f, 10.0f}, {2.0f, -10.0f}};
+  idle.tracks.push_back(sway);
+  model.animations.push_back(idle);
+
+  for (int d = 0; d < kDeformers; ++d)
+  {
+    Deformer def;
+    def.id = "def_" + std::to_string(d);
+    def.parent = d > 0 ? "def_" + std::to_string(d - 1) : "";
+    def.pos = {unit(rng) * 0.1f, unit(rng) * 0.1f};
+    if (d + 1 < kDeformers)
+      def.children.push_back("def_" + std::to_string(d + 1));
+    model.deformers.emplace(def.id, def);
+  }
+
+  for (int i = 0; i < meshCount; ++i)
+  {
+    ArtMesh m;
+    m.id = "mesh_" + std::to_string(i);
+    m.texture_id = "tex_checker";
+    m.draw_order = i;
+    m.deformers = {"def_" + std::to_string(rng() % kDeformers), "def_" + std::to_string(rng() % kDeformers)};
+    for (int y = 0; y <= grid; ++y)
+    {
+      for (int x = 0; x <= grid; ++x)
+      {
+        Vertex v{};
+        v.uv = {float(x) / float(grid), float(y) / float(grid)};
+        v.pos = v.uv * 0.2f + glm::vec2(unit(rng), unit(rng));
+        v.color = glm::vec3(1.0f);
+        const float w = weight(rng);
+        v.bone = {0, 1};
+        v.weight = {w, 1.0f - w};
+        m.verts.push_back(v);
+      }
+    }
+    for (int y = 0; y < grid; ++y)
+    {
+      for (int x = 0; x < grid; ++x)
+      {
+        const uint32_t a = uint32_t(y * (grid + 1) + x), b = a + 1, c = a + uint32_t(grid + 1), d = c + 1;
+        m.indices.insert(m.indices.end(), {a, b, c, b, d, c});
+      }
+    }
+    if (i % 4 == 1)
+      m.regions = kMeshRegionEyeLeft | kMeshRegionFace;
+    else if (i % 4 == 2)
+      m.regions = kMeshRegionMouth | kMeshRegionFace;
+    if (i == meshCount - 1 && i > 0)
+      m.clipping_mask_id = "mesh_0";
+    model.meshes.emplace(m.id, std::move(m));
+  }
+  buildSkinStreams(model);
+  model.buildDeformerTree();
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+  int warmupFrames = 120;
+  int frames = 300;
+  int meshCount = 48;
+  int grid = 24;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help")
+    {
+      printUsage(argv[0]);
+      return 0;
+    }
+
+    std::string value;
+    if (parseOptionValue(arg, "warmup", value))
+    {
+      warmupFrames = std::atoi(value.c_str());
+      continue;
+    }
+    if (parseOptionValue(arg, "frames", value) || parseShortOptionValue(arg, "n", value))
+    {
+      frames = std::atoi(value.c_str());
+      continue;
+    }
+    if (parseOptionValue(arg, "meshes", value))
+    {
+      meshCount = std::atoi(value.c_str());
+      continue;
+    }
+    if (parseOptionValue(arg, "grid", value))
+    {
+      grid = std::atoi(value.c_str());
+      continue;
+    }
+    if ((arg == "-n" || arg == "--frames") && i + 1 < argc)
+    {
+      frames = std::atoi(argv[++i]);
+      continue;
+    }
+
+    std::cerr << "Unknown option: " << arg << "\n";
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  if (warmupFrames < 0 || frames <= 0 || meshCount <= 0 || grid <= 0)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (!heapAllocationCountingEnabled())
+  {
+    std::cerr << "Heap allocation counting is not available on this platform\n";
+    return kSkipped;
+  }
+
+  installNullGL();
+  Engine eng;
+  if (!eng.initGL())
+    return 1;
+  eng.meshArena.initStreaming(nullptr, false);
+  eng.createCheckerTexture("tex_checker", 64, 64);
+  makeSyntheticModel(eng.model, meshCount, grid);
+  eng.buildGLMeshes();
+  eng.resetSprings();
+
+  // A deformer that moves every frame, so CPU-skinned meshes are re-skinned and streamed each frame.
+  Deformer &swayDeformer = eng.model.deformers.at("def_1");
+  constexpr float kFrameSeconds = 1.0f / 60.0f;
+  int frameIndex = 0;
+  auto frame = [&]()
+  {
+    swayDeformer.rot_deg = 5.0f * std::sin(float(frameIndex++) * 0.1f);
+    eng.update(kFrameSeconds);
+    eng.render(1280, 720);
+  };
+
+  int exitCode = 0;
+  for (bool gpuSkinning : {false, true})
+  {
+    eng.gpuSkinning = gpuSkinning;
+    for (int i = 0; i < warmupFrames; ++i)
+      frame();
+
+    int allocatingFrames = 0;
+    uint64_t allocations = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+      const uint64_t before = heapAllocationCount();
+      frame();
+      const uint64_t frameAllocs = heapAllocationCount() - before;
+      allocations += frameAllocs;
+      allocatingFrames += frameAllocs > 0;
+    }
+    std::cout << (gpuSkinning ? "GPU" : "CPU") << " skinning: " << eng.updateStats.active << " meshes, "
+              << eng.renderStats.drawCalls << " draw calls, " << allocations << " allocations in "
+              << allocatingFrames << " of " << frames << " frames\n";
+    if (allocations > 0)
+      exitCode = 1;
+  }
+  if (exitCode != 0)
+    std::cerr << "update()/render() allocated after warm-up\n";
+  return exitCode;
+}
@@ -0,0 +1,82 @@
+#include "alloc_counter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(LITE2D_COUNT_ALLOCATIONS) && LITE2D_COUNT_ALLOCATIONS && !defined(_WIN32)
+#define LITE2D_ALLOC_COUNTER_ACTIVE 1
+#endif
+
+#if defined(LITE2D_ALLOC_COUNTER_ACTIVE)
+namespace
+{
+std::atomic<uint64_t> allocationCount{0};
+
+void *countedMalloc(std::size_t n)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(n ? n : 1);
+}
+
+void *countedAlignedAlloc(std::size_t n, std::align_val_t al)
+{
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t align = std::max(static_cast<std::size_t>(al), sizeof(void *));
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  const std::size_t size = ((n ? n : 1) + align - 1) & ~(align - 1);
+  return std::aligned_alloc(align, size);
+}
+
+void *throwingMalloc(std::size_t n)
+{
+  void *p = countedMalloc(n);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *throwingAlignedAlloc(std::size_t n, std::align_val_t al)
+{
+  void *p = countedAlignedAlloc(n, al);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+} // namespace
+
+void *operator new(std::size_t n) { return throwingMalloc(n); }
+void *operator new[](std::size_t n) { return throwingMalloc(n); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return countedMalloc(n); }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return countedMalloc(n); }
+void *operator new(std::size_t n, std::align_val_t al) { return throwingAlignedAlloc(n, al); }
+void *operator new[](std::size_t n, std::align_val_t al) { return throwingAlignedAlloc(n, al); }
+void *operator new(std::size_t n, std::align_val_t al, const std::nothrow_t &) noexcept
+{
+  return countedAlignedAlloc(n, al);
+}
+void *operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t &) noexcept
+{
+  return countedAlignedAlloc(n, al);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+
+bool heapAllocationCountingEnabled() { return true; }
+uint64_t heapAllocationCount() { return allocationCount.load(std::memory_order_relaxed); }
+#else
+bool heapAllocationCountingEnabled() { return false; }
+uint64_t heapAllocationCount() { return 0; }
+#endif
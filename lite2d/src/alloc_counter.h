@@ -0,0 +1,18 @@
+#ifndef __LITE2D_ALLOC_COUNTER_H__
+#pragma once
+#define __LITE2D_ALLOC_COUNTER_H__
+
+#include <cstdint>
+
+// ---------- Global heap allocation counter ----------
+//
+// Built with LITE2D_COUNT_ALLOCATIONS (CMake option of the same name), the library replaces the
+// global operator new/delete and counts every allocation, so the viewer can check that the
+// steady-state frame loop never touches the heap (--check-allocs). Otherwise the count stays 0.
+
+bool heapAllocationCountingEnabled();
+
+// Global operator new calls (all forms) since process start.
+uint64_t heapAllocationCount();
+
+#endif  // __LITE2D_ALLOC_COUNTER_H__
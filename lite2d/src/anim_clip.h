@@ -8,6 +8,7 @@
 #include <glm/glm.hpp>
 
 #include "easing.h"
+#include "param_store.h"
 
 /**
  * Represents a keyframe that used in animation track.
@@ -26,11 +27,13 @@ struct Keyframe
  * Represents an animation track that animates a single parameter.
  * @param param_id The ID of the parameter to animate.
  * @param keys The keyframes in the track.
+ * @param param Handle of param_id in the owning model's parameters (set by Model::bindParams).
  */
 struct Track
 {
   std::string param_id;
   std::vector<Keyframe> keys;
+  ParamHandle param = kInvalidParam;
 
   float sample(float time, float fallback) const;
 };
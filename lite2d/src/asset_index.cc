@@ -0,0 +1,237 @@
+#include "asset_index.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+namespace
+{
+constexpr const char *kIndexHeader = "lite2d-asset-index 1";
+
+std::mutex indexMutex;
+std::unordered_map<std::string, std::shared_ptr<const AssetIndex>> indexCache;
+
+int64_t directoryMtime(const std::filesystem::path &dir)
+{
+  std::error_code ec;
+  const auto t = std::filesystem::last_write_time(dir, ec);
+  return ec ? INT64_MIN : static_cast<int64_t>(t.time_since_epoch().count());
+}
+
+// A directory gains or loses entries only by changing its own mtime, so checking every directory
+// in the tree is enough to know the file list is still accurate.
+bool isIndexCurrent(const AssetIndex &index)
+{
+  for (const auto &d : index.directories)
+  {
+    if (directoryMtime(index.root / d.relPath) != d.mtime)
+      return false;
+  }
+  return true;
+}
+
+// Derives the lookup tables from the file list.
+void finalizeIndex(AssetIndex &index)
+{
+  index.byFilename.reserve(index.files.size());
+  for (size_t i = 0; i < index.files.size(); ++i)
+  {
+    const auto &rel = index.files[i];
+    std::string name = rel.filename().string();
+    index.byFilename.try_emplace(name, i);
+
+    if (name.rfind("texture_", 0) != 0)
+      continue;
+    size_t dot = name.find_last_of('.');
+    if (dot == std::string::npos || dot <= 8)
+      continue;
+    try
+    {
+      int texIndex = std::stoi(name.substr(8, dot - 8));
+      index.indexedTextures[texIndex] = rel;
+    }
+    catch (...)
+    {
+    }
+  }
+}
+
+AssetIndex scanDirectory(const std::filesystem::path &root)
+{
+  AssetIndex index;
+  index.root = root;
+  index.directories.push_back({std::filesystem::path(), directoryMtime(root)});
+
+  std::error_code ec;
+  auto it = std::filesystem::recursive_directory_iterator(
+      root, std::filesystem::directory_options::skip_permission_denied, ec);
+  for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+  {
+    std::error_code typeEc;
+    if (it->is_directory(typeEc) && !it->is_symlink(typeEc))
+    {
+      index.directories.push_back({it->path().lexically_relative(root), directoryMtime(it->path())});
+      continue;
+    }
+    if (it->is_regular_file(typeEc))
+      index.files.push_back(it->path().lexically_relative(root));
+  }
+  if (ec)
+    std::cerr << "Asset index scan of " << root << " stopped early: " << ec.message() << "\n";
+  finalizeIndex(index);
+  return index;
+}
+
+// Where the persisted index of root lives. Kept out of the asset tree so writing it does not touch
+// the directory mtimes it records, and so read-only asset libraries still get an index.
+std::filesystem::path persistedIndexPath(const std::filesystem::path &root)
+{
+  std::filesystem::path cacheDir;
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+    cacheDir = xdg;
+  else if (const char *home = std::getenv("HOME"); home && *home)
+    cacheDir = std::filesystem::path(home) / ".cache";
+  else if (const char *local = std::getenv("LOCALAPPDATA"); local && *local)
+    cacheDir = local;
+  else
+  {
+    std::error_code ec;
+    cacheDir = std::filesystem::temp_directory_path(ec);
+    if (ec)
+      return {};
+  }
+
+  uint64_t h = 1469598103934665603ull;
+  for (unsigned char c : root.string())
+  {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.idx", static_cast<unsigned long long>(h));
+  return cacheDir / "lite2d" / "assets" / name;
+}
+
+bool readPersistedIndex(const std::filesystem::path &indexPath, const std::filesystem::path &root, AssetIndex &out)
+{
+  std::ifstream ifs(indexPath, std::ios::binary);
+  if (!ifs)
+    return false;
+  std::string line;
+  if (!std::getline(ifs, line) || line != kIndexHeader)
+    return false;
+  if (!std::getline(ifs, line) || line != "R " + root.generic_string())
+    return false;
+
+  AssetIndex index;
+  index.root = root;
+  while (std::getline(ifs, line))
+  {
+    if (line.size() < 2 || line[1] != ' ')
+      return false;
+    if (line[0] == 'D')
+    {
+      std::istringstream ss(line.substr(2));
+      AssetIndex::Directory d;
+      std::string rel;
+      if (!(ss >> d.mtime))
+        return false;
+      ss.get();
+      std::getline(ss, rel);
+      d.relPath = std::filesystem::path(rel);
+      index.directories.push_back(std::move(d));
+    }
+    else if (line[0] == 'F')
+    {
+      index.files.push_back(std::filesystem::path(line.substr(2)));
+    }
+    else
+    {
+      return false;
+    }
+  }
+  if (index.directories.empty() || !isIndexCurrent(index))
+    return false;
+  finalizeIndex(index);
+  out = std::move(index);
+  return true;
+}
+
+void writePersistedIndex(const std::filesystem::path &indexPath, const AssetIndex &index)
+{
+  std::error_code ec;
+  std::filesystem::create_directories(indexPath.parent_path(), ec);
+  if (ec)
+    return;
+
+  std::filesystem::path tmpPath = indexPath;
+  tmpPath += ".tmp";
+  {
+    std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+      return;
+    ofs << kIndexHeader << "\n"
+        << "R " << index.root.generic_string() << "\n";
+    for (const auto &d : index.directories)
+      ofs << "D " << d.mtime << " " << d.relPath.generic_string() << "\n";
+    for (const auto &f : index.files)
+    {
+      const std::string rel = f.generic_string();
+      if (rel.find('\n') == std::string::npos)
+        ofs << "F " << rel << "\n";
+    }
+    if (!ofs)
+      return;
+  }
+  std::filesystem::rename(tmpPath, indexPath, ec);
+  if (ec)
+    std::filesystem::remove(tmpPath, ec);
+}
+} // namespace
+
+std::filesystem::path AssetIndex::findFile(const std::string &filename) const
+{
+  auto it = byFilename.find(filename);
+  return it != byFilename.end() ? files[it->second] : std::filesystem::path();
+}
+
+std::shared_ptr<const AssetIndex> getAssetIndex(const std::filesystem::path &dir)
+{
+  static const auto empty = std::make_shared<const AssetIndex>();
+  std::error_code ec;
+  if (!std::filesystem::is_directory(dir, ec))
+    return empty;
+  const std::filesystem::path root = std::filesystem::absolute(dir, ec).lexically_normal();
+  if (ec)
+    return empty;
+  const std::string key = root.string();
+
+  {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    auto it = indexCache.find(key);
+    if (it != indexCache.end() && isIndexCurrent(*it->second))
+      return it->second;
+  }
+
+  const std::filesystem::path indexPath = persistedIndexPath(root);
+  auto index = std::make_shared<AssetIndex>();
+  if (indexPath.empty() || !readPersistedIndex(indexPath, root, *index))
+  {
+    *index = scanDirectory(root);
+    if (!indexPath.empty())
+      writePersistedIndex(indexPath, *index);
+  }
+
+  std::lock_guard<std::mutex> lock(indexMutex);
+  indexCache[key] = index;
+  return index;
+}
+
+void clearAssetIndexCache()
+{
+  std::lock_guard<std::mutex> lock(indexMutex);
+  indexCache.clear();
+}
@@ -0,0 +1,47 @@
+#ifndef __LITE2D_ASSET_INDEX_H__
+#pragma once
+#define __LITE2D_ASSET_INDEX_H__
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Snapshot of every regular file below a model directory, used to resolve textures without walking
+ * the tree on each load. All stored paths are relative to root; join them with the directory the
+ * caller asked for.
+ * @param root Absolute directory the index was built for.
+ * @param directories Every directory in the tree (root first) with the mtime it had when indexed.
+ * @param files Regular files in directory-iteration order, relative to root.
+ * @param byFilename File name -> first matching entry in files.
+ * @param indexedTextures N -> the last texture_N.* file found, relative to root.
+ */
+struct AssetIndex
+{
+  struct Directory
+  {
+    std::filesystem::path relPath;
+    int64_t mtime = 0;
+  };
+
+  std::filesystem::path root;
+  std::vector<Directory> directories;
+  std::vector<std::filesystem::path> files;
+  std::unordered_map<std::string, size_t> byFilename;
+  std::unordered_map<int, std::filesystem::path> indexedTextures;
+
+  // Relative path of the first file named filename below root, or empty.
+  std::filesystem::path findFile(const std::string &filename) const;
+};
+
+// Returns the index for dir, reusing the in-memory or on-disk copy while no directory mtime in the
+// tree has changed. Returns an empty index if dir is not a directory.
+std::shared_ptr<const AssetIndex> getAssetIndex(const std::filesystem::path &dir);
+
+// Drops the in-memory indexes; the next getAssetIndex() reads the persisted copy again.
+void clearAssetIndexCache();
+
+#endif  // __LITE2D_ASSET_INDEX_H__
@@ -0,0 +1,145 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "engine.h"
+#include "model_binary.h"
+#include "model_loader.h"
+#include "sidecar_manifest.h"
+
+// ---------- lite2d_compile: .moc3.json (+ sidecars) -> .lite2d ----------
+
+static void printUsage(const char *argv0)
+{
+  std::cerr << "Usage: " << argv0 << " [options]\n"
+            << "Options:\n"
+            << "  -m, --moc3=FILE             Path to .moc3.json (required)\n"
+            << "  -r, --render-settings=FILE  Path to .moc3.render-settings.json\n"
+            << "  -p, --parts=FILE            Path to .moc3.parts.json\n"
+            << "  -o, --output=FILE           Output .lite2d path (default: next to the .moc3.json)\n"
+            << "  -a, --acmr-report           Print vertex cache ACMR before/after optimization per mesh\n"
+            << "      --no-optimize           Keep the exporter's triangle and vertex order\n"
+            << "  -h, --help                  Show this help\n";
+}
+
+static bool parseOptionValue(const std::string &arg, const std::string &longName, std::string &out)
+{
+  const std::string prefix = "--" + longName + "=";
+  if (arg.rfind(prefix, 0) == 0)
+  {
+    out = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+static bool parseShortOptionValue(const std::string &arg, const std::string &shortName, std::string &out)
+{
+  const std::string prefix = "-" + shortName + "=";
+  if (arg.rfind(prefix, 0) == 0)
+  {
+    out = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+int main(int argc, char **argv)
+{
+  std::filesystem::path moc3JsonPath;
+  std::filesystem::path renderSettingsPath;
+  std::filesystem::path partsPath;
+  std::filesystem::path outputPath;
+  ModelLoadOptions loadOptions;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help")
+    {
+      printUsage(argv[0]);
+      return 0;
+    }
+    if (arg == "-a" || arg == "--acmr-report")
+    {
+      loadOptions.reportAcmr = true;
+      continue;
+    }
+    if (arg == "--no-optimize")
+    {
+      loadOptions.optimizeMeshes = false;
+      continue;
+    }
+
+    std::string value;
+    if (parseOptionValue(arg, "moc3", value) || parseShortOptionValue(arg, "m", value))
+    {
+      moc3JsonPath = value;
+      continue;
+    }
+    if (parseOptionValue(arg, "render-settings", value) || parseShortOptionValue(arg, "r", value))
+    {
+      renderSettingsPath = value;
+      continue;
+    }
+    if (parseOptionValue(arg, "parts", value) || parseShortOptionValue(arg, "p", value))
+    {
+      partsPath = value;
+      continue;
+    }
+    if (parseOptionValue(arg, "output", value) || parseShortOptionValue(arg, "o", value))
+    {
+      outputPath = value;
+      continue;
+    }
+
+    if ((arg == "-m" || arg == "--moc3") && i + 1 < argc)
+    {
+      moc3JsonPath = argv[++i];
+      continue;
+    }
+    if ((arg == "-r" || arg == "--render-settings") && i + 1 < argc)
+    {
+      renderSettingsPath = argv[++i];
+      continue;
+    }
+    if ((arg == "-p" || arg == "--parts") && i + 1 < argc)
+    {
+      partsPath = argv[++i];
+      continue;
+    }
+    if ((arg == "-o" || arg == "--output") && i + 1 < argc)
+    {
+      outputPath = argv[++i];
+      continue;
+    }
+
+    std::cerr << "Unknown option: " << arg << "\n";
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  if (moc3JsonPath.empty())
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (outputPath.empty())
+    outputPath = getCompiledModelPath(moc3JsonPath);
+
+  // The loader only touches the model; no GL context is needed here.
+  Engine eng;
+  std::unordered_map<std::string, std::filesystem::path> drawableTextures;
+  if (!loadModelFromMoc3Json(moc3JsonPath, eng, drawableTextures, renderSettingsPath, partsPath, loadOptions))
+  {
+    std::cerr << "Failed to load " << moc3JsonPath << "\n";
+    return 1;
+  }
+
+  if (!writeModelBinary(outputPath, eng.model, eng.canvas, drawableTextures,
+                        renderSettingsPath.empty() ? getRenderSettingsPath(moc3JsonPath) : renderSettingsPath,
+                        partsPath.empty() ? getPartsPath(moc3JsonPath) : partsPath))
+    return 1;
+  return 0;
+}
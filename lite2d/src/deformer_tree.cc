@@ -0,0 +1,99 @@
+#include "deformer_tree.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DeformerTree::build(const std::unordered_map<std::string, Deformer> &deformers)
+{
+  clear();
+  ++builds;
+  ids.reserve(deformers.size());
+  sources.reserve(deformers.size());
+  parents.reserve(deformers.size());
+  index.reserve(deformers.size());
+
+  // Roots in id order, so the layout does not depend on the map's iteration order.
+  std::vector<const Deformer *> roots;
+  for (const auto &kv : deformers)
+  {
+    if (kv.second.parent.empty())
+      roots.push_back(&kv.second);
+  }
+  std::sort(roots.begin(), roots.end(), [](const Deformer *a, const Deformer *b) { return a->id < b->id; });
+
+  // Depth first through the children lists; children are pushed in reverse to come out in list order.
+  std::vector<std::pair<const Deformer *, int32_t>> stack;
+  for (auto it = roots.rbegin(); it != roots.rend(); ++it)
+    stack.emplace_back(*it, kNone);
+  while (!stack.empty())
+  {
+    const auto [d, parent] = stack.back();
+    stack.pop_back();
+    const int32_t i = static_cast<int32_t>(ids.size());
+    if (!index.emplace(d->id, i).second)
+      continue; // listed as the child of more than one deformer; the first parent reached wins
+    ids.push_back(d->id);
+    parents.push_back(parent);
+    sources.push_back(d);
+    for (auto it = d->children.rbegin(); it != d->children.rend(); ++it)
+    {
+      auto itChild = deformers.find(*it);
+      if (itChild != deformers.end())
+        stack.emplace_back(&itChild->second, i);
+    }
+  }
+
+  keys.resize(ids.size());
+  locals.resize(ids.size());
+  worlds.resize(ids.size());
+  dirty.assign(ids.size(), 0);
+  primed = false;
+}
+
+void DeformerTree::clear()
+{
+  ids.clear();
+  parents.clear();
+  sources.clear();
+  keys.clear();
+  locals.clear();
+  worlds.clear();
+  dirty.clear();
+  index.clear();
+  primed = false;
+}
+
+size_t DeformerTree::update()
+{
+  size_t recomputed = 0;
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    const Deformer &d = *sources[i];
+    LocalKey &key = keys[i];
+    bool changed = !primed || d.pos != key.pos || d.rot_deg != key.rotDeg || d.scale != key.scale;
+    if (changed)
+    {
+      key = LocalKey{d.pos, d.rot_deg, d.scale};
+      // T * R * S, written out.
+      const float r = glm::radians(d.rot_deg);
+      const float c = std::cos(r), s = std::sin(r);
+      locals[i] = glm::mat3(c * d.scale.x, s * d.scale.x, 0, -s * d.scale.y, c * d.scale.y, 0, d.pos.x, d.pos.y, 1);
+    }
+    const int32_t p = parents[i];
+    if (p != kNone)
+      changed = changed || dirty[p];
+    dirty[i] = changed;
+    if (!changed)
+      continue;
+    worlds[i] = p == kNone ? locals[i] : worlds[p] * locals[i];
+    ++recomputed;
+  }
+  primed = true;
+  return recomputed;
+}
+
+int32_t DeformerTree::find(const std::string &id) const
+{
+  auto it = index.find(id);
+  return it == index.end() ? kNone : it->second;
+}
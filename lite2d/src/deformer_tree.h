@@ -0,0 +1,65 @@
+#ifndef __LITE2D_DEFORMER_TREE_H__
+#pragma once
+#define __LITE2D_DEFORMER_TREE_H__
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "deformer.h"
+
+/**
+ * The deformer hierarchy flattened for per-frame evaluation. Deformers are stored depth first from
+ * the roots, so every parent comes before its children and world matrices follow in one linear
+ * pass. Local transforms are still read from the Deformer entries the tree was built from; only
+ * deformers whose transform changed, and their descendants, are recomputed.
+ * Deformers that cannot be reached from a root get no index and have no world matrix.
+ * The tree points into the map it was built from: rebuild it after adding, removing or replacing
+ * deformers.
+ */
+class DeformerTree
+{
+public:
+  static constexpr int32_t kNone = -1;
+
+  void build(const std::unordered_map<std::string, Deformer> &deformers);
+  void clear();
+
+  // Brings the world matrices up to date; returns how many were recomputed.
+  size_t update();
+
+  // Index of deformer id, or kNone.
+  int32_t find(const std::string &id) const;
+  size_t size() const { return ids.size(); }
+  const std::string &id(int32_t i) const { return ids[i]; }
+  int32_t parentOf(int32_t i) const { return parents[i]; }
+  const glm::mat3 &world(int32_t i) const { return worlds[i]; }
+  std::span<const glm::mat3> worldMatrices() const { return worlds; }
+  // Changes with every build(), when indices may have moved.
+  uint32_t generation() const { return builds; }
+
+private:
+  // Local transform inputs the cached matrix was computed from.
+  struct LocalKey
+  {
+    glm::vec2 pos{0.0f};
+    float rotDeg = 0.0f;
+    glm::vec2 scale{1.0f};
+  };
+
+  std::vector<std::string> ids;
+  std::vector<int32_t> parents;            // kNone for roots
+  std::vector<const Deformer *> sources;   // entries of the map passed to build()
+  std::vector<LocalKey> keys;
+  std::vector<glm::mat3> locals, worlds;
+  std::vector<uint8_t> dirty;              // world recomputed by the last update()
+  std::unordered_map<std::string, int32_t> index;
+  bool primed = false;                     // false until the first update() after build()
+  uint32_t builds = 0;
+};
+
+#endif  // __LITE2D_DEFORMER_TREE_H__
@@ -2,11 +2,15 @@
 
 #include <iostream>
 #include <cmath>
-#include <cctype>
-#include <initializer_list>
+#include <cstring>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "debug.h"
+#include "keyforms.h"
+#include "load_profile.h"
+#include "mesh_pose.h"
+#include "mesh_regions.h"
 
 /**
  * Initialize OpenGL state and compile shader.
@@ -19,27 +23,59 @@ bool Engine::initGL()
   }
 
   const char *vs = R"(#version 330 core
-        layout(location=0) in vec2 aPos;
-        layout(location=1) in vec2 aUV;
-        layout(location=2) in vec3 aColor;
+        layout(location=0) in vec2 aPos;      // 16-bit unorm within the mesh bounds (CPU-skinned)
+        layout(location=1) in vec2 aUV;       // 16-bit unorm within the mesh UV range
+        layout(location=2) in vec3 aColor;    // per vertex, unless the mesh's color is constant
+        layout(location=3) in uint aSlot;     // the mesh's rows in uDrawData
+        layout(location=4) in vec2 aRest;     // 16-bit unorm within the mesh rest bounds
+        layout(location=5) in uvec2 aBones;   // deformer tree indices into uBones
+        layout(location=6) in vec2 aWeights;
         uniform mat4 uMVP;
+        uniform samplerBuffer uDrawData;      // per mesh: pos, UV and rest decode (origin.xy, extent.zw),
+                                              // (opacity, GPU-skinned 1 or -1, constant color 0xBBGGRR,
+                                              // 1 if constant), pose (a, b, c, d), (tx, ty)
+        uniform samplerBuffer uBones;         // per deformer, then the zero bone: (a, b, c, d), (tx, ty)
         out vec2 vUV;
-        out vec3 vColor;
+        out vec4 vColor;
+        vec2 transform(vec4 m, vec2 t, vec2 p) {
+            return vec2(m.x * p.x + m.z * p.y + t.x, m.y * p.x + m.w * p.y + t.y);
+        }
         void main() {
-            gl_Position = uMVP * vec4(aPos, 0.0, 1.0);
-            vUV = aUV;
-            vColor = aColor;
+            int row = int(aSlot) * 6;
+            vec4 misc = texelFetch(uDrawData, row + 3);
+            vec2 pos;
+            if (misc.y < 0.0) {
+                vec4 posDecode = texelFetch(uDrawData, row);
+                pos = posDecode.xy + aPos * posDecode.zw;
+            } else {
+                // Blend the two bones, skin the rest position, then apply the mesh's pose.
+                vec4 restDecode = texelFetch(uDrawData, row + 2);
+                int b0 = int(aBones.x) * 2;
+                int b1 = int(aBones.y) * 2;
+                vec4 m = aWeights.x * texelFetch(uBones, b0) + aWeights.y * texelFetch(uBones, b1);
+                vec2 t = aWeights.x * texelFetch(uBones, b0 + 1).xy + aWeights.y * texelFetch(uBones, b1 + 1).xy;
+                vec2 skinned = transform(m, t, restDecode.xy + aRest * restDecode.zw);
+                pos = transform(texelFetch(uDrawData, row + 4), texelFetch(uDrawData, row + 5).xy, skinned);
+            }
+            gl_Position = uMVP * vec4(pos, 0.0, 1.0);
+            vec4 uvDecode = texelFetch(uDrawData, row + 1);
+            vUV = uvDecode.xy + aUV * uvDecode.zw;
+            vec3 color = aColor;
+            if (misc.w > 0.5) {
+                uint rgb = uint(misc.z);
+                color = vec3(uvec3(rgb, rgb >> 8u, rgb >> 16u) & 0xFFu) / 255.0;
+            }
+            vColor = vec4(color, misc.x);
         })";
 
   const char *fs = R"(#version 330 core
         in vec2 vUV;
-        in vec3 vColor;
+        in vec4 vColor;
         uniform sampler2D uTex;
-        uniform float uOpacity;
         out vec4 FragColor;
         void main() {
             vec4 tex = texture(uTex, vUV);
-            FragColor = vec4(vColor, uOpacity) * tex;
+            FragColor = vColor * tex;
         })";
 
   if (!shader.compile(vs, fs))
@@ -83,12 +119,239 @@ bool Engine::initGL()
 
 void Engine::buildGLMeshes()
 {
+  // Hidden meshes stay CPU-only until they are shown; update() uploads them then.
+  LoadPhaseScope phase("gl_upload");
+  refreshActiveMasks();
+  size_t packedBytes = 0, floatBytes = 0;
+  // Size the arena for every mesh, hidden ones included, rather than growing it mesh by mesh.
+  size_t vertices = 0, indexBytes = 0;
+  for (const auto &kv : model.meshes)
+  {
+    vertices += kv.second.verts.size();
+    indexBytes += kv.second.indices.size() * GLMesh::indexSize(GLMesh::indexTypeFor(kv.second.verts.size())) + 2;
+  }
+  meshArena.reserve(vertices, indexBytes);
   for (auto &kv : model.meshes)
   {
+    if (!isMeshActive(kv.second))
+      continue;
     GLMesh gm;
-    gm.create(kv.second);
-    glmeshes[kv.first] = gm;
+    gm.create(kv.second, model.deformerTree, meshArena);
+    packedBytes += gm.vertexBytes();
+    floatBytes += gm.vertCount * 7 * sizeof(float);
+    glmeshes[kv.first] = std::move(gm);
+  }
+  meshLinksDirty = true;
+  drawListDirty = true;
+  phase.setItems(packedBytes);
+  phase.end();
+  std::cerr << "GL meshes: " << glmeshes.size() << " resident, " << packedBytes / 1024 << " KB vertex data ("
+            << floatBytes / 1024 << " KB as float)\n";
+}
+
+void Engine::refreshMeshLinks()
+{
+  if (!meshLinksDirty)
+    return;
+  meshLinks.clear();
+  meshLinks.reserve(model.meshes.size());
+  for (auto &kv : model.meshes)
+  {
+    MeshLinks links;
+    links.key = &kv.first;
+    links.mesh = &kv.second;
+    if (!kv.second.clipping_mask_id.empty())
+    {
+      auto itMask = model.meshes.find(kv.second.clipping_mask_id);
+      links.mask = itMask == model.meshes.end() ? nullptr : &itMask->second;
+    }
+    auto itGL = glmeshes.find(kv.first);
+    links.gl = itGL == glmeshes.end() ? nullptr : &itGL->second;
+    meshLinks.push_back(links);
+  }
+  meshLinksDirty = false;
+}
+
+void Engine::refreshActiveMasks()
+{
+  refreshMeshLinks();
+  size_t count = 0;
+  visibleMeshes = 0;
+  for (const MeshLinks &links : meshLinks)
+  {
+    visibleMeshes += links.mesh->visible;
+    if (links.mesh->visible && links.mask)
+      ++count;
+  }
+  auto masks = frameArena.allocate<const ArtMesh *>(count);
+  count = 0;
+  for (const MeshLinks &links : meshLinks)
+  {
+    if (links.mesh->visible && links.mask)
+      masks[count++] = links.mask;
+  }
+  std::sort(masks.begin(), masks.end());
+  activeMasks = masks.first(std::unique(masks.begin(), masks.end()) - masks.begin());
+}
+
+bool Engine::isMeshActive(const ArtMesh &m) const
+{
+  return m.visible || std::binary_search(activeMasks.begin(), activeMasks.end(), &m);
+}
+
+void Engine::refreshDrawList()
+{
+  // Every listed mesh still visible and as many visible meshes as listed: no mesh was shown or hidden.
+  bool resort = false;
+  if (!drawListDirty)
+  {
+    drawListDirty = drawList.size() != visibleMeshes;
+    for (size_t i = 0; i < drawList.size() && !drawListDirty; ++i)
+    {
+      DrawItem &d = drawList[i];
+      drawListDirty = !d.mesh->visible;
+      if (drawOrderOfKey(d.key) != d.mesh->draw_order)
+      {
+        d.key = drawSortKey(d.mesh->draw_order, uint32_t(d.key));
+        resort = true;
+      }
+    }
+  }
+
+  if (drawListDirty)
+  {
+    drawList.clear();
+    uint32_t tie = 0;
+    for (const auto &kv : model.meshes)
+    {
+      if (!kv.second.visible)
+        continue;
+      DrawItem d;
+      d.mesh = &kv.second;
+      d.key = drawSortKey(kv.second.draw_order, tie++);
+      auto itTex = textures.find(kv.second.texture_id);
+      d.texture = itTex == textures.end() ? 0 : itTex->second.id;
+      drawList.push_back(d);
+    }
+    std::sort(drawList.begin(), drawList.end(), [](const DrawItem &a, const DrawItem &b) { return a.key < b.key; });
+    drawListDirty = false;
+  }
+  else if (resort)
+  {
+    // Draw orders change a few meshes at a time, so the list is nearly sorted.
+    for (size_t i = 1; i < drawList.size(); ++i)
+    {
+      const DrawItem d = drawList[i];
+      size_t j = i;
+      for (; j > 0 && drawList[j - 1].key > d.key; --j)
+        drawList[j] = drawList[j - 1];
+      drawList[j] = d;
+    }
+  }
+
+  // Meshes shown recently may still be waiting for their upload, or their mask's.
+  for (DrawItem &d : drawList)
+  {
+    if (!d.gl)
+    {
+      auto itGL = glmeshes.find(d.mesh->id);
+      d.gl = itGL == glmeshes.end() ? nullptr : &itGL->second;
+    }
+    if (!d.mask && !d.mesh->clipping_mask_id.empty())
+    {
+      auto itMask = glmeshes.find(d.mesh->clipping_mask_id);
+      d.mask = itMask == glmeshes.end() ? nullptr : &itMask->second;
+    }
+    if (!d.texture)
+    {
+      auto itTex = textures.find(d.mesh->texture_id);
+      d.texture = itTex == textures.end() ? 0 : itTex->second.id;
+    }
+  }
+}
+
+static bool sameGeometry(const ArtMesh &a, const ArtMesh &b)
+{
+  if (a.verts.size() != b.verts.size() || a.indices.size() != b.indices.size())
+    return false;
+  if (!a.verts.empty() && std::memcmp(a.verts.data(), b.verts.data(), a.verts.size() * sizeof(Vertex)) != 0)
+    return false;
+  return a.indices.empty() || std::memcmp(a.indices.data(), b.indices.data(), a.indices.size() * sizeof(uint32_t)) == 0;
+}
+
+static bool sameProperties(const ArtMesh &a, const ArtMesh &b)
+{
+  return a.texture_id == b.texture_id && a.clipping_mask_id == b.clipping_mask_id && a.draw_order == b.draw_order
+         && a.blend_mode == b.blend_mode && a.opacity == b.opacity && a.visible == b.visible
+         && a.deformers == b.deformers && a.regions == b.regions && a.keyforms == b.keyforms;
+}
+
+ModelReloadStats Engine::applyModelReload(Model &&next)
+{
+  ModelReloadStats stats;
+  for (const auto &kv : model.meshes)
+  {
+    if (!next.meshes.count(kv.first))
+      ++stats.removed;
+  }
+  for (auto it = glmeshes.begin(); it != glmeshes.end();)
+  {
+    if (next.meshes.count(it->first))
+    {
+      ++it;
+      continue;
+    }
+    it->second.destroy();
+    it = glmeshes.erase(it);
   }
+
+  // New and changed meshes are only dropped here; update() uploads them once they are drawn.
+  for (auto &kv : next.meshes)
+  {
+    auto itOld = model.meshes.find(kv.first);
+    if (itOld == model.meshes.end())
+    {
+      ++stats.added;
+      continue;
+    }
+    if (!sameGeometry(itOld->second, kv.second))
+    {
+      if (auto itGL = glmeshes.find(kv.first); itGL != glmeshes.end())
+      {
+        itGL->second.destroy();
+        glmeshes.erase(itGL);
+      }
+      ++stats.rebuilt;
+    }
+    else if (!sameProperties(itOld->second, kv.second))
+    {
+      // GLMeshSource only tracks keyform weights, not the offsets: recompute the positions.
+      if (auto itGL = glmeshes.find(kv.first); itGL != glmeshes.end())
+        itGL->second.source.valid = false;
+      ++stats.updated;
+    }
+    else
+    {
+      ++stats.unchanged;
+    }
+  }
+
+  model.meshes = std::move(next.meshes);
+  model.deformers = std::move(next.deformers);
+  activeMasks = {};
+  meshLinksDirty = true;
+  drawListDirty = true;
+  model.mesh_face_parts = std::move(next.mesh_face_parts);
+  model.mesh_body_parts = std::move(next.mesh_body_parts);
+  model.mesh_seam_parts = std::move(next.mesh_seam_parts);
+  model.drawable_sources = std::move(next.drawable_sources);
+  // Appending keeps every existing handle (and the springs and tracks bound to it) valid.
+  for (size_t h = 0; h < next.params.size(); ++h)
+    model.params.add(next.params.ids[h], next.params.min[h], next.params.max[h], next.params.def[h]);
+  // Keyform axes of the new meshes are not bound to this model's handles yet.
+  model.bindParams();
+  model.buildDeformerTree();
+  return stats;
 }
 
 void Engine::createCheckerTexture(const std::string &id, int w, int h)
@@ -118,25 +381,61 @@ void Engine::createCheckerTexture(const std::string &id, int w, int h)
   textures[id] = t;
 }
 
+void Engine::bindParams()
+{
+  model.ensureParamsBound();
+  const ParamStore &params = model.params;
+  if (paramHandles.layout == params.layoutVersion())
+    return;
+  EngineParamHandles &h = paramHandles;
+  h.angleX = params.find("ParamAngleX");
+  h.angleY = params.find("ParamAngleY");
+  h.angleZ = params.find("ParamAngleZ");
+  h.eyeLOpen = params.find("ParamEyeLOpen");
+  h.eyeROpen = params.find("ParamEyeROpen");
+  h.mouth = params.find("ParamMouthOpenY");
+  if (h.mouth == kInvalidParam)
+    h.mouth = params.find("ParamMouthOpen");
+  h.mouthForm = params.find("ParamMouthForm");
+  h.browLY = params.find("ParamBrowLY");
+  h.browRY = params.find("ParamBrowRY");
+  h.layout = params.layoutVersion();
+  springs.resize(params.size());
+  exprAccum.assign(params.size(), ExpressionAccum{});
+  // New parameters have no previous step; start them where they are.
+  prevParams.assign(params.cur.begin(), params.cur.end());
+  renderParams.assign(params.cur.begin(), params.cur.end());
+}
+
+void Engine::resetSprings()
+{
+  bindParams();
+  for (size_t h = 0; h < springs.size(); ++h)
+    springs[h].reset(model.params.cur[h]);
+  prevParams.assign(model.params.cur.begin(), model.params.cur.end());
+  renderParams.assign(model.params.cur.begin(), model.params.cur.end());
+}
+
 // Animation sampling
 void Engine::applyAnimation(const AnimationClip &clip, float t)
 {
+  bindParams();
+  ParamStore &params = model.params;
   float localT = std::fmod(t, clip.duration);
   for (const auto &tr : clip.tracks)
   {
-    auto it = model.params.find(tr.param_id);
-    if (it == model.params.end())
+    if (tr.param >= params.size())
       continue;
-    float v = tr.sample(localT, it->second.def_v);
-    it->second.set(v);
+    float v = tr.sample(localT, params.def[tr.param]);
+    params.set(tr.param, v);
   }
 }
 
 // Expressions
 void Engine::applyExpressions(const std::vector<std::pair<std::string, float>> &exprWeights)
 {
-  std::unordered_map<std::string, float> add;
-  std::unordered_map<std::string, std::pair<int, float>> ov;
+  bindParams();
+  ParamStore &params = model.params;
   for (auto &ew : exprWeights)
   {
     auto it = model.expressions.find(ew.first);
@@ -145,89 +444,120 @@ void Engine::applyExpressions(const std::vector<std::pair<std::string, float>> &
     float w = ew.second;
     for (auto &ep : it->second.params)
     {
+      if (ep.param >= exprAccum.size())
+        continue;
+      ExpressionAccum &acc = exprAccum[ep.param];
+      if (acc.flags == 0)
+        exprTouched.push_back(ep.param);
       float val = ep.delta * w;
       if (ep.mode == BlendMode::Additive)
-        add[ep.param_id] += val;
-      else
       {
-        auto cur = ov.find(ep.param_id);
-        if (cur == ov.end() || ep.priority > cur->second.first)
-          ov[ep.param_id] = {ep.priority, val};
+        acc.add += val;
+        acc.flags |= ExpressionAccum::kAdd;
+      }
+      else if (!(acc.flags & ExpressionAccum::kOverride) || ep.priority > acc.priority)
+      {
+        acc.priority = ep.priority;
+        acc.overrideValue = val;
+        acc.flags |= ExpressionAccum::kOverride;
       }
     }
   }
-  for (auto &kv : add)
-  {
-    auto it = model.params.find(kv.first);
-    if (it != model.params.end())
-      it->second.set(it->second.cur_v + kv.second);
-  }
-  for (auto &kv : ov)
+  // Additive deltas first, then overrides, per parameter.
+  for (ParamHandle h : exprTouched)
   {
-    auto it = model.params.find(kv.first);
-    if (it != model.params.end())
-      it->second.set(kv.second.second);
+    ExpressionAccum &acc = exprAccum[h];
+    if (acc.flags & ExpressionAccum::kAdd)
+      params.set(h, params.cur[h] + acc.add);
+    if (acc.flags & ExpressionAccum::kOverride)
+      params.set(h, acc.overrideValue);
+    acc = ExpressionAccum{};
   }
+  exprTouched.clear();
 }
 
 // Deformer world matrices (3x3 2D affine)
 void Engine::computeDeformers()
 {
-  worldM.clear();
-  std::vector<std::string> roots;
-  for (auto &kv : model.deformers)
-    if (kv.second.parent.empty())
-      roots.push_back(kv.first);
-
-  std::function<void(const std::string &)> dfs = [&](const std::string &id)
-  {
-    const auto &d = model.deformers.at(id);
-    glm::mat3 local = glm::mat3(1.0f);
-    float r = glm::radians(d.rot_deg);
-    float c = std::cos(r), s = std::sin(r);
-    glm::mat3 T = glm::mat3(1, 0, 0, 0, 1, 0, d.pos.x, d.pos.y, 1);
-    glm::mat3 R = glm::mat3(c, s, 0, -s, c, 0, 0, 0, 1);
-    glm::mat3 S = glm::mat3(d.scale.x, 0, 0, 0, d.scale.y, 0, 0, 0, 1);
-    local = T * R * S;
-    if (d.parent.empty())
-      worldM[id] = local;
-    else
-      worldM[id] = worldM[d.parent] * local;
-    for (auto &cId : d.children)
-      dfs(cId);
-  };
-  for (auto &r : roots)
-    dfs(r);
+  model.ensureDeformerTree();
+  model.deformerTree.update();
 }
 
-// CPU skinning (2 bones)
+// CPU skinning (up to 2 bones)
 std::vector<glm::vec2> Engine::deformMesh(const ArtMesh &m) const
 {
   std::vector<glm::vec2> out(m.verts.size());
-  for (size_t i = 0; i < m.verts.size(); ++i)
+  deformMesh(m, out);
+  return out;
+}
+
+void Engine::resolveSkinPalette(const ArtMesh &m, std::span<SkinBone> palette) const
+{
+  const DeformerTree &tree = model.deformerTree;
+  const bool resolved = m.deformer_index.size() == m.deformers.size();
+  for (size_t b = 0; b < m.deformers.size(); ++b)
   {
-    const auto &v = m.verts[i];
-    glm::vec2 p = v.pos;
-    glm::vec3 hp{p.x, p.y, 1.0f};
-    glm::vec3 acc{0, 0, 0};
-    for (int j = 0; j < 2; j++)
-    {
-      int boneIdx = v.bone[j];
-      float w = v.weight[j];
-      if (w <= 0)
-        continue;
-      if (boneIdx < 0 || boneIdx >= (int)m.deformers.size())
-        continue;
-      const std::string &did = m.deformers[boneIdx];
-      auto itM = worldM.find(did);
-      if (itM == worldM.end())
-        continue;
-      glm::vec3 tp = itM->second * hp;
-      acc += tp * w;
-    }
-    out[i] = glm::vec2(acc.x, acc.y);
+    // Meshes edited since the last Model::buildDeformerTree fall back to a lookup by id.
+    const int32_t d = resolved ? m.deformer_index[b] : tree.find(m.deformers[b]);
+    palette[b] = d == DeformerTree::kNone ? SkinBone{} : toSkinBone(tree.world(d));
+  }
+  palette.back() = SkinBone{};
+}
+
+void Engine::deformMesh(const ArtMesh &m, std::span<glm::vec2> out) const
+{
+  // Resolve the mesh's bones once; the kernel then only indexes the palette.
+  const size_t mark = frameArena.mark();
+  auto palette = frameArena.allocate<SkinBone>(skinPaletteSize(m));
+  resolveSkinPalette(m, palette);
+  if (m.skin.size() != m.verts.size())
+  {
+    skinVerticesAoS(m, palette, out);
+  }
+  else if (!m.keyforms.empty())
+  {
+    auto weights = frameArena.allocate<float>(m.keyforms.forms.size());
+    computeKeyformWeights(m.keyforms, model.params.cur, weights);
+    auto x = frameArena.allocate<float>(keyformScratchSize(m.verts.size()));
+    auto y = frameArena.allocate<float>(x.size());
+    applyKeyforms(m.keyforms, weights, m.skin, x, y, skinKernel);
+    skinVertices(m.skin, x.first(m.verts.size()), y.first(m.verts.size()), palette, out, skinKernel);
+  }
+  else
+  {
+    skinVertices(m.skin, palette, out, skinKernel);
+  }
+  frameArena.rewind(mark);
+}
+
+void Engine::deformMesh(const ArtMesh &m, const MeshPose &pose, std::span<SkinBone> palette,
+                        std::span<const float> restX, std::span<const float> restY, std::span<glm::vec2> out) const
+{
+  if (m.verts.empty())
+    return;
+  const bool current = m.skin.size() == m.verts.size();
+  if (current && !restX.empty())
+  {
+    // Morphed: the rest hull no longer bounds the mesh.
+    skinVertices(m.skin, restX.first(m.verts.size()), restY.first(m.verts.size()), palette, out, skinKernel);
+    transformPositions(meshPoseTransform(pose, measureSkinBounds(out, pose.rotateDeg)), out);
+  }
+  else if (current && m.skin.kind == SkinKind::Rigid && !m.skin.hull.empty())
+  {
+    // Rigid: the bounds follow from the hull, so the pose folds into the bone and skinning is the only pass.
+    SkinBone &bone = palette[m.skin.rigidBone];
+    bone = composeSkinBones(meshPoseTransform(pose, measureRigidSkinBounds(m.skin, bone, pose.rotateDeg)), bone);
+    skinVertices(m.skin, palette, out, skinKernel);
+  }
+  else
+  {
+    // Skin, measure, transform.
+    if (current)
+      skinVertices(m.skin, palette, out, skinKernel);
+    else
+      skinVerticesAoS(m, palette, out);
+    transformPositions(meshPoseTransform(pose, measureSkinBounds(out, pose.rotateDeg)), out);
   }
-  return out;
 }
 
 glm::mat4 Engine::computeMVP(int fbw, int fbh)
@@ -251,19 +581,6 @@ glm::mat4 Engine::computeMVP(int fbw, int fbh)
   return proj * view * S;
 }
 
-static std::string toLowerCopy(const std::string &value)
-{
-  std::string out = value;
-  for (auto &ch : out)
-    ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
-  return out;
-}
-
-static bool containsToken(const std::string &haystack, const std::string &needle)
-{
-  return haystack.find(needle) != std::string::npos;
-}
-
 static float smoothstep(float edge0, float edge1, float x)
 {
   if (edge0 == edge1)
@@ -273,12 +590,12 @@ static float smoothstep(float edge0, float edge1, float x)
   return t * t * (3.0f - 2.0f * t);
 }
 
-static float computeBlinkOpen(float timeSec)
+static float computeBlinkOpen(double timeSec)
 {
   const float period = 4.0f;
   const float closeTime = 0.08f;
   const float openTime = 0.16f;
-  float t = std::fmod(timeSec, period);
+  const float t = static_cast<float>(std::fmod(timeSec, double(period)));
   if (t < closeTime)
   {
     return 1.0f - smoothstep(0.0f, closeTime, t);
@@ -290,123 +607,91 @@ static float computeBlinkOpen(float timeSec)
   return 1.0f;
 }
 
-static void applyScaleY(std::vector<glm::vec2> &verts, float scale)
-{
-  if (verts.empty())
-    return;
-  glm::vec2 minV = verts.front();
-  glm::vec2 maxV = verts.front();
-  for (const auto &v : verts)
-  {
-    minV.x = std::min(minV.x, v.x);
-    minV.y = std::min(minV.y, v.y);
-    maxV.x = std::max(maxV.x, v.x);
-    maxV.y = std::max(maxV.y, v.y);
-  }
-  float centerY = (minV.y + maxV.y) * 0.5f;
-  for (auto &v : verts)
-  {
-    v.y = centerY + (v.y - centerY) * scale;
-  }
-}
-
-static void applyScaleX(std::vector<glm::vec2> &verts, float scale)
-{
-  if (verts.empty())
-    return;
-  glm::vec2 minV = verts.front();
-  glm::vec2 maxV = verts.front();
-  for (const auto &v : verts)
-  {
-    minV.x = std::min(minV.x, v.x);
-    minV.y = std::min(minV.y, v.y);
-    maxV.x = std::max(maxV.x, v.x);
-    maxV.y = std::max(maxV.y, v.y);
-  }
-  float centerX = (minV.x + maxV.x) * 0.5f;
-  for (auto &v : verts)
-  {
-    v.x = centerX + (v.x - centerX) * scale;
-  }
-}
-
-static void applyTranslateY(std::vector<glm::vec2> &verts, float offset)
-{
-  for (auto &v : verts)
-    v.y += offset;
-}
-
-static void applyTranslate(std::vector<glm::vec2> &verts, const glm::vec2 &offset)
+namespace
 {
-  for (auto &v : verts)
-    v += offset;
-}
+// Below this many vertices per frame, handing meshes to workers costs more than it saves.
+constexpr size_t kParallelUpdateMinVertices = 16384;
 
-static void applyRotateZ(std::vector<glm::vec2> &verts, float degrees)
+/**
+ * One mesh's share of Engine::update, in the frame arena.
+ * @param palette Skinning palette scratch.
+ * @param keyformWeights Keyform weights (empty for meshes without keyforms).
+ * @param restX Keyform scratch: rest x with the keyforms applied.
+ * @param restY Same for y.
+ * @param deformed Posed positions.
+ * @param packed Whether new positions were packed (false if the mesh's inputs did not change, or
+ *               the GL mesh is out of date).
+ * @param streamed Bytes streamed into the frame's ring region; 0 if the region was current.
+ * @param gpuSkinned Whether the vertex shader skins the mesh this frame, with palette and gpuPose.
+ * @param gpuPose Region pose as a transform applied after skinning.
+ */
+struct MeshUpdate
 {
-  if (verts.empty())
-    return;
-  glm::vec2 minV = verts.front();
-  glm::vec2 maxV = verts.front();
-  for (const auto &v : verts)
-  {
-    minV.x = std::min(minV.x, v.x);
-    minV.y = std::min(minV.y, v.y);
-    maxV.x = std::max(maxV.x, v.x);
-    maxV.y = std::max(maxV.y, v.y);
-  }
-  glm::vec2 center = 0.5f * (minV + maxV);
-  float rad = glm::radians(degrees);
-  float c = std::cos(rad);
-  float s = std::sin(rad);
-  for (auto &v : verts)
-  {
-    glm::vec2 p = v - center;
-    v = center + glm::vec2(p.x * c - p.y * s, p.x * s + p.y * c);
-  }
-}
+  const ArtMesh *mesh;
+  GLMesh *gl;
+  MeshPose pose;
+  std::span<SkinBone> palette;
+  std::span<float> keyformWeights;
+  std::span<float> restX, restY;
+  std::span<glm::vec2> deformed;
+  bool packed;
+  size_t streamed;
+  bool gpuSkinned;
+  SkinBone gpuPose;
+};
+} // namespace
 
-void Engine::update(float timeSec, float dt)
+void Engine::simulate(double timeSec, float dt)
 {
+  ParamStore &params = model.params;
+  const EngineParamHandles &ph = paramHandles;
   if (autoAnimate)
   {
     model.resetParams();
     if (!model.animations.empty())
-      applyAnimation(model.animations[0], timeSec);
+      applyAnimation(model.animations[0], static_cast<float>(std::fmod(timeSec, model.animations[0].duration)));
     // extra expressions can be applied here
     // applyExpressions({{"blink", 0.0f}});
 
     const float blinkOpen = computeBlinkOpen(timeSec);
-    const float mouthOpenAnim = 0.2f + 0.3f * (0.5f + 0.5f * std::sin(timeSec * 1.7f));
-
-    if (auto itEye = model.params.find("ParamEyeLOpen"); itEye != model.params.end())
-      itEye->second.set(blinkOpen);
-    if (auto itEye = model.params.find("ParamEyeROpen"); itEye != model.params.end())
-      itEye->second.set(blinkOpen);
+    const float mouthOpenAnim = 0.2f + 0.3f * (0.5f + 0.5f * static_cast<float>(std::sin(timeSec * 1.7)));
 
-    if (auto itMouthY = model.params.find("ParamMouthOpenY"); itMouthY != model.params.end())
-      itMouthY->second.set(mouthOpenAnim);
-    else if (auto itMouth = model.params.find("ParamMouthOpen"); itMouth != model.params.end())
-      itMouth->second.set(mouthOpenAnim);
+    params.set(ph.eyeLOpen, blinkOpen);
+    params.set(ph.eyeROpen, blinkOpen);
 
-    float mouthOpen = mouthOpenAnim;
-    if (auto itMouthY = model.params.find("ParamMouthOpenY"); itMouthY != model.params.end())
+    if (ph.mouth != kInvalidParam)
     {
-      Spring &sp = springs["ParamMouthOpenY"];
-      mouthOpen = sp.update(itMouthY->second.cur_v, dt);
-      itMouthY->second.set(mouthOpen);
-    }
-    else if (auto itMouth = model.params.find("ParamMouthOpen"); itMouth != model.params.end())
-    {
-      Spring &sp = springs["ParamMouthOpen"];
-      mouthOpen = sp.update(itMouth->second.cur_v, dt);
-      itMouth->second.set(mouthOpen);
+      params.set(ph.mouth, mouthOpenAnim);
+      params.set(ph.mouth, springs[ph.mouth].update(params.cur[ph.mouth], dt));
     }
   }
 
-  float angleX = model.params.count("ParamAngleX") ? model.params["ParamAngleX"].cur_v : 0.0f;
-  float angleY = model.params.count("ParamAngleY") ? model.params["ParamAngleY"].cur_v : 0.0f;
-  float angleZ = model.params.count("ParamAngleZ") ? model.params["ParamAngleZ"].cur_v : 0.0f;
+  if (ph.mouth != kInvalidParam)
+    params.set(ph.mouth, springs[ph.mouth].update(params.cur[ph.mouth], dt));
+}
+
+void Engine::update(float frameSeconds)
+{
+  frameArena.reset();
+  bindParams();
+  ParamStore &params = model.params;
+  const EngineParamHandles &ph = paramHandles;
+
+  const int steps = simClock.advance(frameSeconds);
+  for (int i = 0; i < steps; ++i)
+  {
+    std::copy(params.cur.begin(), params.cur.end(), prevParams.begin());
+    simulate(simClock.stepEnd(i), simClock.stepSeconds());
+  }
+  // The frame lies between the last two steps; deform the meshes for the blend of both.
+  const float alpha = simClock.alpha();
+  for (size_t h = 0; h < renderParams.size(); ++h)
+    renderParams[h] = prevParams[h] + (params.cur[h] - prevParams[h]) * alpha;
+  auto rendered = [&](ParamHandle h, float fallback) { return h < renderParams.size() ? renderParams[h] : fallback; };
+
+  float angleX = rendered(ph.angleX, 0.0f);
+  float angleY = rendered(ph.angleY, 0.0f);
+  float angleZ = rendered(ph.angleZ, 0.0f);
   if (auto itRoot = model.deformers.find("def_root"); itRoot != model.deformers.end())
   {
     itRoot->second.pos = {0.0f, 0.0f};
@@ -416,94 +701,56 @@ void Engine::update(float timeSec, float dt)
   computeDeformers();
 
   const bool hasFaceParts = !model.mesh_face_parts.empty();
-  const bool hasBodyParts = !model.mesh_body_parts.empty();
-  const bool hasSeamParts = !model.mesh_seam_parts.empty();
-  const float eyeLOpen = model.params.count("ParamEyeLOpen") ? model.params["ParamEyeLOpen"].cur_v : 1.0f;
-  const float eyeROpen = model.params.count("ParamEyeROpen") ? model.params["ParamEyeROpen"].cur_v : 1.0f;
+  const float eyeLOpen = rendered(ph.eyeLOpen, 1.0f);
+  const float eyeROpen = rendered(ph.eyeROpen, 1.0f);
   const float eyeOpenAvg = 0.5f * (eyeLOpen + eyeROpen);
-  const float mouthForm = model.params.count("ParamMouthForm") ? model.params["ParamMouthForm"].cur_v : 0.0f;
-  const float browL = model.params.count("ParamBrowLY") ? model.params["ParamBrowLY"].cur_v : 0.0f;
-  const float browR = model.params.count("ParamBrowRY") ? model.params["ParamBrowRY"].cur_v : 0.0f;
-  float mouthOpen = 0.0f;
-  if (auto itMouthY = model.params.find("ParamMouthOpenY"); itMouthY != model.params.end())
-  {
-    Spring &sp = springs["ParamMouthOpenY"];
-    mouthOpen = sp.update(itMouthY->second.cur_v, dt);
-    itMouthY->second.set(mouthOpen);
-  }
-  else if (auto itMouth = model.params.find("ParamMouthOpen"); itMouth != model.params.end())
-  {
-    Spring &sp = springs["ParamMouthOpen"];
-    mouthOpen = sp.update(itMouth->second.cur_v, dt);
-    itMouth->second.set(mouthOpen);
-  }
+  const float mouthForm = rendered(ph.mouthForm, 0.0f);
+  const float browL = rendered(ph.browLY, 0.0f);
+  const float browR = rendered(ph.browRY, 0.0f);
+  const float mouthOpen = rendered(ph.mouth, 0.0f);
 
-  auto meshHasPart = [&](const std::string &meshId, const std::initializer_list<const char *> &parts)
+  refreshActiveMasks();
+  size_t uploadBudget = residencyUploadBudget;
+  bool uploadedThisFrame = false;
+  // Pass 1 (GL thread): pick this frame's meshes, create GL meshes for newly shown ones, work out
+  // each mesh's pose and give it scratch in the frame arena.
+  auto work = frameArena.allocate<MeshUpdate>(model.meshes.size());
+  size_t workCount = 0;
+  size_t workVertices = 0;
+  for (MeshLinks &links : meshLinks)
   {
-    auto it = model.mesh_face_parts.find(meshId);
-    if (it == model.mesh_face_parts.end())
-      return false;
-    for (const auto *part : parts)
-      if (it->second.count(part))
-        return true;
-    return false;
-  };
-
-  auto meshHasBodyPart = [&](const std::string &meshId, const std::initializer_list<const char *> &parts)
-  {
-    auto it = model.mesh_body_parts.find(meshId);
-    if (it == model.mesh_body_parts.end())
-      return false;
-    for (const auto *part : parts)
-      if (it->second.count(part))
-        return true;
-    return false;
-  };
-
-  auto meshHasSeam = [&](const std::string &meshId, const std::initializer_list<const char *> &parts)
-  {
-    auto it = model.mesh_seam_parts.find(meshId);
-    if (it == model.mesh_seam_parts.end())
-      return false;
-    for (const auto *part : parts)
-      if (it->second.count(part))
-        return true;
-    return false;
-  };
-
-  for (auto &kv : model.meshes)
-  {
-    auto deformed = deformMesh(kv.second);
-
-    bool isLeftEye = false;
-    bool isRightEye = false;
-    bool isEyeGeneric = false;
-    bool isMouth = false;
-    bool isBrowL = false;
-    bool isBrowR = false;
-
-    if (hasFaceParts)
-    {
-      isLeftEye = meshHasPart(kv.first, {"eye_left", "eyelid_left", "eye_white_left", "eye_ball_left"});
-      isRightEye = meshHasPart(kv.first, {"eye_right", "eyelid_right", "eye_white_right", "eye_ball_right"});
-      isEyeGeneric = meshHasPart(kv.first, {"eye"});
-      isMouth = meshHasPart(kv.first, {"mouth", "lip_upper", "lip_lower", "tongue", "teeth"});
-      isBrowL = meshHasPart(kv.first, {"brow_left"});
-      isBrowR = meshHasPart(kv.first, {"brow_right"});
-    }
-    else
+    ArtMesh &mesh = *links.mesh;
+    // Hidden meshes that no visible mesh clips against are neither deformed nor resident.
+    if (!isMeshActive(mesh))
+      continue;
+    if (!links.gl)
     {
-      const std::string lowerId = toLowerCopy(kv.first);
-      const bool isEye = containsToken(lowerId, "eye") && !containsToken(lowerId, "brow");
-      isEyeGeneric = isEye;
-      isMouth = containsToken(lowerId, "mouth") || containsToken(lowerId, "lip");
+      // Shown for the first time: upload now, unless this frame already uploaded its share
+      // (at least one mesh always goes through so large meshes are not starved).
+      const size_t bytes = GLMesh::residentBytes(mesh);
+      if (uploadedThisFrame && bytes > uploadBudget)
+        continue;
+      uploadBudget -= std::min(bytes, uploadBudget);
+      uploadedThisFrame = true;
+      links.gl = &glmeshes.emplace(*links.key, GLMesh{}).first->second;
+      links.gl->create(mesh, model.deformerTree, meshArena);
     }
+    // A reload that rebuilt the deformer tree moves the indices the static stream skins with.
+    if (gpuSkinning && links.gl->skinGeneration != model.deformerTree.generation())
+      links.gl->encodeSkin(mesh, model.deformerTree);
 
-    const bool isFaceRegion = isLeftEye || isRightEye || isEyeGeneric || isMouth || isBrowL || isBrowR
-                  || (hasFaceParts && meshHasPart(kv.first, {"face", "face_motion", "nose", "cheek_left", "cheek_right"}));
-    const bool isBodyRegion = hasBodyParts && meshHasBodyPart(kv.first, {"body", "torso", "chest", "shoulder_left", "shoulder_right", "neck", "head", "hair"});
-    const bool isSeamRegion = hasSeamParts && meshHasSeam(kv.first, {"neck_seam", "jaw_seam"});
+    // Roles come from ArtMesh::regions, classified when the model or its parts were loaded.
+    const uint32_t regions = mesh.regions;
+    const bool isLeftEye = regions & kMeshRegionEyeLeft;
+    const bool isRightEye = regions & kMeshRegionEyeRight;
+    const bool isMouth = regions & kMeshRegionMouth;
+    const bool isBrowL = regions & kMeshRegionBrowLeft;
+    const bool isBrowR = regions & kMeshRegionBrowRight;
+    const bool isFaceRegion = regions & kMeshRegionFace;
+    const bool isBodyRegion = regions & kMeshRegionBody;
+    const bool isSeamRegion = regions & kMeshRegionSeam;
 
+    MeshPose pose;
     {
       const float clampedAngleX = glm::clamp(angleX, -20.0f, 20.0f);
       const float clampedAngleY = glm::clamp(angleY, -20.0f, 20.0f);
@@ -521,56 +768,136 @@ void Engine::update(float timeSec, float dt)
       if (isFaceRegion)
         poseWeight = 1.0f;
 
-      applyTranslate(deformed, poseOffset * poseWeight);
-      applyRotateZ(deformed, poseRot * poseWeight);
+      pose.offset = poseOffset * poseWeight;
+      pose.rotateDeg = poseRot * poseWeight;
 
       if (isSeamRegion)
-      {
-        float warp = 1.0f - std::min(0.08f, std::abs(clampedAngleX) / 30.0f * 0.06f);
-        applyScaleX(deformed, warp);
-      }
+        pose.seamScaleX = 1.0f - std::min(0.08f, std::abs(clampedAngleX) / 30.0f * 0.06f);
     }
 
-    if (isLeftEye || isRightEye || isEyeGeneric)
+    if (regions & kMeshRegionAnyEye)
     {
       float open = eyeOpenAvg;
       if (isLeftEye)
         open = eyeLOpen;
       else if (isRightEye)
         open = eyeROpen;
-      float eyeScale = glm::mix(0.05f, 1.0f, open);
-      applyScaleY(deformed, eyeScale);
+      pose.eyeScaleY = glm::mix(0.05f, 1.0f, open);
     }
 
     if (isMouth)
     {
-      float mouthScaleY = glm::mix(0.7f, 1.3f, mouthOpen);
-      applyScaleY(deformed, mouthScaleY);
-      float mouthScaleX = 1.0f + mouthForm * 0.2f;
-      applyScaleX(deformed, mouthScaleX);
+      pose.mouthScaleY = glm::mix(0.7f, 1.3f, mouthOpen);
+      pose.mouthScaleX = 1.0f + mouthForm * 0.2f;
     }
 
     if (isBrowL || isBrowR)
+      pose.browLift = (isBrowL ? browL : browR) * 0.08f;
+
+    MeshUpdate &u = work[workCount++];
+    u.mesh = &mesh;
+    u.gl = links.gl;
+    u.pose = pose;
+    u.palette = frameArena.allocate<SkinBone>(skinPaletteSize(mesh));
+    u.keyformWeights = frameArena.allocate<float>(mesh.keyforms.forms.size());
+    const size_t restSize = mesh.keyforms.empty() ? 0 : keyformScratchSize(mesh.verts.size());
+    u.restX = frameArena.allocate<float>(restSize);
+    u.restY = frameArena.allocate<float>(restSize);
+    u.deformed = frameArena.allocate<glm::vec2>(mesh.verts.size());
+    u.packed = false;
+    u.streamed = 0;
+    u.gpuSkinned = false;
+    workVertices += mesh.verts.size();
+  }
+
+  // The ring region this frame writes and draws; waits only if the GPU still reads it.
+  meshArena.beginFrame();
+
+  // Pass 2 (workers): morph, skin, pose and pack every mesh whose inputs changed, then stream it
+  // into the frame's ring region if that region is behind. Each job only writes its own meshes'
+  // scratch, cpuPositions, source and vertex range, so the result does not depend on the thread count.
+  auto deformRange = [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; ++i)
     {
-      float brow = isBrowL ? browL : browR;
-      if (!deformed.empty())
+      MeshUpdate &u = work[i];
+      const ArtMesh &m = *u.mesh;
+      resolveSkinPalette(m, u.palette);
+      const size_t activeKeyforms = computeKeyformWeights(m.keyforms, renderParams, u.keyformWeights);
+      // The vertex shader can take over when the pose follows without the skinned positions: rigid
+      // meshes get their bounds from the hull, and a translation needs none. Morphed meshes stay here.
+      const bool rigid = m.skin.kind == SkinKind::Rigid && !m.skin.hull.empty();
+      if (gpuSkinning && u.gl->gpuSkinnable && u.gl->skinGeneration == model.deformerTree.generation()
+          && m.skin.size() == m.verts.size() && activeKeyforms == 0 && (rigid || !poseNeedsBounds(u.pose)))
+      {
+        u.gpuSkinned = true;
+        u.gpuPose = meshPoseTransform(u.pose, rigid ? measureRigidSkinBounds(m.skin, u.palette[m.skin.rigidBone],
+                                                                             u.pose.rotateDeg)
+                                                    : SkinBounds{});
+        continue;
+      }
+      // Nothing the positions depend on moved since they were packed: cpuPositions is still current.
+      GLMeshSource &source = u.gl->source;
+      const bool current = source.valid && source.kernel == skinKernel && source.pose == u.pose
+                           && std::equal(source.palette.begin(), source.palette.end(), u.palette.begin(),
+                                         u.palette.end())
+                           && std::equal(source.keyformWeights.begin(), source.keyformWeights.end(),
+                                         u.keyformWeights.begin(), u.keyformWeights.end());
+      if (!current)
       {
-        glm::vec2 minV = deformed.front();
-        glm::vec2 maxV = deformed.front();
-        for (const auto &v : deformed)
+        source.palette.assign(u.palette.begin(), u.palette.end());
+        source.keyformWeights.assign(u.keyformWeights.begin(), u.keyformWeights.end());
+        source.pose = u.pose;
+        source.kernel = skinKernel;
+        // Keyforms need current skin streams; with none active the rest positions are used as they are.
+        std::span<const float> restX, restY;
+        if (activeKeyforms > 0 && m.skin.size() == m.verts.size())
         {
-          minV.x = std::min(minV.x, v.x);
-          minV.y = std::min(minV.y, v.y);
-          maxV.x = std::max(maxV.x, v.x);
-          maxV.y = std::max(maxV.y, v.y);
+          applyKeyforms(m.keyforms, u.keyformWeights, m.skin, u.restX, u.restY, skinKernel);
+          restX = u.restX;
+          restY = u.restY;
         }
-        float height = std::max(1e-4f, maxV.y - minV.y);
-        applyTranslateY(deformed, brow * height * 0.08f);
+        deformMesh(m, u.pose, u.palette, restX, restY, u.deformed);
+        u.packed = u.gl->packPositions(u.deformed);
+        source.valid = u.packed;
       }
+      u.streamed = u.gl->stream();
     }
+  };
+  if (workVertices >= kParallelUpdateMinVertices)
+    jobs.parallelFor(workCount, std::max<size_t>(1, workCount / (size_t(jobs.threadCount()) * 8)), deformRange);
+  else
+    deformRange(0, workCount);
 
-    glmeshes[kv.first].updatePositions(deformed);
+  // Pass 3 (GL thread): publish what was streamed, and note every mesh's draw constants and the
+  // GPU skinning bones for render().
+  updateStats = MeshUpdateStats{};
+  updateStats.active = workCount;
+  for (size_t i = 0; i < workCount; ++i)
+  {
+    const GLMesh &gm = *work[i].gl;
+    meshArena.setDrawData(gm.slot, gm.posDecode, gm.uvDecode, work[i].mesh->opacity, gm.color);
+    if (work[i].gpuSkinned)
+    {
+      meshArena.setSkinning(gm.slot, gm.restDecode, work[i].gpuPose);
+      ++updateStats.gpuSkinned;
+      continue;
+    }
+    if (work[i].streamed > 0)
+      meshArena.flush(gm.firstVertex, gm.vertCount);
+    updateStats.uploadBytes += work[i].streamed;
+    if (work[i].packed)
+      ++updateStats.updated;
   }
+  // Every GPU-skinned mesh reads the same bones: the deformers' world matrices, once per frame.
+  if (updateStats.gpuSkinned > 0)
+    meshArena.setBones(model.deformerTree.worldMatrices());
+  else
+    meshArena.clearBones();
+  updateStats.paletteBytes = meshArena.boneCount() * GLMeshArena::kBoneRows * sizeof(glm::vec4);
+  meshArena.endWrites();
+  updateStats.skipped = workCount - updateStats.gpuSkinned - updateStats.updated;
+  updateStats.stalls = meshArena.stalls();
 #if defined(LITE2D_DEBUG) && LITE2D_DEBUG
   checkErr("after update positions");
 #endif
@@ -578,6 +905,7 @@ void Engine::update(float timeSec, float dt)
 
 void Engine::render(int fbw, int fbh)
 {
+  renderStats = RenderStats{};
   glViewport(0, 0, fbw, fbh);
   glClear(clearMask); // no stencil clear if stencilBits == 0
 #if defined(LITE2D_DEBUG) && LITE2D_DEBUG
@@ -588,27 +916,51 @@ void Engine::render(int fbw, int fbh)
   glUniformMatrix4fv(shader.loc("uMVP"), 1, GL_FALSE, &mvp[0][0]);
   glActiveTexture(GL_TEXTURE0);
   glUniform1i(shader.loc("uTex"), 0);
+  glUniform1i(shader.loc("uDrawData"), 1);
+  glUniform1i(shader.loc("uBones"), 2);
 
-  std::vector<const ArtMesh *> drawList;
-  drawList.reserve(model.meshes.size());
-  for (auto &kv : model.meshes)
-  {
-    if (kv.second.visible)
-      drawList.push_back(&kv.second);
-  }
-  std::sort(drawList.begin(), drawList.end(),
-            [](auto *a, auto *b)
-            { return a->draw_order < b->draw_order; });
+  // Every mesh lives in the arena: one vertex array for the whole frame.
+  meshArena.uploadDrawData();
+  meshArena.bind(1);
+  ++renderStats.vaoBinds;
+
+  const size_t renderMark = frameArena.mark();
+  refreshDrawList();
+  const size_t drawCount = drawList.size();
 
-  auto bindTex = [&](const std::string &tid)
+  GLuint boundTex = 0;
+  auto bindTex = [&](GLuint tex)
   {
-    auto it = textures.find(tid);
-    if (it != textures.end())
-      glBindTexture(GL_TEXTURE_2D, it->second.id);
+    // A mesh without a texture draws with whatever is bound.
+    if (tex == 0 || tex == boundTex)
+      return;
+    glBindTexture(GL_TEXTURE_2D, tex);
+    boundTex = tex;
+    ++renderStats.textureBinds;
+  };
+  // Vertices come from the ring region update() streamed into, through that region's vertex array.
+  auto drawOne = [&](const GLMesh &gm)
+  {
+    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)gm.idxCount, gm.indexType, (void *)gm.indexOffset,
+                             (GLint)gm.firstVertex);
+    ++renderStats.drawCalls;
+    ++renderStats.meshes;
   };
 
-  for (auto *m : drawList)
+  // Scratch for one multi-draw run.
+  auto runCounts = frameArena.allocate<GLsizei>(drawCount);
+  auto runOffsets = frameArena.allocate<const void *>(drawCount);
+  auto runBases = frameArena.allocate<GLint>(drawCount);
+
+  for (size_t i = 0; i < drawCount;)
   {
+    const ArtMesh *m = drawList[i].mesh;
+    const GLMesh *gm = drawList[i].gl;
+    if (!gm)
+    {
+      ++i;
+      continue;
+    }
     // Set blend mode based on drawable properties
     switch (m->blend_mode)
     {
@@ -623,41 +975,75 @@ void Engine::render(int fbw, int fbh)
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         break;
     }
-    
-    // Set opacity uniform
-    glUniform1f(shader.loc("uOpacity"), m->opacity);
-    
+    bindTex(drawList[i].texture);
+
     bool canClip = (stencilBits > 0) && !m->clipping_mask_id.empty();
-    if (!canClip)
-    {
-      bindTex(m->texture_id);
-      glDisable(GL_STENCIL_TEST);
-      glmeshes[m->id].draw();
-    }
-    else
+    if (canClip)
     {
-      auto itMask = model.meshes.find(m->clipping_mask_id);
-      if (itMask == model.meshes.end())
+      const GLMesh *mask = drawList[i].mask;
+      ++i;
+      if (!mask)
         continue;
-      bindTex(m->texture_id);
       glEnable(GL_STENCIL_TEST);
       glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
       glStencilFunc(GL_ALWAYS, 1, 0xFF);
       glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
       glStencilMask(0xFF);
       glClear(GL_STENCIL_BUFFER_BIT);
-      glmeshes[itMask->first].draw();
+      drawOne(*mask);
 
       glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
       glStencilFunc(GL_EQUAL, 1, 0xFF);
       glStencilMask(0x00);
-      glmeshes[m->id].draw();
+      drawOne(*gm);
 
       glDisable(GL_STENCIL_TEST);
       glStencilMask(0xFF);
+      continue;
+    }
+
+    // Unclipped meshes that follow with the same blend mode, texture and index type go out together.
+    size_t runLength = 0;
+    size_t j = i;
+    for (; j < drawCount; ++j)
+    {
+      const ArtMesh *next = drawList[j].mesh;
+      const GLMesh *nextGL = drawList[j].gl;
+      if (!nextGL)
+        continue;
+      const GLuint nextTex = drawList[j].texture;
+      if (next->blend_mode != m->blend_mode || (nextTex != 0 && nextTex != boundTex)
+          || nextGL->indexType != gm->indexType || (stencilBits > 0 && !next->clipping_mask_id.empty()))
+        break;
+      runCounts[runLength] = (GLsizei)nextGL->idxCount;
+      runOffsets[runLength] = (const void *)nextGL->indexOffset;
+      runBases[runLength] = (GLint)nextGL->firstVertex;
+      ++runLength;
+    }
+    i = j;
+    glDisable(GL_STENCIL_TEST);
+    if (runLength == 1)
+    {
+      glDrawElementsBaseVertex(GL_TRIANGLES, runCounts[0], gm->indexType, runOffsets[0], runBases[0]);
     }
+    else
+    {
+      glMultiDrawElementsBaseVertex(GL_TRIANGLES, runCounts.data(), gm->indexType, runOffsets.data(),
+                                    (GLsizei)runLength, runBases.data());
+      ++renderStats.multiDraws;
+    }
+    ++renderStats.drawCalls;
+    renderStats.meshes += runLength;
   }
-  
+#if defined(LITE2D_DEBUG) && LITE2D_DEBUG
+  checkErr("after draw");
+#endif
+
+  // The region may be written again once the GPU is past this point.
+  meshArena.fenceFrame();
+
   // Restore default blend mode
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glBindVertexArray(0);
+  frameArena.rewind(renderMark);
 }
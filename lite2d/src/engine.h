@@ -2,7 +2,9 @@
 #pragma once
 #define __LITE2D_ENGINE_H__
 
+#include <span>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <vector>
 
@@ -11,26 +13,190 @@
 #include "anim_clip.h"
 #include "deformer.h"
 #include "expression.h"
+#include "frame_arena.h"
 #include "model.h"
 #include "glmesh.h"
+#include "glmesh_arena.h"
+#include "job_system.h"
+#include "mesh_pose.h"
 #include "shader.h"
+#include "sim_clock.h"
+#include "skinning.h"
 #include "texture.h"
 #include "easing.h"
 #include "spring.h"
 
+/**
+ * What Engine::applyModelReload did to the live model.
+ * @param added Meshes that were new (uploaded when first drawn).
+ * @param removed Meshes that disappeared and had their GL buffers released.
+ * @param rebuilt Meshes whose geometry changed (GL buffers released, re-uploaded when next drawn).
+ * @param updated Meshes where only properties (order, visibility, texture, ...) changed.
+ * @param unchanged Meshes left exactly as they were.
+ */
+struct ModelReloadStats
+{
+  size_t added = 0;
+  size_t removed = 0;
+  size_t rebuilt = 0;
+  size_t updated = 0;
+  size_t unchanged = 0;
+};
+
+/**
+ * What the last Engine::update did with the model's meshes.
+ * @param active Meshes that were visible or a visible mesh's clip mask (and resident).
+ * @param updated Meshes re-skinned and re-packed because a deformer or their pose changed.
+ * @param skipped Active CPU-skinned meshes whose inputs matched their last pack.
+ * @param uploadBytes Vertex bytes written to the frame's ring region, stale regions caught up included.
+ * @param stalls Frames so far that waited for the GPU to release a ring region.
+ * @param gpuSkinned Active meshes left to the vertex shader.
+ * @param paletteBytes Bone matrix bytes uploaded for them: every deformer once, however many
+ *                     meshes share it.
+ */
+struct MeshUpdateStats
+{
+  size_t active = 0;
+  size_t updated = 0;
+  size_t skipped = 0;
+  size_t uploadBytes = 0;
+  size_t gpuSkinned = 0;
+  size_t paletteBytes = 0;
+  uint64_t stalls = 0;
+};
+
+/**
+ * What the last Engine::render submitted.
+ * @param meshes Meshes drawn, clip masks included once per use.
+ * @param drawCalls glDrawElementsBaseVertex and glMultiDrawElementsBaseVertex calls.
+ * @param multiDraws The glMultiDrawElementsBaseVertex calls among them.
+ * @param vaoBinds Vertex array binds.
+ * @param textureBinds Texture binds.
+ */
+struct RenderStats
+{
+  size_t meshes = 0;
+  size_t drawCalls = 0;
+  size_t multiDraws = 0;
+  size_t vaoBinds = 0;
+  size_t textureBinds = 0;
+};
+
+/**
+ * One entry of Engine::meshLinks: a mesh with the lookups update() needs resolved.
+ * @param key The mesh's key in Model::meshes and Engine::glmeshes.
+ * @param mesh The mesh.
+ * @param mask Its clip mask mesh; null if it has none or the id does not resolve.
+ * @param gl Its GL mesh; null until it is resident.
+ */
+struct MeshLinks
+{
+  const std::string *key = nullptr;
+  ArtMesh *mesh = nullptr;
+  const ArtMesh *mask = nullptr;
+  GLMesh *gl = nullptr;
+};
+
+/**
+ * One entry of Engine::drawList.
+ * @param mesh The visible mesh.
+ * @param gl Its GL mesh; null while the upload is pending.
+ * @param mask Its clip mask's GL mesh; null if it has none or that upload is pending.
+ * @param texture Its texture; 0 if the texture is not loaded.
+ * @param key drawSortKey(mesh->draw_order, tie) from when the entry was last sorted.
+ */
+struct DrawItem
+{
+  const ArtMesh *mesh = nullptr;
+  const GLMesh *gl = nullptr;
+  const GLMesh *mask = nullptr;
+  GLuint texture = 0;
+  uint64_t key = 0;
+};
+
+// Draw order in the high 32 bits, biased so that the keys compare like the orders, and a tie
+// breaker that keeps equal orders in a fixed sequence in the low 32 bits.
+inline uint64_t drawSortKey(int drawOrder, uint32_t tie)
+{
+  return uint64_t(uint32_t(drawOrder) ^ 0x80000000u) << 32 | tie;
+}
+inline int drawOrderOfKey(uint64_t key)
+{
+  return int(uint32_t(key >> 32) ^ 0x80000000u);
+}
+
+/**
+ * Handles of the parameters Engine::update drives or reads, re-resolved when the model's parameter
+ * layout changes. Any of them is kInvalidParam if the model does not declare it.
+ * @param mouth ParamMouthOpenY if the model has it, otherwise ParamMouthOpen.
+ * @param layout The ParamStore::layoutVersion the handles were resolved against.
+ */
+struct EngineParamHandles
+{
+  ParamHandle angleX = kInvalidParam;
+  ParamHandle angleY = kInvalidParam;
+  ParamHandle angleZ = kInvalidParam;
+  ParamHandle eyeLOpen = kInvalidParam;
+  ParamHandle eyeROpen = kInvalidParam;
+  ParamHandle mouth = kInvalidParam;
+  ParamHandle mouthForm = kInvalidParam;
+  ParamHandle browLY = kInvalidParam;
+  ParamHandle browRY = kInvalidParam;
+  uint32_t layout = ~0u;
+};
+
+/**
+ * Per-parameter accumulator used by Engine::applyExpressions.
+ * @param add Sum of additive deltas.
+ * @param overrideValue Value of the highest-priority override.
+ * @param priority Priority of that override.
+ * @param flags kAdd / kOverride if the respective kind was seen this call.
+ */
+struct ExpressionAccum
+{
+  static constexpr uint8_t kAdd = 1;
+  static constexpr uint8_t kOverride = 2;
+  float add = 0.0f;
+  float overrideValue = 0.0f;
+  int priority = 0;
+  uint8_t flags = 0;
+};
+
 /**
  * The main 2D engine class that handles model, rendering, and animation.
  * @param model The 2D model.
  * @param stencilBits Number of bits in the stencil buffer.
  * @param clearMask The OpenGL clear mask for the framebuffer.
- * @param worldM The world matrices for deformers.
  * @param glmeshes The OpenGL meshes for rendering.
+ * @param meshArena Vertex, index and draw data storage shared by glmeshes.
  * @param textures The loaded textures.
  * @param shader The shader program used for rendering.
  * @param proj The projection matrix.
  * @param view The view matrix.
  * @param canvas The canvas size.
- * @param springs The parameter smoothing springs.
+ * @param springs The parameter smoothing springs, indexed by ParamHandle.
+ * @param simClock Fixed-step clock update() runs simulate() on.
+ * @param prevParams Parameter values before the latest simulation step, indexed by ParamHandle.
+ * @param renderParams Parameter values the meshes were deformed with in the last update(): the
+ *                     last two simulation steps blended by simClock.alpha().
+ * @param paramHandles Handles of the parameters update() uses.
+ * @param exprAccum Per-parameter scratch for applyExpressions, indexed by ParamHandle.
+ * @param exprTouched Parameters with a non-empty accumulator during applyExpressions.
+ * @param residencyUploadBudget Bytes of mesh data uploaded per frame for meshes being shown for the first time.
+ * @param activeMasks Clip mask meshes used by visible meshes this frame, sorted by address (in frameArena).
+ * @param meshLinks Every mesh of the model with its clip mask and GL mesh, so update() looks
+ *                  nothing up by id (see refreshMeshLinks()).
+ * @param meshLinksDirty Whether the next refreshMeshLinks() rebuilds meshLinks.
+ * @param visibleMeshes Visible meshes in the model, counted by refreshActiveMasks().
+ * @param drawList Visible meshes sorted by draw order, kept across frames (see refreshDrawList()).
+ * @param drawListDirty Whether the next refreshDrawList() rebuilds drawList from the model.
+ * @param frameArena Transient per-frame storage; reset at the start of update().
+ * @param skinKernel CPU skinning kernel deformMesh uses (the fastest supported by default).
+ * @param gpuSkinning Skin meshes in the vertex shader where the result does not need the skinned
+ *                    positions on the CPU (see update()); the rest go through deformMesh.
+ * @param updateStats Mesh counts of the last update().
+ * @param renderStats Draw and bind counts of the last render().
+ * @param jobs Worker threads update() deforms meshes on; jobs.setThreadCount(1) keeps it on the caller.
  */
 class Engine
 {
@@ -40,8 +206,8 @@ public:
   int stencilBits = 0;
   GLbitfield clearMask = GL_COLOR_BUFFER_BIT;
 
-  std::unordered_map<std::string, glm::mat3> worldM; // deformer world matrix
   std::unordered_map<std::string, GLMesh> glmeshes;
+  GLMeshArena meshArena;
   std::unordered_map<std::string, Texture> textures;
 
   // render state
@@ -51,7 +217,34 @@ public:
   glm::vec2 canvas{1920, 1080};
 
   // param smoothing
-  std::unordered_map<std::string, Spring> springs;
+  std::vector<Spring> springs;
+
+  // simulation clock and the states rendering interpolates between
+  SimClock simClock;
+  std::vector<float> prevParams;
+  std::vector<float> renderParams;
+
+  // parameter handles and scratch, rebuilt when the parameter layout changes
+  EngineParamHandles paramHandles;
+  std::vector<ExpressionAccum> exprAccum;
+  std::vector<ParamHandle> exprTouched;
+
+  // Lazy GPU residency: hidden meshes get GL buffers when first shown (or used as a visible mesh's mask).
+  size_t residencyUploadBudget = 4u << 20;
+  std::span<const ArtMesh *> activeMasks;
+  std::vector<MeshLinks> meshLinks;
+  bool meshLinksDirty = true;
+  size_t visibleMeshes = 0;
+
+  std::vector<DrawItem> drawList;
+  bool drawListDirty = true;
+
+  mutable FrameArena frameArena; // scratch for const helpers such as deformMesh too
+  SkinKernel skinKernel = bestSkinKernel();
+  bool gpuSkinning = false;
+  JobSystem jobs;
+  MeshUpdateStats updateStats;
+  RenderStats renderStats;
 
   // When false, skip internal animation/reset so external code can drive params.
   bool autoAnimate = true;
@@ -62,23 +255,71 @@ public:
 
   bool initGL();
   void buildGLMeshes();
+
+  // Resolves meshLinks after the model's meshes, their clip mask ids or the GL meshes were replaced.
+  void refreshMeshLinks();
+  // Whether a mesh has to be deformed and resident this frame (visible, or a visible mesh's clip mask).
+  void refreshActiveMasks();
+  bool isMeshActive(const ArtMesh &m) const;
+
+  // Brings drawList up to date for render(). It is rebuilt only when a mesh was shown or hidden, or
+  // after invalidateDrawList(); changed draw orders re-sort it in place with an insertion sort, which
+  // is linear when few meshes moved. Pending GL meshes, masks and textures are looked up again.
+  void refreshDrawList();
+  // Call after replacing meshes or textures, or changing texture or clip mask ids, outside
+  // applyModelReload and buildGLMeshes. Resolves meshLinks again too.
+  void invalidateDrawList()
+  {
+    meshLinksDirty = true;
+    drawListDirty = true;
+  }
+
+  // Swaps in a freshly loaded model, touching only the GL meshes whose geometry changed.
+  // Parameters, expressions, animations, springs and textures are kept; parameters that are new
+  // in the reloaded model are added.
+  ModelReloadStats applyModelReload(Model &&next);
   void createCheckerTexture(const std::string &id, int w = 64, int h = 64);
   
-  // Animation sampling
+  // Resolves paramHandles and the model's track/expression handles if the parameter layout changed.
+  void bindParams();
+
+  // Snaps every spring, and the interpolated parameters, to the parameters' current values.
+  void resetSprings();
+
+  // Animation sampling. The clip's tracks must be bound to this model (Model::bindParams binds
+  // model.animations).
   void applyAnimation(const AnimationClip &clip, float t);
 
   // Expressions
   void applyExpressions(const std::vector<std::pair<std::string, float>> &exprWeights);
 
-  // Deformer world matrices (3x3 2D affine)
+  // Deformer world matrices (3x3 2D affine), in model.deformerTree. Only deformers whose
+  // transform changed since the last call, and their descendants, are recomputed.
   void computeDeformers();
 
-  // CPU skinning (2 bones)
+  // Keyforms and CPU skinning (up to 2 bones) into out, which must hold m.verts.size() positions.
+  void deformMesh(const ArtMesh &m, std::span<glm::vec2> out) const;
   std::vector<glm::vec2> deformMesh(const ArtMesh &m) const;
+  // Skinning followed by the region pose, fused into as few passes over the vertices as possible.
+  // palette holds resolveSkinPalette(m, ...) and is used as scratch (the rigid bone entry is
+  // overwritten); with separate palettes, meshes can be deformed on several threads at once.
+  // restX and restY, unless empty, replace m.skin.x and m.skin.y (rest positions with the mesh's
+  // keyforms applied, see applyKeyforms).
+  void deformMesh(const ArtMesh &m, const MeshPose &pose, std::span<SkinBone> palette, std::span<const float> restX,
+                  std::span<const float> restY, std::span<glm::vec2> out) const;
+  // Deformer world matrices of m.deformers, plus the zero slot.
+  void resolveSkinPalette(const ArtMesh &m, std::span<SkinBone> palette) const;
 
   glm::mat4 computeMVP(int fbw, int fbh);
 
-  void update(float timeSec, float dt);
+  // One simulation step of dt seconds ending at timeSec: idle animation, blinking and springs.
+  // update() runs it at simClock's rate, after bindParams().
+  void simulate(double timeSec, float dt);
+
+  // Advances the simulation by frameSeconds in simClock steps, then deforms and uploads the meshes
+  // for parameters interpolated between the last two steps. Parameters set from outside between
+  // frames are blended in by the interpolation and read by the next step.
+  void update(float frameSeconds);
 
   void render(int fbw, int fbh);
 };
@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+#include "param_store.h"
+
 /**
  * Blend mode for expression parameter application.
  * - Additive: parameter delta is added to current value.
@@ -22,6 +24,7 @@ enum class BlendMode
  * @param delta The change in value to apply.
  * @param mode The blend mode (additive or override).
  * @param priority The priority for override mode.
+ * @param param Handle of param_id in the owning model's parameters (set by Model::bindParams).
  */
 struct ExpressionParameter
 {
@@ -29,6 +32,7 @@ struct ExpressionParameter
   float delta { 0 };
   BlendMode mode{ BlendMode::Additive };
   int priority { 0 };  // for override
+  ParamHandle param { kInvalidParam };
 };
 
 /**
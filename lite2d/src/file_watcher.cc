@@ -0,0 +1,162 @@
+#include "file_watcher.h"
+
+#include <iostream>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+bool statFile(const std::filesystem::path &path, std::filesystem::file_time_type &mtime, uintmax_t &size)
+{
+  std::error_code ec;
+  mtime = std::filesystem::last_write_time(path, ec);
+  if (ec)
+  {
+    mtime = {};
+    size = 0;
+    return false;
+  }
+  size = std::filesystem::file_size(path, ec);
+  if (ec)
+    size = 0;
+  return true;
+}
+} // namespace
+
+FileWatcher::FileWatcher()
+{
+#if defined(__linux__)
+  notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (notifyFd < 0)
+    std::cerr << "inotify unavailable, polling for file changes\n";
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#if defined(__linux__)
+  if (notifyFd >= 0)
+    ::close(notifyFd);
+#endif
+}
+
+bool FileWatcher::watch(const std::filesystem::path &path)
+{
+  std::error_code ec;
+  const std::filesystem::path full = std::filesystem::absolute(path, ec).lexically_normal();
+  if (ec)
+    return false;
+  for (const auto &f : files)
+  {
+    if (f.path == full)
+      return true;
+  }
+
+  WatchedFile file;
+  file.path = full;
+  statFile(full, file.mtime, file.size);
+  files.push_back(std::move(file));
+
+#if defined(__linux__)
+  if (notifyFd >= 0)
+  {
+    const std::filesystem::path dir = full.parent_path();
+    for (const auto &kv : dirWatches)
+    {
+      if (kv.second == dir)
+        return true;
+    }
+    const int wd = inotify_add_watch(notifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+    if (wd >= 0)
+    {
+      dirWatches[wd] = dir;
+      return true;
+    }
+    // Fall back to polling everything rather than mixing both schemes.
+    std::cerr << "Cannot watch " << dir << ", polling for file changes\n";
+    ::close(notifyFd);
+    notifyFd = -1;
+    dirWatches.clear();
+  }
+#endif
+  return true;
+}
+
+void FileWatcher::readNotifications()
+{
+#if defined(__linux__)
+  alignas(inotify_event) char buf[4096];
+  for (;;)
+  {
+    const ssize_t n = ::read(notifyFd, buf, sizeof(buf));
+    if (n <= 0)
+    {
+      if (n < 0 && errno == EINTR)
+        continue;
+      break;
+    }
+    for (ssize_t off = 0; off < n;)
+    {
+      const auto *ev = reinterpret_cast<const inotify_event *>(buf + off);
+      off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+      if (ev->len == 0)
+        continue;
+      auto itDir = dirWatches.find(ev->wd);
+      if (itDir == dirWatches.end())
+        continue;
+      const std::filesystem::path changed = itDir->second / ev->name;
+      for (auto &f : files)
+      {
+        if (f.path != changed)
+          continue;
+        f.pending = true;
+        lastEvent = std::chrono::steady_clock::now();
+      }
+    }
+  }
+#endif
+}
+
+void FileWatcher::pollTimes()
+{
+  const auto now = std::chrono::steady_clock::now();
+  if (now - lastPoll < pollInterval)
+    return;
+  lastPoll = now;
+  for (auto &f : files)
+  {
+    std::filesystem::file_time_type mtime;
+    uintmax_t size = 0;
+    statFile(f.path, mtime, size);
+    if (mtime == f.mtime && size == f.size)
+      continue;
+    f.mtime = mtime;
+    f.size = size;
+    f.pending = true;
+    lastEvent = now;
+  }
+}
+
+std::vector<std::filesystem::path> FileWatcher::poll()
+{
+  if (notifyFd >= 0)
+    readNotifications();
+  else
+    pollTimes();
+
+  std::vector<std::filesystem::path> changed;
+  if (std::chrono::steady_clock::now() - lastEvent < settleTime)
+    return changed;
+  for (auto &f : files)
+  {
+    if (!f.pending)
+      continue;
+    f.pending = false;
+    changed.push_back(f.path);
+  }
+  return changed;
+}
@@ -0,0 +1,59 @@
+#ifndef __LITE2D_FILE_WATCHER_H__
+#pragma once
+#define __LITE2D_FILE_WATCHER_H__
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Reports changes to a set of files. Uses inotify on Linux (watching the parent directories, so
+ * editors that save through a rename are caught) and falls back to polling mtimes elsewhere.
+ * Changes are held back until the files have been quiet for settleTime, so a burst of writes from
+ * one save is reported once.
+ * @param settleTime How long a changed file must stay untouched before it is reported.
+ * @param pollInterval How often mtimes are checked when inotify is not available.
+ */
+class FileWatcher
+{
+public:
+  std::chrono::milliseconds settleTime{150};
+  std::chrono::milliseconds pollInterval{500};
+
+  FileWatcher();
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+  ~FileWatcher();
+
+  // Starts watching path. The file does not have to exist yet.
+  bool watch(const std::filesystem::path &path);
+
+  // Returns the watched files that changed and have settled since the last call. Never blocks.
+  std::vector<std::filesystem::path> poll();
+
+  // Whether changes come from inotify rather than mtime polling.
+  bool usesNotifications() const { return notifyFd >= 0; }
+
+private:
+  struct WatchedFile
+  {
+    std::filesystem::path path;
+    std::filesystem::file_time_type mtime;
+    uintmax_t size = 0;
+    bool pending = false;
+  };
+
+  int notifyFd = -1;
+  std::unordered_map<int, std::filesystem::path> dirWatches; // inotify watch -> directory
+  std::vector<WatchedFile> files;
+  std::chrono::steady_clock::time_point lastEvent;
+  std::chrono::steady_clock::time_point lastPoll;
+
+  void readNotifications();
+  void pollTimes();
+};
+
+#endif  // __LITE2D_FILE_WATCHER_H__
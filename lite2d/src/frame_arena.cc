@@ -0,0 +1,65 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+// Blocks are aligned for anything the engine stores (glm vectors and matrices, pointers).
+constexpr size_t kBlockAlign = alignof(std::max_align_t);
+
+unsigned char *allocateBlock(size_t bytes)
+{
+  return static_cast<unsigned char *>(::operator new(bytes, std::align_val_t(kBlockAlign)));
+}
+
+void freeBlock(unsigned char *block)
+{
+  ::operator delete(block, std::align_val_t(kBlockAlign));
+}
+} // namespace
+
+FrameArena::FrameArena(size_t capacity)
+    : blockSize(std::max<size_t>(capacity, kBlockAlign))
+{
+  block = allocateBlock(blockSize);
+}
+
+FrameArena::~FrameArena()
+{
+  for (auto *b : overflow)
+    freeBlock(b);
+  freeBlock(block);
+}
+
+void *FrameArena::allocateBytes(size_t bytes, size_t align)
+{
+  const size_t at = (used + align - 1) & ~(align - 1);
+  if (at + bytes <= blockSize)
+  {
+    used = at + bytes;
+    peak = std::max(peak, used + spilled);
+    return block + at;
+  }
+  // Out of room this frame: hand out a dedicated block and size the main one up at reset().
+  overflow.push_back(allocateBlock(std::max(bytes, kBlockAlign)));
+  spilled += bytes + align;
+  peak = std::max(peak, used + spilled);
+  return overflow.back();
+}
+
+void FrameArena::reset()
+{
+  if (!overflow.empty())
+  {
+    for (auto *b : overflow)
+      freeBlock(b);
+    overflow.clear();
+    freeBlock(block);
+    blockSize = std::max(blockSize * 2, peak + peak / 4);
+    block = allocateBlock(blockSize);
+  }
+  used = 0;
+  spilled = 0;
+}
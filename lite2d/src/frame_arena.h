@@ -0,0 +1,62 @@
+#ifndef __LITE2D_FRAME_ARENA_H__
+#pragma once
+#define __LITE2D_FRAME_ARENA_H__
+
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Linear allocator for data that lives for one frame. Allocation bumps a pointer; reset() at the
+ * start of the next frame releases everything at once. A frame that needs more than the block
+ * holds spills into extra heap blocks, and the next reset() replaces them with one block big
+ * enough for that frame, so after warm-up a frame does no heap allocation at all.
+ * Only trivially destructible types can be placed in the arena; nothing is ever destroyed.
+ */
+class FrameArena
+{
+public:
+  explicit FrameArena(size_t capacity = 256 * 1024);
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+  ~FrameArena();
+
+  // Uninitialized storage for count objects of T, valid until the next reset().
+  template <typename T>
+  std::span<T> allocate(size_t count)
+  {
+    static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+    if (count == 0)
+      return {};
+    return {static_cast<T *>(allocateBytes(sizeof(T) * count, alignof(T))), count};
+  }
+
+  void reset();
+
+  // Scoped release inside a frame: rewind(mark()) frees everything allocated after the mark, as
+  // long as nothing spilled out of the main block in between.
+  size_t mark() const { return used; }
+  void rewind(size_t marker)
+  {
+    if (spilled == 0 && marker <= used)
+      used = marker;
+  }
+
+  size_t capacity() const { return blockSize; }
+  size_t bytesUsed() const { return used + spilled; }
+  // Most bytes any frame since construction has used.
+  size_t highWater() const { return peak; }
+
+private:
+  unsigned char *block = nullptr;
+  size_t blockSize = 0;
+  size_t used = 0;
+  size_t spilled = 0;
+  size_t peak = 0;
+  std::vector<unsigned char *> overflow;
+
+  void *allocateBytes(size_t bytes, size_t align);
+};
+
+#endif  // __LITE2D_FRAME_ARENA_H__
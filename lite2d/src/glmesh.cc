@@ -1,87 +1,203 @@
 #include "glmesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
 #include "debug.h"
+#include "deformer_tree.h"
+#include "vertex_quant.h"
+
+namespace
+{
+void writeUnorm16x2(uint8_t *dst, const glm::vec2 &v, const glm::vec4 &range)
+{
+  const uint16_t q[2] = {quantizeUnorm16(v.x, range.x, range.z), quantizeUnorm16(v.y, range.y, range.w)};
+  std::memcpy(dst, q, sizeof(q));
+}
+
+glm::vec4 decodeOf(const QuantRange &r)
+{
+  return {r.origin.x, r.origin.y, r.extent.x, r.extent.y};
+}
+
+// m's color as RGB8 (0xBBGGRR) if every vertex has the same, else GLMeshArena::kVertexColor.
+uint32_t constantColorOf(const ArtMesh &m)
+{
+  if (m.verts.empty())
+    return 0xFFFFFFu;
+  const glm::vec3 &c = m.verts.front().color;
+  for (const Vertex &v : m.verts)
+    if (v.color != c)
+      return GLMeshArena::kVertexColor;
+  return uint32_t(quantizeUnorm8(c.r)) | uint32_t(quantizeUnorm8(c.g)) << 8 | uint32_t(quantizeUnorm8(c.b)) << 16;
+}
+
+// Packs gm's static stream from m (kStaticStride bytes per vertex). Bone indices address the
+// deformer tree's world matrices as GLMeshArena::setBones uploads them, with the zero bone after
+// the last one; every skin kind is stored as two influences, the unused one being the zero bone
+// with weight 0. Returns whether the skinning inputs were stored exactly (GLMesh::gpuSkinnable).
+bool packStatic(const GLMesh &gm, const ArtMesh &m, const DeformerTree &tree, std::vector<uint8_t> &out)
+{
+  // The bone indices and weights are 16 bits wide in the static stream.
+  const SkinStreams &skin = m.skin;
+  bool skinnable = skin.size() == gm.vertCount && m.deformer_index.size() == m.deformers.size()
+                   && tree.size() < 0xFFFF;
+  for (size_t i = 0; skinnable && i < skin.weight0.size(); ++i)
+    skinnable = skin.weight0[i] >= 0.0f && skin.weight0[i] <= 1.0f;
+  for (size_t i = 0; skinnable && i < skin.weight1.size(); ++i)
+    skinnable = skin.weight1[i] >= 0.0f && skin.weight1[i] <= 1.0f;
+  const auto zeroBone = static_cast<uint16_t>(tree.size());
+  auto treeBone = [&](int32_t paletteIndex)
+  {
+    if (paletteIndex < 0 || size_t(paletteIndex) >= m.deformer_index.size())
+      return zeroBone;
+    const int32_t d = m.deformer_index[paletteIndex];
+    return d == DeformerTree::kNone ? zeroBone : static_cast<uint16_t>(d);
+  };
+  const bool rigid = skin.kind == SkinKind::Rigid;
+  const bool two = skin.kind == SkinKind::TwoBone;
+  const uint16_t slot16 = static_cast<uint16_t>(gm.slot);
+  const bool vertexColor = gm.color == GLMeshArena::kVertexColor;
+  out.assign(gm.vertCount * size_t(GLMeshArena::kStaticStride), 0);
+  for (size_t i = 0; i < gm.vertCount; ++i)
+  {
+    const Vertex &v = m.verts[i];
+    uint8_t *dst = out.data() + i * size_t(GLMeshArena::kStaticStride);
+    writeUnorm16x2(dst + GLMeshArena::kUVOffset, v.uv, gm.uvDecode);
+    if (vertexColor)
+    {
+      dst[GLMeshArena::kColorOffset + 0] = quantizeUnorm8(v.color.r);
+      dst[GLMeshArena::kColorOffset + 1] = quantizeUnorm8(v.color.g);
+      dst[GLMeshArena::kColorOffset + 2] = quantizeUnorm8(v.color.b);
+      dst[GLMeshArena::kColorOffset + 3] = 255;
+    }
+    std::memcpy(dst + GLMeshArena::kSlotOffset, &slot16, sizeof(slot16));
+    writeUnorm16x2(dst + GLMeshArena::kRestOffset, v.pos, gm.restDecode);
+    if (skinnable)
+    {
+      const uint16_t bones[2] = {treeBone(rigid ? skin.rigidBone : skin.bone0[i]),
+                                 two ? treeBone(skin.bone1[i]) : zeroBone};
+      const uint16_t weights[2] = {quantizeUnorm16(rigid ? 1.0f : skin.weight0[i], 0.0f, 1.0f),
+                                   quantizeUnorm16(two ? skin.weight1[i] : 0.0f, 0.0f, 1.0f)};
+      std::memcpy(dst + GLMeshArena::kBonesOffset, bones, sizeof(bones));
+      std::memcpy(dst + GLMeshArena::kWeightsOffset, weights, sizeof(weights));
+    }
+  }
+  return skinnable;
+}
+} // namespace
 
 /**
  * Create the GL mesh from the given ArtMesh.
  * @param m The ArtMesh to create from.
+ * @param tree The deformer tree the bone indices in the static stream refer to.
+ * @param meshArena The arena to place its vertices and indices in.
  */
-void GLMesh::create(const ArtMesh &m)
+void GLMesh::create(const ArtMesh &m, const DeformerTree &tree, GLMeshArena &meshArena)
 {
+  arena = &meshArena;
   vertCount = m.verts.size();
   idxCount = m.indices.size();
+  indexType = indexTypeFor(vertCount);
+  source.valid = false;
+  slot = arena->allocateSlot();
 
-  cpuInterleaved.reserve(vertCount * 7);
-  for (auto &v : m.verts)
+  if (!m.verts.empty())
   {
-    cpuInterleaved.push_back(v.pos.x);
-    cpuInterleaved.push_back(v.pos.y);
-    cpuInterleaved.push_back(v.uv.x);
-    cpuInterleaved.push_back(v.uv.y);
-    cpuInterleaved.push_back(v.color.r);
-    cpuInterleaved.push_back(v.color.g);
-    cpuInterleaved.push_back(v.color.b);
+    posDecode = decodeOf(quantRangeOf(&m.verts[0].pos, vertCount, sizeof(Vertex)));
+    uvDecode = decodeOf(quantRangeOf(&m.verts[0].uv, vertCount, sizeof(Vertex)));
+    restDecode = posDecode;
   }
+  color = constantColorOf(m);
+  std::vector<uint8_t> staticData;
+  gpuSkinnable = packStatic(*this, m, tree, staticData);
+  skinGeneration = tree.generation();
+  cpuPositions.assign(vertCount * size_t(GLMeshArena::kPosStride), 0);
+  for (size_t i = 0; i < vertCount; ++i)
+    writeUnorm16x2(cpuPositions.data() + i * size_t(GLMeshArena::kPosStride), m.verts[i].pos, posDecode);
 
-  glGenVertexArrays(1, &vao);
-  glGenBuffers(1, &vbo);
-  glGenBuffers(1, &ebo);
-
-  glBindVertexArray(vao);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, cpuInterleaved.size() * sizeof(float),
-               cpuInterleaved.data(), GL_DYNAMIC_DRAW);
-
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, idxCount * sizeof(uint32_t),
-               m.indices.data(), GL_STATIC_DRAW);
-
-  glEnableVertexAttribArray(0); // pos
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void *)0);
-  glEnableVertexAttribArray(1); // uv
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void *)(2 * sizeof(float)));
-  glEnableVertexAttribArray(2); // color
-  glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void *)(4 * sizeof(float)));
-
-  glBindVertexArray(0);
+  // Positions reach the GPU through the ring, when the mesh is first streamed.
+  if (vertCount > 0)
+  {
+    firstVertex = arena->allocateVertices(vertCount);
+    arena->uploadStatic(firstVertex, staticData.data(), vertCount);
+  }
+  if (idxCount > 0)
+  {
+    indexOffset = arena->allocateIndices(indexBytes(), indexSize(indexType));
+    if (indexType == GL_UNSIGNED_SHORT)
+    {
+      std::vector<uint16_t> idx16(m.indices.begin(), m.indices.end());
+      arena->uploadIndices(indexOffset, idx16.data(), indexBytes());
+    }
+    else
+    {
+      arena->uploadIndices(indexOffset, m.indices.data(), indexBytes());
+    }
+  }
 }
 
-void GLMesh::updatePositions(const std::vector<glm::vec2> &pos)
+void GLMesh::encodeSkin(const ArtMesh &m, const DeformerTree &tree)
 {
-  if (pos.size() != vertCount)
+  if (!arena || m.verts.size() != vertCount)
     return;
+  std::vector<uint8_t> staticData;
+  gpuSkinnable = packStatic(*this, m, tree, staticData);
+  skinGeneration = tree.generation();
+  if (vertCount > 0)
+    arena->uploadStatic(firstVertex, staticData.data(), vertCount);
+}
 
-  for (size_t i = 0; i < vertCount; ++i)
+/**
+ * Release the arena ranges and CPU copy of the mesh.
+ */
+void GLMesh::destroy()
+{
+  if (arena)
   {
-    cpuInterleaved[i * 7 + 0] = pos[i].x;
-    cpuInterleaved[i * 7 + 1] = pos[i].y;
+    if (vertCount > 0)
+      arena->releaseVertices(firstVertex, vertCount);
+    if (idxCount > 0)
+      arena->releaseIndices(indexOffset, indexBytes());
+    arena->releaseSlot(slot);
   }
+  arena = nullptr;
+  firstVertex = indexOffset = 0;
+  vertCount = idxCount = 0;
+  cpuPositions.clear();
+  cpuPositions.shrink_to_fit();
+  source = GLMeshSource{};
+}
 
-  glBindVertexArray(vao);
-#if defined(LITE2D_DEBUG) && LITE2D_DEBUG
-  checkErr("updpos: after VAO bind");
-#endif
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-#if defined(LITE2D_DEBUG) && LITE2D_DEBUG
-  checkErr("updpos: after VBO bind");
-#endif
-
-  glBufferSubData(GL_ARRAY_BUFFER, 0,
-                  cpuInterleaved.size() * sizeof(float),
-                  cpuInterleaved.data());
-#if defined(LITE2D_DEBUG) && LITE2D_DEBUG
-  checkErr("updpos: after BufferSubData");
-#endif
+bool GLMesh::packPositions(std::span<const glm::vec2> pos)
+{
+  if (pos.size() != vertCount)
+    return false;
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  // Positions are re-quantized against this frame's bounds; Engine::render passes the new range.
+  if (vertCount > 0)
+    posDecode = decodeOf(quantRangeOf(pos.data(), vertCount));
+  for (size_t i = 0; i < vertCount; ++i)
+    writeUnorm16x2(cpuPositions.data() + i * size_t(GLMeshArena::kPosStride), pos[i], posDecode);
+  ++packedVersion;
+  return true;
 }
 
-void GLMesh::draw() const
+size_t GLMesh::stream()
 {
-  glBindVertexArray(vao);
-  glDrawElements(GL_TRIANGLES, (GLsizei)idxCount, GL_UNSIGNED_INT, 0);
-#if defined(LITE2D_DEBUG) && LITE2D_DEBUG
-  checkErr("after draw");
-#endif
+  uint8_t *region = arena ? arena->regionData() : nullptr;
+  if (!region || cpuPositions.empty())
+    return 0;
+  if (ringGeneration != arena->generation())
+  {
+    std::fill(std::begin(regionVersion), std::end(regionVersion), 0u);
+    ringGeneration = arena->generation();
+  }
+  uint32_t &version = regionVersion[arena->region()];
+  if (version == packedVersion)
+    return 0;
+  std::memcpy(region + firstVertex * size_t(GLMeshArena::kPosStride), cpuPositions.data(), cpuPositions.size());
+  version = packedVersion;
+  return cpuPositions.size();
 }
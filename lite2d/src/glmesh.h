@@ -3,6 +3,7 @@
 #define __LITE2D_GLMESH_H__
 
 #include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -10,6 +11,13 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "glmesh_arena.h"
+#include "keyforms.h"
+#include "mesh_pose.h"
+#include "skinning.h"
+
+class DeformerTree;
+
 // ---------- Mesh data with skinning & clipping ----------
 
 /**
@@ -41,6 +49,10 @@ struct Vertex
  * @param verts The list of vertices in the mesh.
  * @param indices The list of indices defining the mesh triangles.
  * @param deformers The list of leaf deformers used in bone indices.
+ * @param deformer_index Model::deformerTree index of each entry of deformers, set by Model::buildDeformerTree.
+ * @param regions MeshRegion bits (eye, mouth, brow, face, body, seam) set by classifyMeshRegions.
+ * @param skin SoA copy of the skinning inputs, set by buildSkinStreams.
+ * @param keyforms Parameter-driven shape offsets, applied to the rest positions before skinning.
  */
 struct ArtMesh
 {
@@ -54,25 +66,101 @@ struct ArtMesh
   std::vector<Vertex> verts;
   std::vector<uint32_t> indices;
   std::vector<std::string> deformers; // leaf deformers used in bone indices
+  std::vector<int32_t> deformer_index; // DeformerTree::kNone if not in the tree
+  uint32_t regions = 0;               // MeshRegion bits
+  SkinStreams skin;
+  MeshKeyforms keyforms;
+};
+
+/**
+ * Inputs the positions in a GLMesh's buffer were computed from. Engine::update compares a mesh's
+ * current inputs against them and skips meshes where nothing changed.
+ * @param palette Skinning palette (deformer world matrices) before the pose was folded in.
+ * @param pose Region pose.
+ * @param keyformWeights Keyform weights.
+ * @param kernel Skinning kernel.
+ * @param valid False until positions have been computed for this buffer.
+ */
+struct GLMeshSource
+{
+  std::vector<SkinBone> palette;
+  MeshPose pose;
+  std::vector<float> keyformWeights;
+  SkinKernel kernel = SkinKernel::Scalar;
+  bool valid = false;
 };
 
 /**
- * Represents an OpenGL mesh for rendering.
- * @param vao The OpenGL Vertex Array Object ID.
- * @param vbo The OpenGL Vertex Buffer Object ID.
- * @param ebo The OpenGL Element Buffer Object ID.
+ * Represents an OpenGL mesh for rendering: its share of a GLMeshArena.
+ * Vertices are packed in the arena's two streams: UV, color, draw data slot and skinning inputs go
+ * to the static stream once, in create(); 16-bit unorm positions relative to posDecode are
+ * streamed every frame they change, from cpuPositions. A mesh with one color throughout keeps it
+ * in color and draws with it from its draw data instead of the per-vertex color.
+ * @param arena The arena holding the mesh's vertices and indices.
+ * @param firstVertex The mesh's first vertex in the arena (its base vertex).
  * @param vertCount The number of vertices in the mesh.
+ * @param indexOffset Byte offset of the mesh's indices in the arena's index buffer.
  * @param idxCount The number of indices in the mesh.
- * @param cpuInterleaved The CPU-side interleaved vertex data.
+ * @param indexType GL_UNSIGNED_SHORT when every index fits in 16 bits, else GL_UNSIGNED_INT.
+ * @param slot The mesh's draw data slot in the arena.
+ * @param posDecode Range of the last uploaded positions (origin.xy, extent.zw).
+ * @param uvDecode Range of the UVs (origin.xy, extent.zw).
+ * @param restDecode Range of the rest positions in the static stream (origin.xy, extent.zw).
+ * @param color The mesh's RGB8 color (0xBBGGRR) when it is the same for every vertex, else
+ *              GLMeshArena::kVertexColor and the static stream holds it per vertex.
+ * @param gpuSkinnable Whether the static stream holds the mesh's skinning inputs exactly (skin
+ *                     streams and deformer indices current, weights within [0, 1]), so the vertex
+ *                     shader can skin it.
+ * @param skinGeneration DeformerTree::generation() the static stream's bone indices refer to.
+ * @param cpuPositions The CPU-side packed positions (kPosStride bytes per vertex).
+ * @param packedVersion Bumped whenever cpuPositions changes.
+ * @param regionVersion packedVersion last streamed into each ring region of the arena.
+ * @param ringGeneration GLMeshArena::generation() regionVersion refers to.
+ * @param source Inputs of the positions last packed into cpuPositions.
  */
 struct GLMesh
 {
-  GLuint vao { 0 }, vbo { 0 }, ebo { 0 };
-  size_t vertCount { 0 }, idxCount { 0 };
-  std::vector<float> cpuInterleaved;
-  void create(const ArtMesh &m);
-  void updatePositions(const std::vector<glm::vec2> &pos);
-  void draw() const;
+  GLMeshArena *arena { nullptr };
+  size_t firstVertex { 0 }, vertCount { 0 };
+  size_t indexOffset { 0 }, idxCount { 0 };
+  GLenum indexType { GL_UNSIGNED_INT };
+  uint32_t slot { 0 };
+  glm::vec4 posDecode { 0.0f };
+  glm::vec4 uvDecode { 0.0f };
+  glm::vec4 restDecode { 0.0f };
+  uint32_t color { GLMeshArena::kVertexColor };
+  bool gpuSkinnable { false };
+  uint32_t skinGeneration { 0 };
+  std::vector<uint8_t> cpuPositions;
+  uint32_t packedVersion { 1 };
+  uint32_t regionVersion[GLMeshArena::kRingRegions] {};
+  uint32_t ringGeneration { 0 };
+  GLMeshSource source;
+  void create(const ArtMesh &m, const DeformerTree &tree, GLMeshArena &arena);
+  // Re-packs the static stream after the deformer tree was rebuilt (tree.generation() differs
+  // from skinGeneration), so the bone indices point at the right world matrices again.
+  void encodeSkin(const ArtMesh &m, const DeformerTree &tree);
+  // Returns the mesh's ranges and slot to the arena.
+  void destroy();
+  // Neither touches GL, so distinct meshes can be packed and streamed on worker threads.
+  bool packPositions(std::span<const glm::vec2> pos);
+  // Copies cpuPositions into the arena's writable ring region unless the region already has it;
+  // returns the bytes copied. Between GLMeshArena::beginFrame and endWrites only.
+  size_t stream();
+  // Bytes of vertex and index data held on the GPU (vertices counting one ring region).
+  size_t vertexBytes() const { return vertCount * size_t(GLMeshArena::kStaticStride + GLMeshArena::kPosStride); }
+  size_t indexBytes() const { return idxCount * indexSize(indexType); }
+
+  // Index type create() picks for a mesh of vertCount vertices, and its size in bytes.
+  static GLenum indexTypeFor(size_t vertCount) { return vertCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+  static size_t indexSize(GLenum type) { return type == GL_UNSIGNED_SHORT ? 2 : 4; }
+  // Bytes create() makes resident for m: its static stream, its positions in every ring region and
+  // its indices. Engine::update budgets first-time uploads with it.
+  static size_t residentBytes(const ArtMesh &m)
+  {
+    return m.verts.size() * size_t(GLMeshArena::kStaticStride + GLMeshArena::kPosStride * GLMeshArena::kRingRegions)
+           + m.indices.size() * indexSize(indexTypeFor(m.verts.size()));
+  }
 };
 
 #endif  // __LITE2D_GLMESH_H__
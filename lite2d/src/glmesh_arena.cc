@@ -0,0 +1,458 @@
+#include "glmesh_arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ARB_buffer_storage / GL 4.4; the bundled GLAD only covers GL 3.3.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace
+{
+// Smallest buffers the arena starts with, so the first few meshes do not each grow it.
+constexpr size_t kMinVertexCapacity = 16 * 1024;
+constexpr size_t kMinIndexCapacity = 64 * 1024;
+
+size_t alignUp(size_t v, size_t align)
+{
+  return (v + align - 1) / align * align;
+}
+
+// Uploads rows to a buffer texture of RGBA32F texels, growing it with room to spare. The store is
+// orphaned first: earlier frames' draws may still read the old one, and writing into it would
+// make the driver wait for them.
+void uploadRows(GLuint buffer, GLuint texture, size_t &capacityRows, const std::vector<glm::vec4> &rows)
+{
+  if (rows.empty())
+    return;
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+  // The buffer texture refers to the buffer object, so it only needs attaching once.
+  const bool attach = capacityRows == 0;
+  if (rows.size() > capacityRows)
+    capacityRows = std::max(rows.size(), capacityRows * 2);
+  glBufferData(GL_TEXTURE_BUFFER, capacityRows * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+  if (attach)
+  {
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+  }
+  glBufferSubData(GL_TEXTURE_BUFFER, 0, rows.size() * sizeof(glm::vec4), rows.data());
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+bool hasBufferStorage()
+{
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (major > 4 || (major == 4 && minor >= 4))
+    return true;
+  GLint extensions = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+  for (GLint i = 0; i < extensions; ++i)
+  {
+    const auto *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+    if (name && std::strcmp(name, "GL_ARB_buffer_storage") == 0)
+      return true;
+  }
+  return false;
+}
+} // namespace
+
+size_t GLMeshArena::RangeList::allocate(size_t size, size_t align)
+{
+  for (size_t i = 0; i < free.size(); ++i)
+  {
+    const auto [offset, freeSize] = free[i];
+    const size_t start = alignUp(offset, align);
+    if (start + size > offset + freeSize)
+      continue;
+    // Keep what is left on either side of the new range.
+    const size_t tail = offset + freeSize - (start + size);
+    if (start > offset)
+    {
+      free[i].second = start - offset;
+      if (tail > 0)
+        free.insert(free.begin() + i + 1, {start + size, tail});
+    }
+    else if (tail > 0)
+    {
+      free[i] = {start + size, tail};
+    }
+    else
+    {
+      free.erase(free.begin() + i);
+    }
+    return start;
+  }
+  return kNoRange;
+}
+
+void GLMeshArena::RangeList::release(size_t offset, size_t size)
+{
+  if (size == 0)
+    return;
+  auto it = std::lower_bound(free.begin(), free.end(), std::make_pair(offset, size_t(0)));
+  it = free.insert(it, {offset, size});
+  // Merge with the following range, then with the preceding one.
+  if (auto next = it + 1; next != free.end() && it->first + it->second == next->first)
+  {
+    it->second += next->second;
+    free.erase(next);
+  }
+  if (it != free.begin())
+  {
+    auto prev = it - 1;
+    if (prev->first + prev->second == it->first)
+    {
+      prev->second += it->second;
+      free.erase(it);
+    }
+  }
+}
+
+void GLMeshArena::RangeList::grow(size_t newCapacity)
+{
+  if (newCapacity <= capacity)
+    return;
+  const size_t oldCapacity = capacity;
+  capacity = newCapacity;
+  release(oldCapacity, newCapacity - oldCapacity);
+}
+
+void GLMeshArena::createObjects()
+{
+  if (vaos[0])
+    return;
+  glGenVertexArrays(GLsizei(kRingRegions), vaos);
+  glGenBuffers(1, &drawBuffer);
+  glGenTextures(1, &drawTexture);
+  glGenBuffers(1, &boneBuffer);
+  glGenTextures(1, &boneTexture);
+}
+
+void GLMeshArena::setVertexFormat() const
+{
+  // Only the position stream differs between regions; the static stream is read from vertex 0 in
+  // every one of them, so draws pass just the mesh's first vertex as the base vertex.
+  for (uint32_t r = 0; r < kRingRegions; ++r)
+  {
+    glBindVertexArray(vaos[r]);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(0); // pos
+    glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_TRUE, kPosStride,
+                          (void *)(size_t(r) * vertexRanges.capacity * kPosStride));
+    glBindBuffer(GL_ARRAY_BUFFER, staticVbo);
+    glEnableVertexAttribArray(1); // uv
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, kStaticStride, (void *)kUVOffset);
+    glEnableVertexAttribArray(2); // color
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, kStaticStride, (void *)kColorOffset);
+    glEnableVertexAttribArray(3); // draw data slot
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_SHORT, kStaticStride, (void *)kSlotOffset);
+    glEnableVertexAttribArray(4); // rest position
+    glVertexAttribPointer(4, 2, GL_UNSIGNED_SHORT, GL_TRUE, kStaticStride, (void *)kRestOffset);
+    glEnableVertexAttribArray(5); // palette indices
+    glVertexAttribIPointer(5, 2, GL_UNSIGNED_SHORT, kStaticStride, (void *)kBonesOffset);
+    glEnableVertexAttribArray(6); // weights
+    glVertexAttribPointer(6, 2, GL_UNSIGNED_SHORT, GL_TRUE, kStaticStride, (void *)kWeightsOffset);
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GLMeshArena::initStreaming(GLADloadproc getProc, bool allowPersistent)
+{
+  bufferStorage = nullptr;
+  if (allowPersistent && getProc && hasBufferStorage())
+    bufferStorage = reinterpret_cast<BufferStorageFn>(getProc("glBufferStorage"));
+  mode = bufferStorage ? Streaming::Persistent : Streaming::Mapped;
+  if (vbo)
+    createRing(vertexRanges.capacity);
+}
+
+void GLMeshArena::createRing(size_t capacity)
+{
+  createObjects();
+  if (vbo)
+  {
+    if (ringData)
+    {
+      glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+      glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    glDeleteBuffers(1, &vbo);
+  }
+  for (GLsync &fence : fences)
+  {
+    if (fence)
+      glDeleteSync(fence);
+    fence = nullptr;
+  }
+  ringData = regionPtr = nullptr;
+
+  const GLsizeiptr bytes = GLsizeiptr(capacity * kPosStride * kRingRegions);
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+  if (mode == Streaming::Persistent)
+  {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    bufferStorage(GL_COPY_WRITE_BUFFER, bytes, nullptr, flags);
+    ringData = static_cast<uint8_t *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bytes, flags));
+    if (!ringData)
+    {
+      // Immutable storage cannot be respecified; start over with a mutable buffer.
+      glDeleteBuffers(1, &vbo);
+      glGenBuffers(1, &vbo);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+      mode = Streaming::Mapped;
+    }
+  }
+  if (mode == Streaming::Mapped)
+    glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  // The regions start empty; every mesh refills them from its CPU copy.
+  ++ringGeneration;
+  setVertexFormat();
+}
+
+void GLMeshArena::growVertices(size_t capacity)
+{
+  createObjects();
+  GLuint next = 0;
+  glGenBuffers(1, &next);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, next);
+  glBufferData(GL_COPY_WRITE_BUFFER, capacity * kStaticStride, nullptr, GL_STATIC_DRAW);
+  if (staticVbo)
+  {
+    glBindBuffer(GL_COPY_READ_BUFFER, staticVbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, vertexRanges.capacity * kStaticStride);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &staticVbo);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  staticVbo = next;
+  vertexRanges.grow(capacity);
+  createRing(capacity);
+}
+
+void GLMeshArena::growIndices(size_t capacity)
+{
+  createObjects();
+  GLuint next = 0;
+  glGenBuffers(1, &next);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, next);
+  glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+  if (ebo)
+  {
+    glBindBuffer(GL_COPY_READ_BUFFER, ebo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, indexRanges.capacity);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &ebo);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  ebo = next;
+  indexRanges.grow(capacity);
+  // The element buffer binding is part of each vertex array.
+  for (GLuint vao : vaos)
+  {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  }
+  glBindVertexArray(0);
+}
+
+void GLMeshArena::reserve(size_t vertices, size_t indexBytes)
+{
+  if (vertices > vertexRanges.capacity)
+    growVertices(std::max(vertices, kMinVertexCapacity));
+  if (indexBytes > indexRanges.capacity)
+    growIndices(std::max(indexBytes, kMinIndexCapacity));
+}
+
+size_t GLMeshArena::allocateVertices(size_t count)
+{
+  size_t first = vertexRanges.allocate(count, 1);
+  if (first == kNoRange)
+  {
+    growVertices(std::max({vertexRanges.capacity * 2, vertexRanges.capacity + count, kMinVertexCapacity}));
+    first = vertexRanges.allocate(count, 1);
+  }
+  return first;
+}
+
+void GLMeshArena::releaseVertices(size_t first, size_t count)
+{
+  vertexRanges.release(first, count);
+}
+
+size_t GLMeshArena::allocateIndices(size_t bytes, size_t align)
+{
+  size_t offset = indexRanges.allocate(bytes, align);
+  if (offset == kNoRange)
+  {
+    growIndices(std::max({indexRanges.capacity * 2, indexRanges.capacity + bytes + align, kMinIndexCapacity}));
+    offset = indexRanges.allocate(bytes, align);
+  }
+  return offset;
+}
+
+void GLMeshArena::releaseIndices(size_t offset, size_t bytes)
+{
+  indexRanges.release(offset, bytes);
+}
+
+uint32_t GLMeshArena::allocateSlot()
+{
+  if (!freeSlots.empty())
+  {
+    const uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+  }
+  drawData.resize((slotCount + 1) * kDrawDataRows, glm::vec4(0.0f));
+  return slotCount++;
+}
+
+void GLMeshArena::releaseSlot(uint32_t slot)
+{
+  freeSlots.push_back(slot);
+}
+
+void GLMeshArena::uploadIndices(size_t offset, const void *data, size_t bytes)
+{
+  if (bytes == 0)
+    return;
+  glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, data);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GLMeshArena::uploadStatic(size_t first, const void *data, size_t count)
+{
+  if (count == 0)
+    return;
+  glBindBuffer(GL_COPY_WRITE_BUFFER, staticVbo);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(first * kStaticStride), GLsizeiptr(count * kStaticStride), data);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GLMeshArena::setDrawData(uint32_t slot, const glm::vec4 &posDecode, const glm::vec4 &uvDecode, float opacity,
+                              uint32_t color)
+{
+  glm::vec4 *rows = drawData.data() + size_t(slot) * kDrawDataRows;
+  rows[0] = posDecode;
+  rows[1] = uvDecode;
+  // 24 bits of color are exact in a float.
+  if (color == kVertexColor)
+    rows[3] = glm::vec4(opacity, -1.0f, 0.0f, 0.0f);
+  else
+    rows[3] = glm::vec4(opacity, -1.0f, float(color & 0xFFFFFFu), 1.0f);
+}
+
+void GLMeshArena::setSkinning(uint32_t slot, const glm::vec4 &restDecode, const SkinBone &pose)
+{
+  glm::vec4 *rows = drawData.data() + size_t(slot) * kDrawDataRows;
+  rows[2] = restDecode;
+  rows[3].y = 1.0f;
+  rows[4] = glm::vec4(pose.a, pose.b, pose.c, pose.d);
+  rows[5] = glm::vec4(pose.tx, pose.ty, 0.0f, 0.0f);
+}
+
+void GLMeshArena::setBones(std::span<const glm::mat3> worlds)
+{
+  bones.resize((worlds.size() + 1) * kBoneRows);
+  glm::vec4 *rows = bones.data();
+  for (const glm::mat3 &world : worlds)
+  {
+    const SkinBone bone = toSkinBone(world);
+    *rows++ = glm::vec4(bone.a, bone.b, bone.c, bone.d);
+    *rows++ = glm::vec4(bone.tx, bone.ty, 0.0f, 0.0f);
+  }
+  rows[0] = glm::vec4(0.0f);
+  rows[1] = glm::vec4(0.0f);
+}
+
+void GLMeshArena::uploadDrawData()
+{
+  uploadRows(drawBuffer, drawTexture, drawBufferRows, drawData);
+  uploadRows(boneBuffer, boneTexture, boneBufferRows, bones);
+}
+
+void GLMeshArena::bind(GLuint textureUnit) const
+{
+  glBindVertexArray(vaos[frameRegion]);
+  glActiveTexture(GL_TEXTURE0 + textureUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, drawTexture);
+  glActiveTexture(GL_TEXTURE0 + textureUnit + 1);
+  glBindTexture(GL_TEXTURE_BUFFER, boneTexture);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+void GLMeshArena::beginFrame()
+{
+  if (!vbo)
+    return;
+  frameRegion = (frameRegion + 1) % kRingRegions;
+  if (GLsync fence = fences[frameRegion])
+  {
+    // Drawn kRingRegions frames ago; normally finished long since.
+    GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+      ++stallCount;
+      while (status == GL_TIMEOUT_EXPIRED)
+        status = glClientWaitSync(fence, 0, 1000000);
+    }
+    glDeleteSync(fence);
+    fences[frameRegion] = nullptr;
+  }
+
+  const size_t regionBytes = vertexRanges.capacity * kPosStride;
+  if (mode == Streaming::Persistent)
+  {
+    regionPtr = ringData + frameRegion * regionBytes;
+    return;
+  }
+  // The fence already keeps the GPU off this region, so the map does not need to synchronize.
+  glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+  regionPtr = static_cast<uint8_t *>(
+      glMapBufferRange(GL_COPY_WRITE_BUFFER, GLintptr(frameRegion * regionBytes), GLsizeiptr(regionBytes),
+                       GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GLMeshArena::flush(size_t first, size_t count)
+{
+  // Coherent persistent mappings need no flush.
+  if (mode != Streaming::Mapped || !regionPtr || count == 0)
+    return;
+  glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+  glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, GLintptr(first * kPosStride), GLsizeiptr(count * kPosStride));
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GLMeshArena::endWrites()
+{
+  if (mode == Streaming::Mapped && regionPtr)
+  {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    if (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_FALSE)
+      ++ringGeneration; // contents lost (display mode change and the like); refill every region
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+  regionPtr = nullptr;
+}
+
+void GLMeshArena::fenceFrame()
+{
+  if (!vbo)
+    return;
+  if (fences[frameRegion])
+    glDeleteSync(fences[frameRegion]);
+  fences[frameRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
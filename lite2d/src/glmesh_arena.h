@@ -0,0 +1,185 @@
+#ifndef __LITE2D_GLMESH_ARENA_H__
+#pragma once
+#define __LITE2D_GLMESH_ARENA_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "skinning.h"
+
+/**
+ * Two vertex buffers and one index buffer shared by every GLMesh. Each mesh owns a range of
+ * vertices and a range of index bytes and is drawn with its first vertex as the base vertex, so
+ * drawing never switches buffers. Per-mesh draw constants (decode ranges, opacity, GPU
+ * skinning pose) are rows of a buffer texture, found through a slot stored in every vertex;
+ * meshes drawn with the same GL state can therefore go out in one glMultiDrawElementsBaseVertex.
+ *
+ * Vertices are split into two streams. The static stream (kStaticStride bytes) is written once
+ * when a mesh is created: UV as 16-bit unorm within the mesh's UV range, RGBA8 color (left zero
+ * when the mesh has one color throughout; that color goes to its draw data), 16-bit slot,
+ * 2 bytes padding, then the skinning inputs: rest position as 16-bit unorm within the rest range,
+ * two 16-bit deformer indices and two 16-bit unorm weights. The dynamic stream holds only
+ * CPU-skinned positions (kPosStride bytes: 16-bit unorm within the mesh's position range), the one
+ * thing a frame changes. The slot limits the arena to 65536 resident meshes.
+ *
+ * Meshes skinned on the GPU ignore the dynamic stream: the deformers' world matrices go to a
+ * second buffer texture once per frame (setBones), shared by every mesh, and the vertex shader
+ * blends them over the rest positions.
+ *
+ * Positions are streamed through a ring: the position buffer holds kRingRegions copies of the
+ * vertex range, and each frame writes and draws one of them while the GPU may still read the
+ * others. A fence after each frame's draws tells beginFrame() when a region can be written again.
+ * Each region has its own vertex array, with the position attribute pointing at the region and
+ * the static attributes at the start of the static buffer, so the base vertex never has to carry
+ * the region offset (which would push the static reads past the end of their buffer).
+ * Meshes copy their packed positions straight into the mapped region (GLMesh::stream) from any
+ * thread, and only where that region is older than the mesh, so unchanged meshes cost nothing once
+ * all regions caught up. With GL 4.4 or ARB_buffer_storage the ring is mapped once, persistently
+ * and coherently; otherwise the frame's region is mapped unsynchronized in beginFrame() and
+ * unmapped in endWrites().
+ *
+ * The static and index buffers grow by copying on the GPU when a range does not fit; the ring is
+ * recreated and refilled from the meshes' CPU copies of their positions. GL objects are created on
+ * the first allocation, so an arena that never gets a mesh (a staging Engine) never touches GL.
+ */
+class GLMeshArena
+{
+public:
+  static constexpr GLsizei kPosStride = 4;
+  static constexpr GLsizei kStaticStride = 24;
+  static constexpr size_t kUVOffset = 0;
+  static constexpr size_t kColorOffset = 4;
+  static constexpr size_t kSlotOffset = 8;
+  static constexpr size_t kRestOffset = 12;
+  static constexpr size_t kBonesOffset = 16;
+  static constexpr size_t kWeightsOffset = 20;
+  // vec4 rows of draw data per slot: position decode, UV decode, rest decode, (opacity, 1 if
+  // skinned on the GPU or -1 for CPU-skinned positions, constant color as 0xBBGGRR, 1 if the
+  // color is constant or 0 to read it per vertex), pose (a, b, c, d), pose (tx, ty, 0, 0).
+  static constexpr size_t kDrawDataRows = 6;
+  // Color passed to setDrawData for meshes whose static stream holds a color per vertex.
+  static constexpr uint32_t kVertexColor = ~0u;
+  // vec4 rows per bone: (a, b, c, d), (tx, ty, 0, 0).
+  static constexpr size_t kBoneRows = 2;
+  static constexpr size_t kNoRange = ~size_t(0);
+  static constexpr uint32_t kRingRegions = 3;
+
+  enum class Streaming
+  {
+    Persistent, // glBufferStorage, mapped once
+    Mapped,     // glMapBufferRange of the frame's region, every frame
+  };
+
+  GLMeshArena() = default;
+  GLMeshArena(const GLMeshArena &) = delete;
+  GLMeshArena &operator=(const GLMeshArena &) = delete;
+  ~GLMeshArena() = default;
+
+  // Uses persistent mapping if allowed and the context supports it, loading glBufferStorage
+  // through getProc (the loader GLAD was initialized with). Call once the context is current.
+  void initStreaming(GLADloadproc getProc, bool allowPersistent = true);
+  Streaming streaming() const { return mode; }
+
+  // Grows both buffers to hold at least this much in total, in one step.
+  void reserve(size_t vertices, size_t indexBytes);
+
+  // A range of count vertices; returns its first vertex.
+  size_t allocateVertices(size_t count);
+  void releaseVertices(size_t first, size_t count);
+  // A range of bytes index bytes aligned to align; returns its byte offset.
+  size_t allocateIndices(size_t bytes, size_t align);
+  void releaseIndices(size_t offset, size_t bytes);
+  uint32_t allocateSlot();
+  void releaseSlot(uint32_t slot);
+
+  void uploadIndices(size_t offset, const void *data, size_t bytes);
+  // Static stream data (kStaticStride bytes per vertex) of count vertices from first.
+  void uploadStatic(size_t first, const void *data, size_t count);
+
+  // Frame protocol, on the GL thread: beginFrame() moves to the next region, waiting for the GPU
+  // if it still reads it, and makes it writable; meshes are then streamed (any thread); flush()
+  // publishes each written range and endWrites() ends writing, both before drawing; fenceFrame()
+  // after the frame's draws. Allocating vertices between beginFrame() and endWrites() is not allowed.
+  void beginFrame();
+  void flush(size_t first, size_t count);
+  void endWrites();
+  void fenceFrame();
+
+  // The writable region between beginFrame() and endWrites(), or null.
+  uint8_t *regionData() const { return regionPtr; }
+  uint32_t region() const { return frameRegion; }
+  // Changes when the ring is recreated and every region has to be refilled.
+  uint32_t generation() const { return ringGeneration; }
+  // Frames whose beginFrame() had to wait for the GPU.
+  uint64_t stalls() const { return stallCount; }
+
+  // Draw constants of slot for the next uploadDrawData(), drawing CPU-skinned positions. color is
+  // the mesh's RGB8 color (0xBBGGRR), or kVertexColor to use the static stream's.
+  void setDrawData(uint32_t slot, const glm::vec4 &posDecode, const glm::vec4 &uvDecode, float opacity,
+                   uint32_t color);
+  // Switches slot to GPU skinning for this frame: the rest positions blended by the bones (see
+  // setBones), then transformed by pose. Call after setDrawData.
+  void setSkinning(uint32_t slot, const glm::vec4 &restDecode, const SkinBone &pose);
+  // This frame's bones: the deformer world matrices in DeformerTree order, then the zero bone.
+  void setBones(std::span<const glm::mat3> worlds);
+  // No mesh is skinned on the GPU this frame; nothing is uploaded for the bones.
+  void clearBones() { bones.clear(); }
+  size_t boneCount() const { return bones.size() / kBoneRows; }
+  // Uploads the draw data and the bones, each into a freshly orphaned store so that the upload
+  // never waits for the previous frames' draws.
+  void uploadDrawData();
+
+  // Binds the current region's vertex array, the draw data buffer texture to texture unit textureUnit and the bones
+  // to textureUnit + 1.
+  void bind(GLuint textureUnit) const;
+
+  size_t vertexCapacity() const { return vertexRanges.capacity; }
+  size_t indexCapacity() const { return indexRanges.capacity; }
+
+private:
+  // First-fit free list over [0, capacity), kept sorted and coalesced.
+  struct RangeList
+  {
+    std::vector<std::pair<size_t, size_t>> free; // offset, size
+    size_t capacity = 0;
+
+    size_t allocate(size_t size, size_t align);
+    void release(size_t offset, size_t size);
+    void grow(size_t newCapacity);
+  };
+
+  using BufferStorageFn = void(APIENTRYP)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+  GLuint vaos[kRingRegions] = {};  // one per ring region, differing in the position offset
+  GLuint vbo = 0, staticVbo = 0, ebo = 0;
+  GLuint drawBuffer = 0, drawTexture = 0;
+  GLuint boneBuffer = 0, boneTexture = 0;
+  Streaming mode = Streaming::Mapped;
+  BufferStorageFn bufferStorage = nullptr;
+  uint8_t *ringData = nullptr;   // whole ring, persistent mode
+  uint8_t *regionPtr = nullptr;
+  uint32_t frameRegion = 0;
+  uint32_t ringGeneration = 1;
+  GLsync fences[kRingRegions] = {};
+  uint64_t stallCount = 0;
+  RangeList vertexRanges, indexRanges;
+  std::vector<uint32_t> freeSlots;
+  uint32_t slotCount = 0;
+  size_t drawBufferRows = 0, boneBufferRows = 0;
+  std::vector<glm::vec4> drawData;
+  std::vector<glm::vec4> bones;
+
+  void createObjects();
+  void setVertexFormat() const;
+  void growVertices(size_t capacity);
+  void createRing(size_t capacity);
+  void growIndices(size_t capacity);
+};
+
+#endif  // __LITE2D_GLMESH_ARENA_H__
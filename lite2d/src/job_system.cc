@@ -0,0 +1,140 @@
+#include "job_system.h"
+
+bool JobSystem::Queue::push(const Job &job)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  if (tail - head == kCapacity)
+    return false;
+  jobs[tail++ % kCapacity] = job;
+  return true;
+}
+
+bool JobSystem::Queue::pop(Job &job)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  if (tail == head)
+    return false;
+  job = jobs[--tail % kCapacity];
+  return true;
+}
+
+bool JobSystem::Queue::steal(Job &job)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  if (tail == head)
+    return false;
+  job = jobs[head++ % kCapacity];
+  return true;
+}
+
+JobSystem::JobSystem(unsigned threads)
+{
+  setThreadCount(threads);
+}
+
+JobSystem::~JobSystem()
+{
+  stop();
+}
+
+void JobSystem::setThreadCount(unsigned threads)
+{
+  stop();
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threadTotal = threads;
+  queues.clear();
+}
+
+void JobSystem::start()
+{
+  if (!workers.empty() || threadTotal <= 1)
+    return;
+  queues.clear();
+  for (unsigned i = 0; i < threadTotal; ++i)
+    queues.push_back(std::make_unique<Queue>());
+  workers.reserve(threadTotal - 1);
+  for (unsigned i = 1; i < threadTotal; ++i)
+    workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+void JobSystem::stop()
+{
+  {
+    std::lock_guard<std::mutex> guard(sleepLock);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &t : workers)
+    t.join();
+  workers.clear();
+  std::lock_guard<std::mutex> guard(sleepLock);
+  stopping = false;
+}
+
+void JobSystem::dispatch(JobFn fn, void *ctx, size_t count, size_t grain)
+{
+  start();
+  size_t chunks = (count + grain - 1) / grain;
+  const size_t maxChunks = Queue::kCapacity * threadTotal;
+  if (chunks > maxChunks)
+  {
+    grain = (count + maxChunks - 1) / maxChunks;
+    chunks = (count + grain - 1) / grain;
+  }
+
+  // Each queue gets a contiguous run of chunks, so neighbouring indices stay on one thread until
+  // stealing starts.
+  const size_t perQueue = (chunks + threadTotal - 1) / threadTotal;
+  remaining.store(chunks, std::memory_order_relaxed);
+  queued.store(chunks, std::memory_order_relaxed);
+  for (size_t c = 0; c < chunks; ++c)
+  {
+    const Job job{fn, ctx, c * grain, std::min(count, (c + 1) * grain)};
+    if (!queues[c / perQueue]->push(job))
+    {
+      // Cannot happen with the chunk cap above; run it here rather than lose it.
+      queued.fetch_sub(1, std::memory_order_relaxed);
+      job.fn(job.ctx, job.begin, job.end);
+      remaining.fetch_sub(1, std::memory_order_release);
+    }
+  }
+  {
+    // A worker that checked `queued` just before the store is now inside wait() and gets the notify.
+    std::lock_guard<std::mutex> guard(sleepLock);
+  }
+  wake.notify_all();
+
+  while (remaining.load(std::memory_order_acquire) > 0)
+  {
+    if (!runOne(0))
+      std::this_thread::yield();
+  }
+}
+
+void JobSystem::workerLoop(unsigned self)
+{
+  for (;;)
+  {
+    if (runOne(self))
+      continue;
+    std::unique_lock<std::mutex> guard(sleepLock);
+    wake.wait(guard, [&] { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+    if (stopping)
+      return;
+  }
+}
+
+bool JobSystem::runOne(unsigned self)
+{
+  Job job;
+  bool found = queues[self]->pop(job);
+  for (unsigned i = 1; !found && i < threadTotal; ++i)
+    found = queues[(self + i) % threadTotal]->steal(job);
+  if (!found)
+    return false;
+  queued.fetch_sub(1, std::memory_order_relaxed);
+  job.fn(job.ctx, job.begin, job.end);
+  remaining.fetch_sub(1, std::memory_order_release);
+  return true;
+}
@@ -0,0 +1,94 @@
+#ifndef __LITE2D_JOB_SYSTEM_H__
+#pragma once
+#define __LITE2D_JOB_SYSTEM_H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Small work-stealing thread pool for data-parallel loops.
+ * parallelFor splits a range into chunks and deals them out to per-thread queues; each thread
+ * works through its own queue from the back and steals from the front of the others once it runs
+ * dry. The calling thread takes part and returns when every chunk has run. Which thread runs a
+ * chunk varies, so fn must only write to per-index data for the result to be deterministic.
+ * Worker threads start on the first parallel loop and sleep between loops; queues are preallocated,
+ * so a loop does not touch the heap.
+ * One thread at a time may call parallelFor, and fn must not call it again.
+ */
+class JobSystem
+{
+public:
+  // threads counts the calling thread; 0 means one per hardware thread.
+  explicit JobSystem(unsigned threads = 0);
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+  ~JobSystem();
+
+  // Stops the workers; the next loop starts the new count. 1 runs everything on the caller.
+  void setThreadCount(unsigned threads);
+  unsigned threadCount() const { return threadTotal; }
+
+  // Runs fn(begin, end) over [0, count) in chunks of about grain indices.
+  template <typename Fn>
+  void parallelFor(size_t count, size_t grain, Fn &&fn)
+  {
+    if (count == 0)
+      return;
+    grain = std::max<size_t>(grain, 1);
+    if (threadTotal <= 1 || count <= grain)
+    {
+      fn(size_t(0), count);
+      return;
+    }
+    using Body = std::remove_reference_t<Fn>;
+    dispatch([](void *ctx, size_t begin, size_t end) { (*static_cast<Body *>(ctx))(begin, end); },
+             const_cast<void *>(static_cast<const void *>(&fn)), count, grain);
+  }
+
+private:
+  using JobFn = void (*)(void *ctx, size_t begin, size_t end);
+
+  struct Job
+  {
+    JobFn fn;
+    void *ctx;
+    size_t begin, end;
+  };
+
+  // Fixed-capacity deque; the owner pops from the back, thieves take from the front.
+  struct Queue
+  {
+    static constexpr size_t kCapacity = 64;
+    std::mutex lock;
+    Job jobs[kCapacity];
+    size_t head = 0, tail = 0;
+
+    bool push(const Job &job);
+    bool pop(Job &job);
+    bool steal(Job &job);
+  };
+
+  unsigned threadTotal = 1;
+  std::vector<std::unique_ptr<Queue>> queues; // [0] belongs to the thread calling parallelFor
+  std::vector<std::thread> workers;
+  std::mutex sleepLock;
+  std::condition_variable wake;
+  std::atomic<size_t> queued{0};    // chunks not yet taken
+  std::atomic<size_t> remaining{0}; // chunks not yet finished
+  bool stopping = false;
+
+  void dispatch(JobFn fn, void *ctx, size_t count, size_t grain);
+  void start();
+  void stop();
+  void workerLoop(unsigned self);
+  bool runOne(unsigned self);
+};
+
+#endif  // __LITE2D_JOB_SYSTEM_H__
@@ -0,0 +1,166 @@
+#include "keyforms.h"
+
+#include <algorithm>
+#include <cstring>
+
+Keyform makeKeyform(std::vector<uint32_t> key, std::span<const uint32_t> vertices,
+                    std::span<const glm::vec2> offsets, size_t vertexCount)
+{
+  Keyform form;
+  form.key = std::move(key);
+  const size_t blockCount = (vertexCount + kSkinDeltaBlock - 1) / kSkinDeltaBlock;
+  std::vector<glm::vec2> dense(blockCount * kSkinDeltaBlock, glm::vec2(0.0f));
+  const size_t n = std::min(vertices.size(), offsets.size());
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (vertices[i] < vertexCount)
+      dense[vertices[i]] = offsets[i];
+  }
+
+  for (size_t b = 0; b < blockCount; ++b)
+  {
+    const glm::vec2 *src = dense.data() + b * kSkinDeltaBlock;
+    bool moves = false;
+    for (size_t k = 0; k < kSkinDeltaBlock; ++k)
+      moves |= src[k].x != 0.0f || src[k].y != 0.0f;
+    if (!moves)
+      continue;
+    form.blocks.push_back(static_cast<uint32_t>(b));
+    for (size_t k = 0; k < kSkinDeltaBlock; ++k)
+    {
+      form.dx.push_back(src[k].x);
+      form.dy.push_back(src[k].y);
+    }
+  }
+  return form;
+}
+
+size_t dropInvalidKeyforms(MeshKeyforms &kf, size_t vertexCount)
+{
+  const size_t blockCount = (vertexCount + kSkinDeltaBlock - 1) / kSkinDeltaBlock;
+  const size_t before = kf.forms.size();
+  bool axesOk = !kf.axes.empty() && kf.axes.size() <= kMaxKeyformAxes;
+  for (const auto &axis : kf.axes)
+  {
+    axesOk = axesOk && !axis.keys.empty();
+    for (size_t k = 1; axesOk && k < axis.keys.size(); ++k)
+      axesOk = axis.keys[k - 1] < axis.keys[k];
+  }
+  if (!axesOk)
+  {
+    kf = {};
+    return before;
+  }
+  std::erase_if(kf.forms,
+                [&](const Keyform &form)
+                {
+                  if (form.key.size() != kf.axes.size() || form.dx.size() != form.blocks.size() * kSkinDeltaBlock
+                      || form.dy.size() != form.dx.size())
+                    return true;
+                  for (size_t a = 0; a < form.key.size(); ++a)
+                  {
+                    if (form.key[a] >= kf.axes[a].keys.size())
+                      return true;
+                  }
+                  for (size_t i = 0; i < form.blocks.size(); ++i)
+                  {
+                    if (form.blocks[i] >= blockCount || (i > 0 && form.blocks[i - 1] >= form.blocks[i]))
+                      return true;
+                  }
+                  return false;
+                });
+  if (kf.forms.empty())
+    kf.axes.clear();
+  return before - kf.forms.size();
+}
+
+void remapKeyformVertices(MeshKeyforms &kf, std::span<const uint32_t> newOfOld)
+{
+  std::vector<uint32_t> vertices;
+  std::vector<glm::vec2> offsets;
+  for (Keyform &form : kf.forms)
+  {
+    vertices.clear();
+    offsets.clear();
+    for (size_t i = 0; i < form.blocks.size(); ++i)
+    {
+      for (size_t k = 0; k < kSkinDeltaBlock; ++k)
+      {
+        const size_t v = size_t(form.blocks[i]) * kSkinDeltaBlock + k;
+        const size_t at = i * kSkinDeltaBlock + k;
+        if (v < newOfOld.size() && (form.dx[at] != 0.0f || form.dy[at] != 0.0f))
+        {
+          vertices.push_back(newOfOld[v]);
+          offsets.emplace_back(form.dx[at], form.dy[at]);
+        }
+      }
+    }
+    form = makeKeyform(std::move(form.key), vertices, offsets, newOfOld.size());
+  }
+}
+
+size_t computeKeyformWeights(const MeshKeyforms &kf, std::span<const float> paramValues, std::span<float> weights)
+{
+  // Per axis, the cell the value falls in and how far along it is.
+  uint32_t lo[kMaxKeyformAxes];
+  float t[kMaxKeyformAxes];
+  const size_t axisCount = std::min(kf.axes.size(), kMaxKeyformAxes);
+  for (size_t a = 0; a < axisCount; ++a)
+  {
+    const std::vector<float> &keys = kf.axes[a].keys;
+    const ParamHandle h = kf.axes[a].param;
+    const float v = glm::clamp(h < paramValues.size() ? paramValues[h] : 0.0f, keys.front(), keys.back());
+    const size_t hi = std::upper_bound(keys.begin(), keys.end(), v) - keys.begin();
+    if (hi == 0 || hi == keys.size())
+    {
+      // At or past the last key (or a single key): that key alone.
+      lo[a] = static_cast<uint32_t>(hi == 0 ? 0 : keys.size() - 1);
+      t[a] = 0.0f;
+      continue;
+    }
+    lo[a] = static_cast<uint32_t>(hi - 1);
+    t[a] = (v - keys[hi - 1]) / (keys[hi] - keys[hi - 1]);
+  }
+
+  size_t active = 0;
+  for (size_t f = 0; f < kf.forms.size(); ++f)
+  {
+    const Keyform &form = kf.forms[f];
+    float w = 1.0f;
+    for (size_t a = 0; a < axisCount && w != 0.0f; ++a)
+    {
+      if (form.key[a] == lo[a])
+        w *= 1.0f - t[a];
+      else if (form.key[a] == lo[a] + 1)
+        w *= t[a];
+      else
+        w = 0.0f;
+    }
+    weights[f] = w;
+    active += w != 0.0f;
+  }
+  return active;
+}
+
+size_t keyformScratchSize(size_t vertexCount)
+{
+  return (vertexCount + kSkinDeltaBlock - 1) / kSkinDeltaBlock * kSkinDeltaBlock;
+}
+
+void applyKeyforms(const MeshKeyforms &kf, std::span<const float> weights, const SkinStreams &skin,
+                   std::span<float> x, std::span<float> y, SkinKernel kernel)
+{
+  const size_t n = skin.size();
+  std::memcpy(x.data(), skin.x.data(), n * sizeof(float));
+  std::memcpy(y.data(), skin.y.data(), n * sizeof(float));
+  // The last block may run past the mesh into the padding.
+  std::fill(x.begin() + n, x.end(), 0.0f);
+  std::fill(y.begin() + n, y.end(), 0.0f);
+  for (size_t f = 0; f < kf.forms.size(); ++f)
+  {
+    if (weights[f] == 0.0f)
+      continue;
+    const Keyform &form = kf.forms[f];
+    addDeltaBlocks(weights[f], form.blocks, form.dx.data(), form.dy.data(), x.data(), y.data(), kernel);
+  }
+}
@@ -0,0 +1,111 @@
+#ifndef __LITE2D_KEYFORMS_H__
+#pragma once
+#define __LITE2D_KEYFORMS_H__
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "param_store.h"
+#include "skinning.h"
+
+// ---------- Keyforms ----------
+//
+// A mesh can change shape with parameters. Its keyforms are rest-position offsets placed on a grid
+// of parameter keys: each axis is one parameter with ascending key values, and each keyform sits at
+// one key per axis. Grid points without a keyform are the unchanged rest shape. Per frame, the
+// parameter values select one grid cell; its corners are weighted by multilinear interpolation,
+// and the offsets of every keyform with a non-zero weight are added to the rest positions before
+// skinning. Offsets are stored in blocks of kSkinDeltaBlock consecutive vertices, leaving out
+// blocks where the keyform does not move any vertex.
+
+// Parameters one mesh's keyforms can depend on.
+constexpr size_t kMaxKeyformAxes = 8;
+
+/**
+ * One axis of a mesh's keyform grid.
+ * @param param_id The parameter it follows.
+ * @param param Its handle, resolved by Model::bindParams.
+ * @param keys Key values, ascending.
+ */
+struct KeyformAxis
+{
+  std::string param_id;
+  ParamHandle param = kInvalidParam;
+  std::vector<float> keys;
+
+  bool operator==(const KeyformAxis &o) const { return param_id == o.param_id && keys == o.keys; }
+};
+
+/**
+ * Offsets of the rest positions at one grid point.
+ * @param key Key index per axis.
+ * @param blocks Vertex block (first vertex / kSkinDeltaBlock) of each stored block, ascending.
+ * @param dx X offsets, kSkinDeltaBlock per stored block.
+ * @param dy Y offsets, same layout.
+ */
+struct Keyform
+{
+  std::vector<uint32_t> key;
+  std::vector<uint32_t> blocks;
+  std::vector<float> dx, dy;
+
+  bool operator==(const Keyform &) const = default;
+};
+
+/**
+ * Keyforms of one mesh.
+ * @param axes Grid axes.
+ * @param forms Keyforms, each with one key per axis.
+ */
+struct MeshKeyforms
+{
+  std::vector<KeyformAxis> axes;
+  std::vector<Keyform> forms;
+
+  bool empty() const { return forms.empty(); }
+  bool operator==(const MeshKeyforms &) const = default;
+};
+
+/**
+ * Builds a keyform from sparse offsets.
+ * @param key Key index per axis.
+ * @param vertices Vertex of each offset; entries at or past vertexCount are dropped, and a later
+ *                 entry for the same vertex replaces an earlier one.
+ * @param offsets Offset per entry of vertices.
+ * @param vertexCount Vertices in the mesh.
+ */
+Keyform makeKeyform(std::vector<uint32_t> key, std::span<const uint32_t> vertices,
+                    std::span<const glm::vec2> offsets, size_t vertexCount);
+
+// Drops keyforms whose keys do not fit the axes or whose blocks do not fit a mesh of vertexCount
+// vertices, or every keyform if an axis is unusable (no keys, keys not ascending, more than
+// kMaxKeyformAxes axes). Returns how many were dropped.
+size_t dropInvalidKeyforms(MeshKeyforms &kf, size_t vertexCount);
+
+// Moves vertex offsets after the mesh's vertices were renumbered: old vertex i is now newOfOld[i].
+void remapKeyformVertices(MeshKeyforms &kf, std::span<const uint32_t> newOfOld);
+
+/**
+ * Weight of every keyform for the given parameter values. Parameters outside an axis's key range
+ * are clamped to it; an axis whose parameter is not bound reads 0.
+ * @param paramValues Value per ParamHandle (ParamStore::cur, or values derived from it).
+ * @param weights One entry per keyform.
+ * @return Number of keyforms with a non-zero weight.
+ */
+size_t computeKeyformWeights(const MeshKeyforms &kf, std::span<const float> paramValues, std::span<float> weights);
+
+// Scratch floats per stream applyKeyforms needs for a mesh of vertexCount vertices.
+size_t keyformScratchSize(size_t vertexCount);
+
+/**
+ * Rest positions with the weighted keyforms added, into x and y (keyformScratchSize floats each).
+ * Keyforms with a zero weight are not visited.
+ */
+void applyKeyforms(const MeshKeyforms &kf, std::span<const float> weights, const SkinStreams &skin,
+                   std::span<float> x, std::span<float> y, SkinKernel kernel = bestSkinKernel());
+
+#endif  // __LITE2D_KEYFORMS_H__
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "commons/json.hpp"
+
+#include "asset_index.h"
+#include "engine.h"
+#include "load_profile.h"
+#include "model_binary.h"
+#include "model_loader.h"
+#include "sidecar_manifest.h"
+#include "texture.h"
+
+// ---------- lite2d_load_bench: load a model N times headlessly, report per-phase median/p95 ----------
+
+static void printUsage(const char *argv0)
+{
+  std::cerr << "Usage: " << argv0 << " [options]\n"
+            << "Options:\n"
+            << "  -m, --moc3=FILE             Path to .moc3.json or compiled .lite2d (required)\n"
+            << "  -r, --render-settings=FILE  Path to .moc3.render-settings.json\n"
+            << "  -p, --parts=FILE            Path to .moc3.parts.json\n"
+            << "  -n, --iterations=N          Number of loads (default 20)\n"
+            << "  -j, --load-threads=N        Threads used to build drawables (0 = all cores)\n"
+            << "  -o, --output=FILE           Also write the summary as JSON to FILE\n"
+            << "      --textures              Decode the model's textures too (no GL upload)\n"
+            << "      --cold                  Drop in-process sidecar and asset index caches before each load\n"
+            << "      --no-optimize           Skip load-time mesh optimization\n"
+            << "  -h, --help                  Show this help\n";
+}
+
+static bool parseOptionValue(const std::string &arg, const std::string &longName, std::string &out)
+{
+  const std::string prefix = "--" + longName + "=";
+  if (arg.rfind(prefix, 0) == 0)
+  {
+    out = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+static bool parseShortOptionValue(const std::string &arg, const std::string &shortName, std::string &out)
+{
+  const std::string prefix = "-" + shortName + "=";
+  if (arg.rfind(prefix, 0) == 0)
+  {
+    out = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+// Nearest-rank percentile of an ascending sample.
+static double percentile(const std::vector<double> &sorted, double p)
+{
+  if (sorted.empty())
+    return 0.0;
+  const size_t rank = static_cast<size_t>(std::ceil(p * double(sorted.size())));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+/**
+ * Samples of one phase across iterations.
+ * @param ms Wall time per iteration in which the phase ran.
+ * @param rssDeltaKb Resident set change per iteration.
+ * @param calls Calls per iteration (from the last iteration).
+ * @param items Work items per iteration (from the last iteration).
+ */
+struct PhaseSamples
+{
+  std::string name;
+  std::vector<double> ms;
+  std::vector<double> rssDeltaKb;
+  unsigned calls = 0;
+  uint64_t items = 0;
+};
+
+int main(int argc, char **argv)
+{
+  std::filesystem::path modelPath;
+  std::filesystem::path renderSettingsPath;
+  std::filesystem::path partsPath;
+  std::filesystem::path outputPath;
+  ModelLoadOptions loadOptions;
+  int iterations = 20;
+  bool decodeTextures = false;
+  bool cold = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help")
+    {
+      printUsage(argv[0]);
+      return 0;
+    }
+    if (arg == "--textures")
+    {
+      decodeTextures = true;
+      continue;
+    }
+    if (arg == "--cold")
+    {
+      cold = true;
+      continue;
+    }
+    if (arg == "--no-optimize")
+    {
+      loadOptions.optimizeMeshes = false;
+      continue;
+    }
+
+    std::string value;
+    if (parseOptionValue(arg, "moc3", value) || parseShortOptionValue(arg, "m", value))
+    {
+      modelPath = value;
+      continue;
+    }
+    if (parseOptionValue(arg, "render-settings", value) || parseShortOptionValue(arg, "r", value))
+    {
+      renderSettingsPath = value;
+      continue;
+    }
+    if (parseOptionValue(arg, "parts", value) || parseShortOptionValue(arg, "p", value))
+    {
+      partsPath = value;
+      continue;
+    }
+    if (parseOptionValue(arg, "iterations", value) || parseShortOptionValue(arg, "n", value))
+    {
+      iterations = std::atoi(value.c_str());
+      continue;
+    }
+    if (parseOptionValue(arg, "load-threads", value) || parseShortOptionValue(arg, "j", value))
+    {
+      loadOptions.workerCount = static_cast<unsigned>(std::max(0, std::atoi(value.c_str())));
+      continue;
+    }
+    if (parseOptionValue(arg, "output", value) || parseShortOptionValue(arg, "o", value))
+    {
+      outputPath = value;
+      continue;
+    }
+
+    if ((arg == "-m" || arg == "--moc3") && i + 1 < argc)
+    {
+      modelPath = argv[++i];
+      continue;
+    }
+    if ((arg == "-r" || arg == "--render-settings") && i + 1 < argc)
+    {
+      renderSettingsPath = argv[++i];
+      continue;
+    }
+    if ((arg == "-p" || arg == "--parts") && i + 1 < argc)
+    {
+      partsPath = argv[++i];
+      continue;
+    }
+    if ((arg == "-n" || arg == "--iterations") && i + 1 < argc)
+    {
+      iterations = std::atoi(argv[++i]);
+      continue;
+    }
+    if ((arg == "-j" || arg == "--load-threads") && i + 1 < argc)
+    {
+      loadOptions.workerCount = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+      continue;
+    }
+    if ((arg == "-o" || arg == "--output") && i + 1 < argc)
+    {
+      outputPath = argv[++i];
+      continue;
+    }
+
+    std::cerr << "Unknown option: " << arg << "\n";
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  if (modelPath.empty() || iterations <= 0)
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+  const bool isCompiled = modelPath.extension() == ".lite2d";
+
+  setLoadProfilingEnabled(true);
+  std::vector<PhaseSamples> phases; // first-seen order
+  auto samplesFor = [&](const std::string &name) -> PhaseSamples &
+  {
+    for (auto &p : phases)
+    {
+      if (p.name == name)
+        return p;
+    }
+    phases.push_back(PhaseSamples{name});
+    return phases.back();
+  };
+
+  for (int it = 0; it < iterations; ++it)
+  {
+    if (cold)
+    {
+      clearSidecarCache();
+      clearAssetIndexCache();
+    }
+    resetLoadProfile();
+    const int64_t rssBegin = currentRssBytes();
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // The loaders only touch the model; no GL context is needed here.
+    Engine eng;
+    std::unordered_map<std::string, std::filesystem::path> drawableTextures;
+    const bool ok = isCompiled ? loadModelFromLite2d(modelPath, eng, drawableTextures)
+                               : loadModelFromMoc3Json(modelPath, eng, drawableTextures, renderSettingsPath, partsPath,
+                                                       loadOptions);
+    if (!ok)
+    {
+      std::cerr << "Failed to load " << modelPath << "\n";
+      return 1;
+    }
+    if (decodeTextures)
+    {
+      for (const auto &kv : drawableTextures)
+      {
+        int w = 0, h = 0;
+        if (unsigned char *pixels = decodeImageRGBA(kv.second.string(), w, h))
+          freeImagePixels(pixels);
+      }
+    }
+
+    const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    for (const auto &p : loadProfileSnapshot())
+    {
+      PhaseSamples &s = samplesFor(p.name);
+      s.ms.push_back(p.ms);
+      s.rssDeltaKb.push_back(double(p.rssDeltaBytes) / 1024.0);
+      s.calls = p.calls;
+      s.items = p.items;
+    }
+    PhaseSamples &total = samplesFor("total");
+    total.ms.push_back(totalMs);
+    total.rssDeltaKb.push_back(double(currentRssBytes() - rssBegin) / 1024.0);
+    total.calls = 1;
+  }
+
+  // Keep "total" last regardless of when it was first seen.
+  std::stable_partition(phases.begin(), phases.end(), [](const PhaseSamples &p) { return p.name != "total"; });
+
+  nlohmann::json report;
+  report["model"] = modelPath.string();
+  report["iterations"] = iterations;
+  report["phases"] = nlohmann::json::array();
+
+  std::cout << "Loaded " << modelPath << " " << iterations << " times\n"
+            << std::left << std::setw(16) << "phase" << std::right << std::setw(7) << "calls" << std::setw(12)
+            << "median ms" << std::setw(12) << "p95 ms" << std::setw(14) << "rss delta KB" << std::setw(14)
+            << "items" << "\n";
+  for (auto &p : phases)
+  {
+    std::sort(p.ms.begin(), p.ms.end());
+    std::sort(p.rssDeltaKb.begin(), p.rssDeltaKb.end());
+    const double median = percentile(p.ms, 0.5);
+    const double p95 = percentile(p.ms, 0.95);
+    const double rssMedian = percentile(p.rssDeltaKb, 0.5);
+    std::cout << std::left << std::setw(16) << p.name << std::right << std::setw(7) << p.calls << std::fixed
+              << std::setprecision(3) << std::setw(12) << median << std::setw(12) << p95 << std::setprecision(0)
+              << std::setw(14) << rssMedian << std::setw(14) << p.items << "\n";
+    report["phases"].push_back({{"name", p.name},
+                                {"calls", p.calls},
+                                {"samples", p.ms.size()},
+                                {"median_ms", median},
+                                {"p95_ms", p95},
+                                {"min_ms", p.ms.front()},
+                                {"max_ms", p.ms.back()},
+                                {"median_rss_delta_kb", rssMedian},
+                                {"items", p.items}});
+  }
+  report["peak_rss_kb"] = peakRssBytes() / 1024;
+  std::cout << "Peak RSS: " << peakRssBytes() / 1024 << " KB\n";
+
+  if (!outputPath.empty())
+  {
+    std::ofstream out(outputPath);
+    if (!out)
+    {
+      std::cerr << "Cannot write " << outputPath << "\n";
+      return 1;
+    }
+    out << report.dump(2) << "\n";
+  }
+  return 0;
+}
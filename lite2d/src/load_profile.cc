@@ -0,0 +1,127 @@
+#include "load_profile.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#include "commons/json.hpp"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+std::atomic<bool> profilingEnabled{false};
+std::mutex profileMutex;
+std::vector<LoadPhaseStats> profilePhases;
+
+void recordPhase(const char *name, double ms, int64_t rssDelta, uint64_t items)
+{
+  std::lock_guard<std::mutex> lock(profileMutex);
+  for (auto &p : profilePhases)
+  {
+    if (p.name == name)
+    {
+      ++p.calls;
+      p.ms += ms;
+      p.rssDeltaBytes += rssDelta;
+      p.items += items;
+      return;
+    }
+  }
+  profilePhases.push_back(LoadPhaseStats{name, 1, ms, rssDelta, items});
+}
+} // namespace
+
+void setLoadProfilingEnabled(bool enabled)
+{
+  profilingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool isLoadProfilingEnabled()
+{
+  return profilingEnabled.load(std::memory_order_relaxed);
+}
+
+void resetLoadProfile()
+{
+  std::lock_guard<std::mutex> lock(profileMutex);
+  profilePhases.clear();
+}
+
+std::vector<LoadPhaseStats> loadProfileSnapshot()
+{
+  std::lock_guard<std::mutex> lock(profileMutex);
+  return profilePhases;
+}
+
+int64_t currentRssBytes()
+{
+#if defined(__linux__)
+  // Second field of statm is the resident page count; cheaper than parsing /proc/self/status.
+  FILE *f = std::fopen("/proc/self/statm", "r");
+  if (!f)
+    return 0;
+  long long size = 0, resident = 0;
+  const int n = std::fscanf(f, "%lld %lld", &size, &resident);
+  std::fclose(f);
+  if (n != 2)
+    return 0;
+  return static_cast<int64_t>(resident) * static_cast<int64_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
+int64_t peakRssBytes()
+{
+#if defined(__linux__) || defined(__APPLE__)
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return static_cast<int64_t>(usage.ru_maxrss); // bytes on macOS
+#else
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024; // KiB on Linux
+#endif
+#else
+  return 0;
+#endif
+}
+
+void writeLoadProfileJson(std::ostream &os, const std::vector<LoadPhaseStats> &phases)
+{
+  nlohmann::json j;
+  j["phases"] = nlohmann::json::array();
+  for (const auto &p : phases)
+  {
+    j["phases"].push_back({{"name", p.name},
+                           {"calls", p.calls},
+                           {"ms", p.ms},
+                           {"rss_delta_kb", p.rssDeltaBytes / 1024},
+                           {"items", p.items}});
+  }
+  j["rss_kb"] = currentRssBytes() / 1024;
+  j["peak_rss_kb"] = peakRssBytes() / 1024;
+  os << j.dump(2) << "\n";
+}
+
+LoadPhaseScope::LoadPhaseScope(const char *name, uint64_t items)
+    : name(name), items(items), active(isLoadProfilingEnabled())
+{
+  if (!active)
+    return;
+  rssBegin = currentRssBytes();
+  begin = std::chrono::steady_clock::now();
+}
+
+void LoadPhaseScope::end()
+{
+  if (!active)
+    return;
+  active = false;
+  const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+  recordPhase(name, ms, currentRssBytes() - rssBegin, items);
+}
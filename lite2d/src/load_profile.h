@@ -0,0 +1,75 @@
+#ifndef __LITE2D_LOAD_PROFILE_H__
+#pragma once
+#define __LITE2D_LOAD_PROFILE_H__
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ---------- Load-time phase profiling ----------
+//
+// The loader, texture decode/upload and GL mesh creation wrap their phases in LoadPhaseScope.
+// Recording is off by default and costs one branch per phase then; the viewer's --load-report and
+// lite2d_load_bench switch it on.
+
+/**
+ * Accumulated cost of one named phase since the last resetLoadProfile().
+ * @param name Phase name, e.g. "json_parse".
+ * @param calls How many times the phase ran.
+ * @param ms Total wall time.
+ * @param rssDeltaBytes Total change in resident set size across the phase (can be negative).
+ * @param items Total work items the phase reported (drawables, pixels, bytes, ...).
+ */
+struct LoadPhaseStats
+{
+  std::string name;
+  unsigned calls = 0;
+  double ms = 0.0;
+  int64_t rssDeltaBytes = 0;
+  uint64_t items = 0;
+};
+
+void setLoadProfilingEnabled(bool enabled);
+bool isLoadProfilingEnabled();
+
+// Drops everything recorded so far.
+void resetLoadProfile();
+
+// Phases in the order they were first recorded.
+std::vector<LoadPhaseStats> loadProfileSnapshot();
+
+// Current and peak resident set size of the process, or 0 where the platform does not report it.
+int64_t currentRssBytes();
+int64_t peakRssBytes();
+
+// Writes phases as {"phases":[...],"rss_kb":N,"peak_rss_kb":N}.
+void writeLoadProfileJson(std::ostream &os, const std::vector<LoadPhaseStats> &phases);
+
+/**
+ * Times the enclosing block as one call of a phase. end() records early, for phases that do not
+ * map to a block.
+ * @param name Phase name; must outlive the scope (use a literal).
+ * @param items Work items to add to the phase.
+ */
+class LoadPhaseScope
+{
+public:
+  explicit LoadPhaseScope(const char *name, uint64_t items = 0);
+  LoadPhaseScope(const LoadPhaseScope &) = delete;
+  LoadPhaseScope &operator=(const LoadPhaseScope &) = delete;
+  ~LoadPhaseScope() { end(); }
+
+  void setItems(uint64_t n) { items = n; }
+  void end();
+
+private:
+  const char *name;
+  uint64_t items;
+  bool active;
+  int64_t rssBegin = 0;
+  std::chrono::steady_clock::time_point begin;
+};
+
+#endif  // __LITE2D_LOAD_PROFILE_H__
@@ -1,6 +1,9 @@
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <unordered_map>
@@ -20,6 +23,14 @@
 #include "shader.h"
 #include "texture.h"
 #include "model_loader.h"
+#include "model_binary.h"
+#include "sidecar_manifest.h"
+#include "file_watcher.h"
+#include "alloc_counter.h"
+#include "load_profile.h"
+#include "mesh_regions.h"
+#include "skinning.h"
+#include "sim_clock.h"
 
 static void APIENTRY glDebugCb(GLenum source, GLenum type, GLuint id,
                                GLenum severity, GLsizei,
@@ -213,6 +224,10 @@ static void makeSampleModel(Model &model)
     model.meshes.emplace(m.id, m);
     model.deformers["def_jaw"].bound_meshes.push_back(m.id);
   }
+
+  classifyMeshRegions(model);
+  buildSkinStreams(model);
+  model.buildDeformerTree();
 }
 
 // ---------- GLFW error callback ----------
@@ -317,14 +332,112 @@ static void cursorPosCallback(GLFWwindow *window, double xpos, double ypos)
   state->pan.y -= static_cast<float>(dy) / (scale * state->zoom);
 }
 
+/**
+ * Loads the textures a (re)loaded model refers to that are not resident yet, and points meshes at
+ * the override or checker texture the same way the initial load does.
+ * @param eng The engine holding the resident textures.
+ * @param model The model whose meshes get their texture ids resolved.
+ * @param drawableTextures Texture ids to file paths, as returned by the loader.
+ */
+static void resolveModelTextures(Engine &eng, Model &model,
+                                 const std::unordered_map<std::string, std::filesystem::path> &drawableTextures)
+{
+  for (const auto &kv : drawableTextures)
+  {
+    if (eng.textures.count(kv.first) || kv.second.empty() || !std::filesystem::exists(kv.second))
+      continue;
+    Texture tex = Texture().fromFilePath(kv.second.string());
+    if (!tex.id)
+      continue;
+    eng.textures[kv.first] = tex;
+    std::cerr << "Loaded texture " << kv.second << " as " << kv.first << "\n";
+  }
+  const bool useOverride = eng.textures.count("tex_override") > 0;
+  for (auto &kv : model.meshes)
+  {
+    if (useOverride)
+      kv.second.texture_id = "tex_override";
+    else if (!eng.textures.count(kv.second.texture_id))
+      kv.second.texture_id = "tex_checker";
+  }
+  if (!eng.textures.count("tex_checker"))
+    eng.createCheckerTexture("tex_checker", 64, 64);
+}
+
+/**
+ * Paths the viewer loaded the model from, used by --watch to reload it.
+ * @param modelPath The .moc3.json or .lite2d file.
+ * @param renderSettingsPath Render settings file (explicit or the default sibling).
+ * @param partsPath Parts file (explicit or the default sibling).
+ */
+struct ModelSources
+{
+  std::filesystem::path modelPath;
+  std::filesystem::path renderSettingsPath;
+  std::filesystem::path partsPath;
+  ModelLoadOptions loadOptions;
+};
+
+/**
+ * Reloads what changed on disk. Sidecar-only edits are re-applied to the live model without
+ * re-reading the .moc3.json or touching GL buffers; anything else reloads the model and lets
+ * Engine::applyModelReload rebuild only the meshes that differ.
+ */
+static void hotReload(Engine &eng, const ModelSources &src, const std::vector<std::filesystem::path> &changed)
+{
+  const auto startTime = std::chrono::steady_clock::now();
+  auto elapsedMs = [&]()
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+  };
+  const bool isCompiled = src.modelPath.extension() == ".lite2d";
+  const std::filesystem::path modelAbs = std::filesystem::absolute(src.modelPath).lexically_normal();
+  const bool modelChanged = std::find(changed.begin(), changed.end(), modelAbs) != changed.end();
+
+  if (!modelChanged && !isCompiled
+      && reloadModelSidecars(src.modelPath, eng.model, src.renderSettingsPath, src.partsPath))
+  {
+    eng.invalidateDrawList();
+    std::cerr << "Hot reload: sidecars re-applied to " << eng.model.meshes.size() << " meshes in "
+              << elapsedMs() << " ms\n";
+    return;
+  }
+
+  Engine staging;
+  std::unordered_map<std::string, std::filesystem::path> drawableTextures;
+  const bool ok = isCompiled ? loadModelFromLite2d(src.modelPath, staging, drawableTextures)
+                             : loadModelFromMoc3Json(src.modelPath, staging, drawableTextures,
+                                                     src.renderSettingsPath, src.partsPath, src.loadOptions);
+  if (!ok)
+  {
+    std::cerr << "Hot reload failed, keeping the current model\n";
+    return;
+  }
+  resolveModelTextures(eng, staging.model, drawableTextures);
+  eng.canvas = staging.canvas;
+  const ModelReloadStats stats = eng.applyModelReload(std::move(staging.model));
+  std::cerr << "Hot reload: " << stats.added << " added, " << stats.removed << " removed, "
+            << stats.rebuilt << " rebuilt, " << stats.updated << " updated, " << stats.unchanged
+            << " unchanged in " << elapsedMs() << " ms\n";
+}
+
 static void printUsage(const char *argv0)
 {
   std::cerr << "Usage: " << argv0 << " [options]\n"
             << "Options:\n"
-            << "  -m, --moc3=FILE             Path to .moc3.json\n"
+            << "  -m, --moc3=FILE             Path to .moc3.json or compiled .lite2d\n"
             << "  -r, --render-settings=FILE  Path to .moc3.render-settings.json\n"
             << "  -p, --parts=FILE            Path to .moc3.parts.json\n"
             << "  -t, --texture=FILE          Path to texture .png (override)\n"
+            << "  -j, --load-threads=N        Threads used to build drawables (0 = all cores)\n"
+            << "      --update-threads=N      Threads used to deform meshes each frame (0 = all cores)\n"
+            << "      --update-stats          Print mesh update and draw call counts, once a second\n"
+            << "      --sim-rate=HZ           Simulation steps per second (default 120, 0 = once per frame)\n"
+            << "      --no-buffer-storage     Map the vertex ring every frame even if persistent mapping works\n"
+            << "      --gpu-skinning          Skin meshes in the vertex shader where possible\n"
+            << "  -w, --watch                 Reload the model when it or its sidecars change on disk\n"
+            << "      --load-report=FILE      Write per-phase load timings and memory as JSON to FILE\n"
+            << "      --check-allocs=N        After warm-up, run N frames and fail if update/render allocate\n"
             << "  -h, --help                  Show this help\n";
 }
 
@@ -356,6 +469,15 @@ int main(int argc, char **argv)
   std::filesystem::path renderSettingsPath;
   std::filesystem::path partsPath;
   std::filesystem::path textureOverridePath;
+  ModelLoadOptions loadOptions;
+  bool watchFiles = false;
+  std::filesystem::path loadReportPath;
+  int checkAllocFrames = 0;
+  unsigned updateThreads = 0;
+  bool printUpdateStats = false;
+  bool allowBufferStorage = true;
+  bool gpuSkinning = false;
+  float simRate = SimClock::kDefaultRate;
 
   for (int i = 1; i < argc; ++i)
   {
@@ -365,6 +487,27 @@ int main(int argc, char **argv)
       printUsage(argv[0]);
       return 0;
     }
+    if (arg == "-w" || arg == "--watch")
+    {
+      watchFiles = true;
+      continue;
+    }
+
+    if (arg == "--update-stats")
+    {
+      printUpdateStats = true;
+      continue;
+    }
+    if (arg == "--no-buffer-storage")
+    {
+      allowBufferStorage = false;
+      continue;
+    }
+    if (arg == "--gpu-skinning")
+    {
+      gpuSkinning = true;
+      continue;
+    }
 
     std::string value;
     if (parseOptionValue(arg, "moc3", value) || parseShortOptionValue(arg, "m", value))
@@ -388,6 +531,32 @@ int main(int argc, char **argv)
       continue;
     }
 
+    if (parseOptionValue(arg, "load-threads", value) || parseShortOptionValue(arg, "j", value))
+    {
+      loadOptions.workerCount = static_cast<unsigned>(std::max(0, std::atoi(value.c_str())));
+      continue;
+    }
+    if (parseOptionValue(arg, "update-threads", value))
+    {
+      updateThreads = static_cast<unsigned>(std::max(0, std::atoi(value.c_str())));
+      continue;
+    }
+    if (parseOptionValue(arg, "sim-rate", value))
+    {
+      simRate = std::max(0.0f, static_cast<float>(std::atof(value.c_str())));
+      continue;
+    }
+    if (parseOptionValue(arg, "load-report", value))
+    {
+      loadReportPath = value;
+      continue;
+    }
+    if (parseOptionValue(arg, "check-allocs", value))
+    {
+      checkAllocFrames = std::max(0, std::atoi(value.c_str()));
+      continue;
+    }
+
     if ((arg == "-m" || arg == "--moc3") && i + 1 < argc)
     {
       moc3JsonPath = argv[++i];
@@ -408,6 +577,31 @@ int main(int argc, char **argv)
       textureOverridePath = argv[++i];
       continue;
     }
+    if ((arg == "-j" || arg == "--load-threads") && i + 1 < argc)
+    {
+      loadOptions.workerCount = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+      continue;
+    }
+    if (arg == "--update-threads" && i + 1 < argc)
+    {
+      updateThreads = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+      continue;
+    }
+    if (arg == "--sim-rate" && i + 1 < argc)
+    {
+      simRate = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+      continue;
+    }
+    if (arg == "--load-report" && i + 1 < argc)
+    {
+      loadReportPath = argv[++i];
+      continue;
+    }
+    if (arg == "--check-allocs" && i + 1 < argc)
+    {
+      checkAllocFrames = std::max(0, std::atoi(argv[++i]));
+      continue;
+    }
 
     std::cerr << "Unknown option: " << arg << "\n";
     printUsage(argv[0]);
@@ -420,7 +614,14 @@ int main(int argc, char **argv)
     moc3JsonPath = std::filesystem::path("../live2d-assets/mao_pro/mao_pro.moc3.json");
   }
 
+  if (checkAllocFrames > 0 && !heapAllocationCountingEnabled())
+  {
+    std::cerr << "--check-allocs needs a build configured with -DLITE2D_COUNT_ALLOCATIONS=ON\n";
+    return 1;
+  }
+
   std::cerr << "Model JSON: " << moc3JsonPath << "\n";
+  setLoadProfilingEnabled(!loadReportPath.empty());
 
   glfwSetErrorCallback(glfwError); // set callback first
 
@@ -507,11 +708,23 @@ int main(int argc, char **argv)
   std::cerr << "Stencil bits: " << stencilBits << "\n";
 
   Engine eng;
+  eng.jobs.setThreadCount(updateThreads);
+  eng.simClock.setRate(simRate);
+  eng.gpuSkinning = gpuSkinning;
   std::unordered_map<std::string, std::filesystem::path> drawableTextures;
-  bool modelLoaded = loadModelFromMoc3Json(moc3JsonPath, eng, drawableTextures, renderSettingsPath, partsPath);
+  bool modelLoaded = false;
+  const std::filesystem::path compiledPath = moc3JsonPath.extension() == ".lite2d"
+                                                 ? moc3JsonPath
+                                                 : getCompiledModelPath(moc3JsonPath);
+  if (compiledPath == moc3JsonPath || isCompiledModelFresh(compiledPath, moc3JsonPath, renderSettingsPath, partsPath))
+    modelLoaded = loadModelFromLite2d(compiledPath, eng, drawableTextures);
+  if (!modelLoaded && compiledPath != moc3JsonPath)
+    modelLoaded = loadModelFromMoc3Json(moc3JsonPath, eng, drawableTextures, renderSettingsPath, partsPath, loadOptions);
   if (!eng.initGL())
     return -1;
   checkErr("after initGL");
+  eng.meshArena.initStreaming((GLADloadproc)glfwGetProcAddress, allowBufferStorage);
+  checkErr("after initStreaming");
 
   if (!textureOverridePath.empty())
   {
@@ -593,8 +806,42 @@ int main(int argc, char **argv)
   eng.buildGLMeshes();
   checkErr("after buildGLMeshes");
 
-  // init spring
-  eng.springs["ParamMouthOpen"].reset(eng.model.params["ParamMouthOpen"].cur_v);
+  if (!loadReportPath.empty())
+  {
+    std::ofstream report(loadReportPath);
+    if (report)
+    {
+      writeLoadProfileJson(report, loadProfileSnapshot());
+      std::cerr << "Wrote load report to " << loadReportPath << "\n";
+    }
+    else
+    {
+      std::cerr << "Cannot write load report: " << loadReportPath << "\n";
+    }
+    // Hot reloads are not part of startup; stop recording.
+    setLoadProfilingEnabled(false);
+  }
+
+  // init springs
+  eng.resetSprings();
+
+  FileWatcher watcher;
+  ModelSources sources;
+  if (watchFiles && modelLoaded)
+  {
+    sources.modelPath = compiledPath == moc3JsonPath ? compiledPath : moc3JsonPath;
+    sources.loadOptions = loadOptions;
+    watcher.watch(sources.modelPath);
+    if (compiledPath != moc3JsonPath)
+    {
+      sources.renderSettingsPath = renderSettingsPath.empty() ? getRenderSettingsPath(moc3JsonPath) : renderSettingsPath;
+      sources.partsPath = partsPath.empty() ? getPartsPath(moc3JsonPath) : partsPath;
+      watcher.watch(sources.renderSettingsPath);
+      watcher.watch(sources.partsPath);
+    }
+    std::cerr << "Watching " << sources.modelPath << " for changes ("
+              << (watcher.usesNotifications() ? "inotify" : "polling") << ")\n";
+  }
 
   ViewerState viewState;
   viewState.engine = &eng;
@@ -603,11 +850,29 @@ int main(int argc, char **argv)
   glfwSetMouseButtonCallback(win, mouseButtonCallback);
   glfwSetCursorPosCallback(win, cursorPosCallback);
 
+  // --check-allocs: frames after warm-up that allocated, and how often.
+  constexpr int kAllocWarmupFrames = 120;
+  int frameIndex = 0;
+  int allocatingFrames = 0;
+  uint64_t steadyAllocations = 0;
+  int exitCode = 0;
+
+  // --update-stats: mesh and draw counts summed since the last report.
+  MeshUpdateStats statsSum;
+  RenderStats renderSum;
+  int statsFrames = 0;
+  double statsSince = glfwGetTime();
+
   double last = glfwGetTime();
-  double start = last;
   while (!glfwWindowShouldClose(win))
   {
     glfwPollEvents();
+    if (watchFiles && modelLoaded)
+    {
+      const auto changed = watcher.poll();
+      if (!changed.empty())
+        hotReload(eng, sources, changed);
+    }
     double now = glfwGetTime();
     float dt = float(now - last);
     last = now;
@@ -620,14 +885,67 @@ int main(int argc, char **argv)
     eng.view = glm::translate(glm::mat4(1.0f), glm::vec3(viewState.pan, 0.0f));
     eng.view = glm::scale(eng.view, glm::vec3(viewState.zoom, viewState.zoom, 1.0f));
 
-    eng.update(float(now - start), dt);
+    const uint64_t allocsBefore = heapAllocationCount();
+    eng.update(dt);
     checkErr("update");
     eng.render(fbw, fbh);
+    const uint64_t frameAllocs = heapAllocationCount() - allocsBefore;
+
+    if (printUpdateStats)
+    {
+      statsSum.active += eng.updateStats.active;
+      statsSum.updated += eng.updateStats.updated;
+      statsSum.skipped += eng.updateStats.skipped;
+      statsSum.uploadBytes += eng.updateStats.uploadBytes;
+      statsSum.gpuSkinned += eng.updateStats.gpuSkinned;
+      statsSum.paletteBytes += eng.updateStats.paletteBytes;
+      renderSum.meshes += eng.renderStats.meshes;
+      renderSum.drawCalls += eng.renderStats.drawCalls;
+      renderSum.multiDraws += eng.renderStats.multiDraws;
+      renderSum.vaoBinds += eng.renderStats.vaoBinds;
+      renderSum.textureBinds += eng.renderStats.textureBinds;
+      ++statsFrames;
+      if (now - statsSince >= 1.0)
+      {
+        std::cerr << "Meshes per frame: " << statsSum.active / statsFrames << " active, "
+                  << statsSum.updated / statsFrames << " updated, " << statsSum.skipped / statsFrames
+                  << " skipped, " << statsSum.gpuSkinned / statsFrames << " GPU-skinned, "
+                  << statsSum.uploadBytes / statsFrames / 1024 << " KB vertices and "
+                  << statsSum.paletteBytes / statsFrames / 1024 << " KB bones uploaded\n";
+        std::cerr << "Draws per frame: " << renderSum.drawCalls / statsFrames << " draw calls ("
+                  << renderSum.multiDraws / statsFrames << " multi-draw) for " << renderSum.meshes / statsFrames
+                  << " meshes, " << renderSum.vaoBinds / statsFrames << " VAO binds, "
+                  << renderSum.textureBinds / statsFrames << " texture binds\n";
+        std::cerr << "Vertex ring: "
+                  << (eng.meshArena.streaming() == GLMeshArena::Streaming::Persistent ? "persistent" : "mapped")
+                  << ", " << eng.updateStats.stalls << " stalled frames\n";
+        statsSum = MeshUpdateStats{};
+        renderSum = RenderStats{};
+        statsFrames = 0;
+        statsSince = now;
+      }
+    }
+
+    if (checkAllocFrames > 0 && ++frameIndex > kAllocWarmupFrames)
+    {
+      if (frameAllocs > 0)
+      {
+        ++allocatingFrames;
+        steadyAllocations += frameAllocs;
+      }
+      if (frameIndex == kAllocWarmupFrames + checkAllocFrames)
+      {
+        std::cerr << "Allocation check: " << allocatingFrames << " of " << checkAllocFrames
+                  << " steady-state frames allocated (" << steadyAllocations << " allocations)\n";
+        exitCode = allocatingFrames > 0 ? 1 : 0;
+        break;
+      }
+    }
 
     glfwSwapBuffers(win);
     checkErr("frame");
   }
   glfwDestroyWindow(win);
   glfwTerminate();
-  return 0;
+  return exitCode;
 }
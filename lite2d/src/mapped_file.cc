@@ -0,0 +1,61 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Map the file at the given path, replacing any previous mapping.
+ * @param path The file to map.
+ * @return True if the file is non-empty and could be mapped.
+ */
+bool MappedFile::open(const std::filesystem::path &path)
+{
+  close();
+#if defined(_WIN32)
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs)
+    return false;
+  fallback.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  if (fallback.empty())
+    return false;
+  data = reinterpret_cast<const unsigned char *>(fallback.data());
+  size = fallback.size();
+  return true;
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    ::close(fd);
+    return false;
+  }
+  void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED)
+    return false;
+  data = static_cast<const unsigned char *>(p);
+  size = static_cast<size_t>(st.st_size);
+  return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#if defined(_WIN32)
+  fallback.clear();
+#else
+  if (data)
+    munmap(const_cast<unsigned char *>(data), size);
+#endif
+  data = nullptr;
+  size = 0;
+}
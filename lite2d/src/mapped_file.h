@@ -0,0 +1,34 @@
+#ifndef __LITE2D_MAPPED_FILE_H__
+#pragma once
+#define __LITE2D_MAPPED_FILE_H__
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+/**
+ * Read-only view of a whole file, memory mapped where the platform allows it.
+ * @param data Pointer to the first byte of the file.
+ * @param size Size of the file in bytes.
+ */
+class MappedFile
+{
+public:
+  const unsigned char *data = nullptr;
+  size_t size = 0;
+
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() { close(); }
+
+  bool open(const std::filesystem::path &path);
+  void close();
+
+private:
+#if defined(_WIN32)
+  std::vector<char> fallback;
+#endif
+};
+
+#endif  // __LITE2D_MAPPED_FILE_H__
@@ -0,0 +1,225 @@
+#include "mesh_optimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "glmesh.h"
+#include "keyforms.h"
+
+namespace
+{
+// Forsyth's scoring constants ("Linear-Speed Vertex Cache Optimisation").
+constexpr int kScoreCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+
+float vertexScore(int cachePos, uint32_t remaining)
+{
+  if (remaining == 0)
+    return -1.0f;
+  float score = 0.0f;
+  if (cachePos >= 0)
+  {
+    if (cachePos < 3)
+    {
+      // The triangle just emitted: fixed score so it is not favoured too strongly.
+      score = kLastTriScore;
+    }
+    else
+    {
+      const float scaler = 1.0f / float(kScoreCacheSize - 3);
+      score = std::pow(1.0f - float(cachePos - 3) * scaler, kCacheDecayPower);
+    }
+  }
+  // Vertices with few triangles left get a boost so they are finished off and leave the cache.
+  score += kValenceBoostScale * std::pow(float(remaining), -kValenceBoostPower);
+  return score;
+}
+
+bool indicesInRange(const std::vector<uint32_t> &indices, size_t count, size_t vertexCount)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (indices[i] >= vertexCount)
+      return false;
+  }
+  return true;
+}
+} // namespace
+
+float computeAcmr(const std::vector<uint32_t> &indices, size_t vertexCount, unsigned cacheSize)
+{
+  const size_t triCount = indices.size() / 3;
+  if (triCount == 0)
+    return 0.0f;
+  // FIFO: a vertex that entered at miss k is evicted by miss k + cacheSize.
+  constexpr size_t kNotCached = std::numeric_limits<size_t>::max();
+  std::vector<size_t> enteredAt(vertexCount, kNotCached);
+  size_t misses = 0;
+  for (size_t i = 0; i < triCount * 3; ++i)
+  {
+    const uint32_t v = indices[i];
+    if (v >= vertexCount)
+      continue;
+    if (enteredAt[v] == kNotCached || misses - enteredAt[v] >= cacheSize)
+    {
+      enteredAt[v] = misses;
+      ++misses;
+    }
+  }
+  return float(misses) / float(triCount);
+}
+
+void optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount)
+{
+  const size_t triCount = indices.size() / 3;
+  if (triCount < 2 || vertexCount == 0 || !indicesInRange(indices, triCount * 3, vertexCount))
+    return;
+
+  // Per-vertex triangle lists; the first remaining[v] entries of a list are still unemitted.
+  std::vector<uint32_t> remaining(vertexCount, 0);
+  for (size_t i = 0; i < triCount * 3; ++i)
+    ++remaining[indices[i]];
+  std::vector<uint32_t> adjOffset(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v)
+    adjOffset[v + 1] = adjOffset[v] + remaining[v];
+  std::vector<uint32_t> adj(triCount * 3);
+  {
+    std::vector<uint32_t> fill(adjOffset.begin(), adjOffset.end() - 1);
+    for (size_t i = 0; i < triCount * 3; ++i)
+      adj[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  std::vector<int> cachePos(vertexCount, -1);
+  std::vector<float> vScore(vertexCount);
+  for (size_t v = 0; v < vertexCount; ++v)
+    vScore[v] = vertexScore(-1, remaining[v]);
+
+  std::vector<float> triScore(triCount);
+  std::vector<char> emitted(triCount, 0);
+  size_t best = 0;
+  for (size_t t = 0; t < triCount; ++t)
+  {
+    triScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+    if (triScore[t] > triScore[best])
+      best = t;
+  }
+
+  std::vector<uint32_t> out;
+  out.reserve(indices.size());
+  std::vector<uint32_t> cache, nextCache;
+  cache.reserve(kScoreCacheSize + 3);
+  nextCache.reserve(kScoreCacheSize + 3);
+  size_t scanPos = 0;
+  constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+  for (size_t emittedCount = 0; emittedCount < triCount; ++emittedCount)
+  {
+    if (best == kNone)
+    {
+      // Dead end: nothing in the cache touches a remaining triangle, take the next one in order.
+      while (emitted[scanPos])
+        ++scanPos;
+      best = scanPos;
+    }
+
+    const uint32_t tri[3] = {indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2]};
+    out.insert(out.end(), tri, tri + 3);
+    emitted[best] = 1;
+
+    for (uint32_t v : tri)
+    {
+      uint32_t *list = adj.data() + adjOffset[v];
+      uint32_t *last = list + remaining[v];
+      uint32_t *it = std::find(list, last, static_cast<uint32_t>(best));
+      if (it != last)
+      {
+        std::swap(*it, *(last - 1));
+        --remaining[v];
+      }
+    }
+
+    nextCache.assign(tri, tri + 3);
+    for (uint32_t v : cache)
+    {
+      if (v != tri[0] && v != tri[1] && v != tri[2])
+        nextCache.push_back(v);
+    }
+    for (size_t i = 0; i < nextCache.size(); ++i)
+    {
+      const uint32_t v = nextCache[i];
+      cachePos[v] = i < size_t(kScoreCacheSize) ? int(i) : -1;
+      vScore[v] = vertexScore(cachePos[v], remaining[v]);
+    }
+
+    // Only triangles around the vertices whose score moved can change rank.
+    best = kNone;
+    float bestScore = -1.0f;
+    for (uint32_t v : nextCache)
+    {
+      const uint32_t *list = adj.data() + adjOffset[v];
+      for (uint32_t j = 0; j < remaining[v]; ++j)
+      {
+        const uint32_t t = list[j];
+        triScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+        if (triScore[t] > bestScore)
+        {
+          bestScore = triScore[t];
+          best = t;
+        }
+      }
+    }
+    if (nextCache.size() > size_t(kScoreCacheSize))
+      nextCache.resize(kScoreCacheSize);
+    cache.swap(nextCache);
+  }
+
+  std::copy(out.begin(), out.end(), indices.begin());
+}
+
+void optimizeVertexFetch(ArtMesh &m)
+{
+  const size_t vertexCount = m.verts.size();
+  if (vertexCount == 0 || !indicesInRange(m.indices, m.indices.size(), vertexCount))
+    return;
+
+  constexpr uint32_t kUnmapped = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> remap(vertexCount, kUnmapped);
+  uint32_t next = 0;
+  for (uint32_t &idx : m.indices)
+  {
+    if (remap[idx] == kUnmapped)
+      remap[idx] = next++;
+    idx = remap[idx];
+  }
+  for (auto &r : remap)
+  {
+    if (r == kUnmapped)
+      r = next++;
+  }
+
+  std::vector<Vertex> verts(vertexCount);
+  for (size_t i = 0; i < vertexCount; ++i)
+    verts[remap[i]] = m.verts[i];
+  m.verts.swap(verts);
+  if (!m.keyforms.empty())
+    remapKeyformVertices(m.keyforms, remap);
+}
+
+MeshOptimizeStats optimizeMesh(ArtMesh &m)
+{
+  MeshOptimizeStats stats;
+  stats.triangles = m.indices.size() / 3;
+  stats.acmrBefore = computeAcmr(m.indices, m.verts.size());
+  std::vector<uint32_t> original = m.indices;
+  optimizeVertexCache(m.indices, m.verts.size());
+  // The heuristic can lose on meshes the exporter already ordered well; keep the better order.
+  if (computeAcmr(m.indices, m.verts.size()) > stats.acmrBefore)
+    m.indices.swap(original);
+  optimizeVertexFetch(m);
+  stats.acmrAfter = computeAcmr(m.indices, m.verts.size());
+  return stats;
+}
@@ -0,0 +1,118 @@
+#include "mesh_pose.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+void growBounds(SkinBounds &b, glm::vec2 p, float c, float s)
+{
+  const glm::vec2 r{p.x * c - p.y * s, p.x * s + p.y * c};
+  b.min = glm::min(b.min, p);
+  b.max = glm::max(b.max, p);
+  b.rotMin = glm::min(b.rotMin, r);
+  b.rotMax = glm::max(b.rotMax, r);
+}
+
+SkinBounds pointBounds(glm::vec2 first, float c, float s)
+{
+  const glm::vec2 r{first.x * c - first.y * s, first.x * s + first.y * c};
+  return SkinBounds{first, first, r, r};
+}
+} // namespace
+
+SkinBounds measureSkinBounds(std::span<const glm::vec2> pos, float rotateDeg)
+{
+  if (pos.empty())
+    return {};
+  const float rad = glm::radians(rotateDeg);
+  const float c = std::cos(rad), s = std::sin(rad);
+  SkinBounds b = pointBounds(pos.front(), c, s);
+  for (const glm::vec2 &p : pos)
+    growBounds(b, p, c, s);
+  return b;
+}
+
+SkinBounds measureRigidSkinBounds(const SkinStreams &skin, const SkinBone &bone, float rotateDeg)
+{
+  if (skin.hull.empty())
+    return {};
+  const float rad = glm::radians(rotateDeg);
+  const float c = std::cos(rad), s = std::sin(rad);
+  // An affine map takes the hull to the hull of the mapped points, so its image has the same extremes.
+  auto skinned = [&](glm::vec2 p)
+  { return glm::vec2(bone.a * p.x + bone.c * p.y + bone.tx, bone.b * p.x + bone.d * p.y + bone.ty); };
+  SkinBounds b = pointBounds(skinned(skin.hull.front()), c, s);
+  for (const glm::vec2 &p : skin.hull)
+    growBounds(b, skinned(p), c, s);
+  return b;
+}
+
+bool poseNeedsBounds(const MeshPose &pose)
+{
+  return pose.rotateDeg != 0.0f || pose.seamScaleX != 1.0f || pose.eyeScaleY != 1.0f || pose.mouthScaleY != 1.0f
+         || pose.mouthScaleX != 1.0f || pose.browLift != 0.0f;
+}
+
+SkinBone meshPoseTransform(const MeshPose &pose, const SkinBounds &bounds)
+{
+  // Translate.
+  glm::vec2 lo = bounds.min + pose.offset;
+  glm::vec2 hi = bounds.max + pose.offset;
+
+  // Rotate about the center of the translated bounds: p -> center + R * (p + offset - center).
+  const float rad = glm::radians(pose.rotateDeg);
+  const float c = std::cos(rad), s = std::sin(rad);
+  const glm::vec2 center = 0.5f * (lo + hi);
+  const glm::vec2 d = pose.offset - center;
+  SkinBone xf{c, s, -s, c, center.x + c * d.x - s * d.y, center.y + s * d.x + c * d.y};
+  lo = bounds.rotMin + glm::vec2(xf.tx, xf.ty);
+  hi = bounds.rotMax + glm::vec2(xf.tx, xf.ty);
+
+  // Axis scales about the center of the current bounds.
+  auto scaleX = [&](float k)
+  {
+    const float cx = 0.5f * (lo.x + hi.x);
+    xf.a *= k;
+    xf.c *= k;
+    xf.tx = cx + (xf.tx - cx) * k;
+    lo.x = cx + (lo.x - cx) * k;
+    hi.x = cx + (hi.x - cx) * k;
+    if (k < 0.0f)
+      std::swap(lo.x, hi.x);
+  };
+  auto scaleY = [&](float k)
+  {
+    const float cy = 0.5f * (lo.y + hi.y);
+    xf.b *= k;
+    xf.d *= k;
+    xf.ty = cy + (xf.ty - cy) * k;
+    lo.y = cy + (lo.y - cy) * k;
+    hi.y = cy + (hi.y - cy) * k;
+    if (k < 0.0f)
+      std::swap(lo.y, hi.y);
+  };
+  scaleX(pose.seamScaleX);
+  scaleY(pose.eyeScaleY);
+  scaleY(pose.mouthScaleY);
+  scaleX(pose.mouthScaleX);
+
+  xf.ty += pose.browLift * std::max(1e-4f, hi.y - lo.y);
+  return xf;
+}
+
+SkinBone composeSkinBones(const SkinBone &outer, const SkinBone &inner)
+{
+  return SkinBone{outer.a * inner.a + outer.c * inner.b,
+                  outer.b * inner.a + outer.d * inner.b,
+                  outer.a * inner.c + outer.c * inner.d,
+                  outer.b * inner.c + outer.d * inner.d,
+                  outer.a * inner.tx + outer.c * inner.ty + outer.tx,
+                  outer.b * inner.tx + outer.d * inner.ty + outer.ty};
+}
+
+void transformPositions(const SkinBone &xf, std::span<glm::vec2> pos)
+{
+  for (glm::vec2 &p : pos)
+    p = glm::vec2(xf.a * p.x + xf.c * p.y + xf.tx, xf.b * p.x + xf.d * p.y + xf.ty);
+}
@@ -0,0 +1,71 @@
+#ifndef __LITE2D_MESH_POSE_H__
+#pragma once
+#define __LITE2D_MESH_POSE_H__
+
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "skinning.h"
+
+// ---------- Per-mesh region pose ----------
+//
+// Engine::update moves each mesh after skinning: head translation and roll, seam squash, eye and
+// mouth scaling, brow lift. Every step pivots on the bounds of the positions the previous step
+// produced. All of them are affine, so they compose into one SkinBone; the bounds each step needs
+// follow analytically from the bounds of the skinned positions, without visiting the vertices.
+
+/**
+ * Region effects for one mesh, applied in declaration order. Defaults are the identity.
+ * @param offset Translation.
+ * @param rotateDeg Rotation in degrees about the bounds center.
+ * @param seamScaleX Horizontal scale about the bounds center.
+ * @param eyeScaleY Vertical scale about the bounds center.
+ * @param mouthScaleY Vertical scale about the bounds center.
+ * @param mouthScaleX Horizontal scale about the bounds center.
+ * @param browLift Vertical translation as a fraction of the bounds height.
+ */
+struct MeshPose
+{
+  glm::vec2 offset{0.0f};
+  float rotateDeg = 0.0f;
+  float seamScaleX = 1.0f;
+  float eyeScaleY = 1.0f;
+  float mouthScaleY = 1.0f;
+  float mouthScaleX = 1.0f;
+  float browLift = 0.0f;
+
+  bool operator==(const MeshPose &) const = default;
+};
+
+/**
+ * Bounds of a mesh's skinned positions.
+ * @param min Minimum of the positions.
+ * @param max Maximum of the positions.
+ * @param rotMin Minimum of the positions rotated by MeshPose::rotateDeg about the origin.
+ * @param rotMax Maximum of the same.
+ */
+struct SkinBounds
+{
+  glm::vec2 min{0.0f}, max{0.0f};
+  glm::vec2 rotMin{0.0f}, rotMax{0.0f};
+};
+
+// Bounds of skinned positions, in one pass.
+SkinBounds measureSkinBounds(std::span<const glm::vec2> pos, float rotateDeg);
+
+// Bounds of a rigid mesh skinned by bone, from the rest-pose hull (SkinStreams::hull).
+SkinBounds measureRigidSkinBounds(const SkinStreams &skin, const SkinBone &bone, float rotateDeg);
+
+// The transform that applies pose to positions with the given bounds.
+SkinBone meshPoseTransform(const MeshPose &pose, const SkinBounds &bounds);
+
+// Whether meshPoseTransform depends on the bounds, i.e. pose is more than a translation.
+bool poseNeedsBounds(const MeshPose &pose);
+
+// outer(inner(p)).
+SkinBone composeSkinBones(const SkinBone &outer, const SkinBone &inner);
+
+void transformPositions(const SkinBone &xf, std::span<glm::vec2> pos);
+
+#endif  // __LITE2D_MESH_POSE_H__
@@ -0,0 +1,90 @@
+#include "mesh_regions.h"
+
+#include <cctype>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "model.h"
+
+namespace
+{
+using PartMap = std::unordered_map<std::string, std::unordered_set<std::string>>;
+
+bool hasAnyTag(const std::unordered_set<std::string> *tags, std::initializer_list<const char *> parts)
+{
+  if (!tags)
+    return false;
+  for (const auto *part : parts)
+  {
+    if (tags->count(part))
+      return true;
+  }
+  return false;
+}
+
+const std::unordered_set<std::string> *tagsOf(const PartMap &map, const std::string &meshId)
+{
+  auto it = map.find(meshId);
+  return it == map.end() ? nullptr : &it->second;
+}
+
+std::string toLowerCopy(const std::string &value)
+{
+  std::string out = value;
+  for (auto &ch : out)
+    ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+  return out;
+}
+
+bool containsToken(const std::string &haystack, const char *needle)
+{
+  return haystack.find(needle) != std::string::npos;
+}
+
+uint32_t classifyMesh(const Model &model, const std::string &meshId)
+{
+  uint32_t regions = 0;
+  if (!model.mesh_face_parts.empty())
+  {
+    const auto *face = tagsOf(model.mesh_face_parts, meshId);
+    if (hasAnyTag(face, {"eye_left", "eyelid_left", "eye_white_left", "eye_ball_left"}))
+      regions |= kMeshRegionEyeLeft;
+    if (hasAnyTag(face, {"eye_right", "eyelid_right", "eye_white_right", "eye_ball_right"}))
+      regions |= kMeshRegionEyeRight;
+    if (hasAnyTag(face, {"eye"}))
+      regions |= kMeshRegionEye;
+    if (hasAnyTag(face, {"mouth", "lip_upper", "lip_lower", "tongue", "teeth"}))
+      regions |= kMeshRegionMouth;
+    if (hasAnyTag(face, {"brow_left"}))
+      regions |= kMeshRegionBrowLeft;
+    if (hasAnyTag(face, {"brow_right"}))
+      regions |= kMeshRegionBrowRight;
+    if (regions != 0 || hasAnyTag(face, {"face", "face_motion", "nose", "cheek_left", "cheek_right"}))
+      regions |= kMeshRegionFace;
+  }
+  else
+  {
+    // No parts file: guess eyes and mouth from the id.
+    const std::string lowerId = toLowerCopy(meshId);
+    if (containsToken(lowerId, "eye") && !containsToken(lowerId, "brow"))
+      regions |= kMeshRegionEye | kMeshRegionFace;
+    if (containsToken(lowerId, "mouth") || containsToken(lowerId, "lip"))
+      regions |= kMeshRegionMouth | kMeshRegionFace;
+  }
+
+  if (hasAnyTag(tagsOf(model.mesh_body_parts, meshId),
+                {"body", "torso", "chest", "shoulder_left", "shoulder_right", "neck", "head", "hair"}))
+    regions |= kMeshRegionBody;
+  if (hasAnyTag(tagsOf(model.mesh_seam_parts, meshId), {"neck_seam", "jaw_seam"}))
+    regions |= kMeshRegionSeam;
+  return regions;
+}
+} // namespace
+
+void classifyMeshRegions(Model &model)
+{
+  for (auto &kv : model.meshes)
+    kv.second.regions = classifyMesh(model, kv.first);
+}
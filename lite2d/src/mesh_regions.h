@@ -0,0 +1,34 @@
+#ifndef __LITE2D_MESH_REGIONS_H__
+#pragma once
+#define __LITE2D_MESH_REGIONS_H__
+
+#include <cstdint>
+
+struct Model;
+
+// ---------- Mesh region classification ----------
+//
+// The roles Engine::update deforms a mesh by, worked out once from the part tags (or, without a
+// parts file, from the mesh id) and stored as bits in ArtMesh::regions.
+
+enum MeshRegion : uint32_t
+{
+  kMeshRegionEyeLeft = 1u << 0,
+  kMeshRegionEyeRight = 1u << 1,
+  kMeshRegionEye = 1u << 2, // eye without a side
+  kMeshRegionMouth = 1u << 3,
+  kMeshRegionBrowLeft = 1u << 4,
+  kMeshRegionBrowRight = 1u << 5,
+  kMeshRegionFace = 1u << 6, // any of the above, or tagged face/nose/cheek
+  kMeshRegionBody = 1u << 7,
+  kMeshRegionSeam = 1u << 8,
+};
+
+constexpr uint32_t kMeshRegionAnyEye = kMeshRegionEyeLeft | kMeshRegionEyeRight | kMeshRegionEye;
+constexpr uint32_t kMeshRegionAnyBrow = kMeshRegionBrowLeft | kMeshRegionBrowRight;
+
+// Sets ArtMesh::regions on every mesh of model from its face/body/seam part maps. Call again after
+// the part maps or mesh ids change.
+void classifyMeshRegions(Model &model);
+
+#endif  // __LITE2D_MESH_REGIONS_H__
@@ -12,41 +12,38 @@
 #include "anim_clip.h"
 #include "expression.h"
 #include "deformer.h"
+#include "deformer_tree.h"
 #include "glmesh.h"
+#include "param_store.h"
 
 /**
- * A parameter that model requires.
- * @param id The unique identifier of the parameter.
- * @param min_v The minimum value of the parameter.
- * @param max_v The maximum value of the parameter.
- * @param def_v The default value of the parameter.
- * @param cur_v The current value of the parameter.
+ * A drawable as it appeared in the source .moc3.json, kept so sidecar changes can be re-applied
+ * without re-reading the model.
+ * @param id The mesh id the drawable was given.
+ * @param kept False if the drawable was dropped (degenerate geometry or a duplicate id).
  */
-struct ModelParameter
+struct DrawableSource
 {
   std::string id;
-  float min_v{-1}, max_v{1}, def_v{0}, cur_v{0};
-  ModelParameter() = default;
-  ModelParameter(std::string id_, float mn, float mx, float df)
-      : id(std::move(id_)), min_v(mn), max_v(mx), def_v(df), cur_v(df) {}
-  void reset() { cur_v = def_v; }
-  void set(float v) { cur_v = glm::clamp(v, min_v, max_v); }
-  float value() const { return cur_v; }
+  bool kept = true;
 };
 
 /**
  * The 2D model consisting of parameters, expressions, deformers, meshes, and animations.
- * @param params The model parameters.
+ * @param params The model parameters; tracks, expressions and keyforms refer to them by handle.
  * @param expressions The expressions defined in the model.
  * @param deformers The deformers (bones) in the model.
+ * @param deformerTree The deformers in evaluation order, with their world matrices.
  * @param meshes The 2D meshes in the model.
  * @param animations The animation clips in the model.
+ * @param drawable_sources Usable drawables in file order (empty for models not loaded from .moc3.json).
  */
 struct Model
 {
-  std::unordered_map<std::string, ModelParameter> params;
+  ParamStore params;
   std::unordered_map<std::string, Expression> expressions;
   std::unordered_map<std::string, Deformer> deformers;
+  DeformerTree deformerTree;
   std::unordered_map<std::string, ArtMesh> meshes;
   // Face part mapping: mesh id -> set of face part tags
   std::unordered_map<std::string, std::unordered_set<std::string>> mesh_face_parts;
@@ -55,19 +52,71 @@ struct Model
   // Seam mapping: mesh id -> set of seam tags (e.g., neck_seam)
   std::unordered_map<std::string, std::unordered_set<std::string>> mesh_seam_parts;
   std::vector<AnimationClip> animations;
+  std::vector<DrawableSource> drawable_sources;
   void resetParams()
   {
-    for (auto &kv : params)
-      kv.second.reset();
+    params.resetAll();
   }
   void addParam(const char* id, float mn, float mx, float defv=0)
   {
-    params[id] = ModelParameter{ id, mn, mx, defv };
+    params.add(id, mn, mx, defv);
   }
   void removeParam(const char* id)
   {
-    params.erase(id);
+    params.remove(id);
   }
+
+  // Resolves the parameter handles of every animation track, expression entry and keyform axis.
+  void bindParams()
+  {
+    for (auto &clip : animations)
+      for (auto &tr : clip.tracks)
+        tr.param = params.find(tr.param_id);
+    for (auto &kv : expressions)
+      for (auto &ep : kv.second.params)
+        ep.param = params.find(ep.param_id);
+    for (auto &kv : meshes)
+      for (auto &axis : kv.second.keyforms.axes)
+        axis.param = params.find(axis.param_id);
+    boundParamLayout = params.layoutVersion();
+    boundAnimations = animations.size();
+    boundExpressions = expressions.size();
+    boundMeshes = meshes.size();
+  }
+
+  // Re-binds if parameters, animations, expressions or meshes were added or removed since the last
+  // bind. Edits to the param_id of an existing track, entry or keyform axis need an explicit bindParams().
+  void ensureParamsBound()
+  {
+    if (boundParamLayout != params.layoutVersion() || boundAnimations != animations.size()
+        || boundExpressions != expressions.size() || boundMeshes != meshes.size())
+      bindParams();
+  }
+
+  // Flattens the deformer hierarchy and resolves each mesh's deformers to tree indices.
+  void buildDeformerTree()
+  {
+    deformerTree.build(deformers);
+    for (auto &kv : meshes)
+    {
+      ArtMesh &m = kv.second;
+      m.deformer_index.resize(m.deformers.size());
+      for (size_t b = 0; b < m.deformers.size(); ++b)
+        m.deformer_index[b] = deformerTree.find(m.deformers[b]);
+    }
+    treeDeformers = deformers.size();
+    treeMeshes = meshes.size();
+  }
+
+  // Rebuilds if deformers or meshes were added or removed since the last build. Replacing
+  // deformers, or editing their children or a mesh's deformers, needs an explicit buildDeformerTree().
+  void ensureDeformerTree()
+  {
+    if (treeDeformers != deformers.size() || treeMeshes != meshes.size())
+      buildDeformerTree();
+  }
+
+  // Parameter set of the built-in sample model; loaded models take theirs from the file.
   void initParams()
   {
     addParam("ParamAngleX",-30,30);
@@ -94,6 +143,14 @@ struct Model
     addParam("ParamHairSideFuwa",-1,1,0);
     addParam("ParamHairBackFuwa",-1,1,0);
   }
+
+private:
+  uint32_t boundParamLayout = ~0u;
+  size_t boundAnimations = 0;
+  size_t boundExpressions = 0;
+  size_t boundMeshes = 0;
+  size_t treeDeformers = ~size_t(0);
+  size_t treeMeshes = ~size_t(0);
 };
 
 #endif  // __LITE2D_MODEL_H__
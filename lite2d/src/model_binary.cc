@@ -0,0 +1,721 @@
+#include "model_binary.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "deformer.h"
+#include "engine.h"
+#include "keyforms.h"
+#include "load_profile.h"
+#include "mapped_file.h"
+#include "mesh_regions.h"
+#include "model.h"
+#include "sidecar_manifest.h"
+#include "skinning.h"
+#include "vertex_quant.h"
+
+namespace
+{
+bool endsWith(const std::string &value, const std::string &suffix)
+{
+  if (suffix.size() > value.size())
+    return false;
+  return std::equal(suffix.rbegin(), suffix.rend(), value.rbegin());
+}
+
+size_t alignUp(size_t v) { return (v + 7u) & ~size_t(7u); }
+
+// How a sidecar path is recorded in the header, so that spellings of the same file compare equal.
+std::string sidecarKey(const std::filesystem::path &path)
+{
+  std::error_code ec;
+  const std::filesystem::path abs = std::filesystem::absolute(path, ec);
+  return (ec ? path : abs).lexically_normal().generic_string();
+}
+
+/**
+ * Accumulates the sections of a .lite2d file in memory before it is written out.
+ */
+struct BinaryWriter
+{
+  std::vector<unsigned char> bytes;
+
+  size_t beginSection()
+  {
+    bytes.resize(alignUp(bytes.size()), 0);
+    return bytes.size();
+  }
+
+  template <typename T>
+  void append(const T *items, size_t count)
+  {
+    if (count == 0)
+      return;
+    const size_t at = bytes.size();
+    bytes.resize(at + sizeof(T) * count);
+    std::memcpy(bytes.data() + at, items, sizeof(T) * count);
+  }
+
+  template <typename T>
+  size_t appendSection(const std::vector<T> &items)
+  {
+    size_t at = beginSection();
+    append(items.data(), items.size());
+    return at;
+  }
+};
+
+/**
+ * Interns strings into the table written at the head of the file.
+ */
+struct StringTable
+{
+  std::vector<std::string> strings;
+  std::unordered_map<std::string, uint32_t> index;
+
+  uint32_t intern(const std::string &s)
+  {
+    auto it = index.find(s);
+    if (it != index.end())
+      return it->second;
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.push_back(s);
+    index.emplace(s, id);
+    return id;
+  }
+};
+
+void appendTags(const std::unordered_map<std::string, std::unordered_set<std::string>> &tags,
+                Lite2dTagKind kind,
+                StringTable &strings,
+                std::vector<Lite2dTagRecord> &out)
+{
+  // Sort so that the output is byte-for-byte reproducible.
+  std::vector<std::pair<std::string, std::string>> pairs;
+  for (const auto &kv : tags)
+    for (const auto &tag : kv.second)
+      pairs.emplace_back(kv.first, tag);
+  std::sort(pairs.begin(), pairs.end());
+  for (const auto &p : pairs)
+    out.push_back({strings.intern(p.first), strings.intern(p.second), static_cast<uint32_t>(kind)});
+}
+
+/**
+ * Bounds-checked accessor over a mapped .lite2d file.
+ */
+struct BinaryView
+{
+  const unsigned char *base = nullptr;
+  size_t size = 0;
+  const uint32_t *stringOffsets = nullptr;
+  const char *stringBlob = nullptr;
+  uint32_t stringCount = 0;
+
+  template <typename T>
+  const T *section(uint64_t offset, uint64_t count) const
+  {
+    if (offset % alignof(T) != 0 || offset > size)
+      return nullptr;
+    if (count > (size - offset) / sizeof(T))
+      return nullptr;
+    return reinterpret_cast<const T *>(base + offset);
+  }
+
+  // Locates and checks the string table; false if it is corrupt.
+  bool bindStrings(const Lite2dHeader &hdr)
+  {
+    stringCount = hdr.string_count;
+    stringOffsets = section<uint32_t>(hdr.string_table_offset, uint64_t(hdr.string_count) + 1);
+    if (!stringOffsets)
+      return false;
+    const uint64_t blobOffset = hdr.string_table_offset + (uint64_t(hdr.string_count) + 1) * sizeof(uint32_t);
+    stringBlob = section<char>(blobOffset, stringOffsets[hdr.string_count]);
+    if (!stringBlob)
+      return false;
+    for (uint32_t i = 0; i < hdr.string_count; ++i)
+    {
+      if (stringOffsets[i] > stringOffsets[i + 1])
+        return false;
+    }
+    return true;
+  }
+
+  bool validString(uint32_t id) const { return id < stringCount; }
+
+  std::string str(uint32_t id) const
+  {
+    if (!validString(id))
+      return {};
+    return std::string(stringBlob + stringOffsets[id], stringOffsets[id + 1] - stringOffsets[id]);
+  }
+};
+
+// The keyforms of mesh record rec; false if they point outside their sections or do not fit the mesh.
+bool readKeyforms(const BinaryView &view, const Lite2dHeader &hdr, const Lite2dMeshRecord &rec,
+                  const Lite2dKeyformAxisRecord *axisRecs, const float *keys, const Lite2dKeyformRecord *formRecs,
+                  const uint32_t *coords, const uint32_t *blocks, const float *deltas, MeshKeyforms &out)
+{
+  out = {};
+  out.axes.resize(rec.keyform_axis_count);
+  for (uint32_t a = 0; a < rec.keyform_axis_count; ++a)
+  {
+    const auto &ar = axisRecs[rec.keyform_axis_first + a];
+    if (uint64_t(ar.key_first) + ar.key_count > hdr.keyform_key_count || !view.validString(ar.param))
+      return false;
+    out.axes[a].param_id = view.str(ar.param);
+    out.axes[a].keys.assign(keys + ar.key_first, keys + ar.key_first + ar.key_count);
+  }
+  out.forms.resize(rec.keyform_count);
+  for (uint32_t f = 0; f < rec.keyform_count; ++f)
+  {
+    const auto &fr = formRecs[rec.keyform_first + f];
+    if (uint64_t(fr.coord_first) + rec.keyform_axis_count > hdr.keyform_coord_count
+        || uint64_t(fr.block_first) + fr.block_count > hdr.keyform_block_count)
+      return false;
+    Keyform &form = out.forms[f];
+    form.key.assign(coords + fr.coord_first, coords + fr.coord_first + rec.keyform_axis_count);
+    form.blocks.assign(blocks + fr.block_first, blocks + fr.block_first + fr.block_count);
+    form.dx.reserve(size_t(fr.block_count) * kSkinDeltaBlock);
+    form.dy.reserve(size_t(fr.block_count) * kSkinDeltaBlock);
+    for (uint32_t b = 0; b < fr.block_count; ++b)
+    {
+      const float *d = deltas + (size_t(fr.block_first) + b) * 2 * kSkinDeltaBlock;
+      form.dx.insert(form.dx.end(), d, d + kSkinDeltaBlock);
+      form.dy.insert(form.dy.end(), d + kSkinDeltaBlock, d + 2 * kSkinDeltaBlock);
+    }
+  }
+  return rec.keyform_count == 0 || dropInvalidKeyforms(out, rec.vertex_count) == 0;
+}
+} // namespace
+
+std::filesystem::path getCompiledModelPath(const std::filesystem::path &moc3JsonPath)
+{
+  const std::string suffix = ".moc3.json";
+  const std::string pathStr = moc3JsonPath.string();
+  if (endsWith(pathStr, suffix))
+    return std::filesystem::path(pathStr.substr(0, pathStr.size() - suffix.size()) + ".lite2d");
+  return std::filesystem::path(pathStr + ".lite2d");
+}
+
+bool isCompiledModelFresh(const std::filesystem::path &compiledPath,
+                          const std::filesystem::path &moc3JsonPath,
+                          const std::filesystem::path &renderSettingsPath,
+                          const std::filesystem::path &partsPath)
+{
+  std::error_code ec;
+  const auto compiledTime = std::filesystem::last_write_time(compiledPath, ec);
+  if (ec)
+    return false;
+
+  const std::filesystem::path sources[] = {
+      moc3JsonPath,
+      renderSettingsPath.empty() ? getRenderSettingsPath(moc3JsonPath) : renderSettingsPath,
+      partsPath.empty() ? getPartsPath(moc3JsonPath) : partsPath,
+  };
+  for (const auto &src : sources)
+  {
+    const auto srcTime = std::filesystem::last_write_time(src, ec);
+    if (!ec && srcTime > compiledTime)
+      return false;
+  }
+
+  // Sidecars other than the ones baked in are not covered by the timestamps.
+  MappedFile file;
+  if (!file.open(compiledPath))
+    return false;
+  BinaryView view;
+  view.base = file.data;
+  view.size = file.size;
+  const Lite2dHeader *hdr = view.section<Lite2dHeader>(0, 1);
+  if (!hdr || std::memcmp(hdr->magic, kLite2dMagic, sizeof(kLite2dMagic)) != 0 || hdr->version != kLite2dVersion
+      || hdr->endian_tag != kLite2dEndianTag || hdr->file_size != file.size || !view.bindStrings(*hdr))
+    return false;
+  return view.validString(hdr->render_settings_path) && view.validString(hdr->parts_path)
+         && view.str(hdr->render_settings_path) == sidecarKey(sources[1])
+         && view.str(hdr->parts_path) == sidecarKey(sources[2]);
+}
+
+bool writeModelBinary(const std::filesystem::path &outPath,
+                      const Model &model,
+                      const glm::vec2 &canvas,
+                      const std::unordered_map<std::string, std::filesystem::path> &drawableTextures,
+                      const std::filesystem::path &renderSettingsPath,
+                      const std::filesystem::path &partsPath)
+{
+  StringTable strings;
+
+  // Stable mesh order: by draw order, then id.
+  std::vector<const ArtMesh *> meshes;
+  meshes.reserve(model.meshes.size());
+  for (const auto &kv : model.meshes)
+    meshes.push_back(&kv.second);
+  std::sort(meshes.begin(), meshes.end(), [](const ArtMesh *a, const ArtMesh *b)
+            { return a->draw_order != b->draw_order ? a->draw_order < b->draw_order : a->id < b->id; });
+
+  std::vector<Lite2dMeshRecord> meshRecords;
+  std::vector<uint16_t> positions; // x, y per vertex
+  std::vector<uint16_t> uvs;       // u, v per vertex
+  std::vector<uint32_t> indices;
+  std::vector<Lite2dSkinRecord> skins;
+  std::vector<uint32_t> nameLists;
+  std::vector<Lite2dKeyformAxisRecord> keyformAxes;
+  std::vector<float> keyformKeys;
+  std::vector<Lite2dKeyformRecord> keyforms;
+  std::vector<uint32_t> keyformCoords, keyformBlocks;
+  std::vector<float> keyformDeltas;
+  meshRecords.reserve(meshes.size());
+
+  for (const ArtMesh *m : meshes)
+  {
+    Lite2dMeshRecord rec{};
+    rec.id = strings.intern(m->id);
+    rec.texture_id = strings.intern(m->texture_id);
+    rec.clipping_mask_id = m->clipping_mask_id.empty() ? kLite2dNoString : strings.intern(m->clipping_mask_id);
+    rec.draw_order = m->draw_order;
+    rec.blend_mode = m->blend_mode;
+    rec.opacity = m->opacity;
+    rec.vertex_first = static_cast<uint32_t>(positions.size() / 2);
+    rec.vertex_count = static_cast<uint32_t>(m->verts.size());
+    rec.index_first = static_cast<uint32_t>(indices.size());
+    rec.index_count = static_cast<uint32_t>(m->indices.size());
+    rec.deformer_first = static_cast<uint32_t>(nameLists.size());
+    rec.deformer_count = static_cast<uint32_t>(m->deformers.size());
+
+    // Per-vertex colors are flattened to the first vertex; the moc3 path never emits anything else.
+    glm::vec3 color = m->verts.empty() ? glm::vec3(1.0f) : m->verts.front().color;
+    rec.color[0] = color.r;
+    rec.color[1] = color.g;
+    rec.color[2] = color.b;
+
+    QuantRange posRange, uvRange;
+    if (!m->verts.empty())
+    {
+      posRange = quantRangeOf(&m->verts[0].pos, m->verts.size(), sizeof(Vertex));
+      uvRange = quantRangeOf(&m->verts[0].uv, m->verts.size(), sizeof(Vertex));
+    }
+    rec.pos_origin[0] = posRange.origin.x;
+    rec.pos_origin[1] = posRange.origin.y;
+    rec.pos_extent[0] = posRange.extent.x;
+    rec.pos_extent[1] = posRange.extent.y;
+    rec.uv_origin[0] = uvRange.origin.x;
+    rec.uv_origin[1] = uvRange.origin.y;
+    rec.uv_extent[0] = uvRange.extent.x;
+    rec.uv_extent[1] = uvRange.extent.y;
+
+    bool rigid = true;
+    for (const auto &v : m->verts)
+    {
+      positions.push_back(quantizeUnorm16(v.pos.x, posRange.origin.x, posRange.extent.x));
+      positions.push_back(quantizeUnorm16(v.pos.y, posRange.origin.y, posRange.extent.y));
+      uvs.push_back(quantizeUnorm16(v.uv.x, uvRange.origin.x, uvRange.extent.x));
+      uvs.push_back(quantizeUnorm16(v.uv.y, uvRange.origin.y, uvRange.extent.y));
+      if (v.bone[0] != 0 || v.weight[0] != 1.0f || v.weight[1] != 0.0f)
+        rigid = false;
+    }
+    if (m->visible)
+      rec.flags |= kLite2dMeshVisible;
+    if (rigid)
+    {
+      rec.flags |= kLite2dMeshRigidSkin;
+    }
+    else
+    {
+      rec.skin_first = static_cast<uint32_t>(skins.size());
+      for (const auto &v : m->verts)
+        skins.push_back({{v.bone[0], v.bone[1]}, {v.weight[0], v.weight[1]}});
+    }
+    indices.insert(indices.end(), m->indices.begin(), m->indices.end());
+    for (const auto &d : m->deformers)
+      nameLists.push_back(strings.intern(d));
+
+    rec.keyform_axis_first = static_cast<uint32_t>(keyformAxes.size());
+    rec.keyform_axis_count = static_cast<uint32_t>(m->keyforms.axes.size());
+    for (const auto &axis : m->keyforms.axes)
+    {
+      keyformAxes.push_back({strings.intern(axis.param_id), static_cast<uint32_t>(keyformKeys.size()),
+                             static_cast<uint32_t>(axis.keys.size()), 0});
+      keyformKeys.insert(keyformKeys.end(), axis.keys.begin(), axis.keys.end());
+    }
+    rec.keyform_first = static_cast<uint32_t>(keyforms.size());
+    rec.keyform_count = static_cast<uint32_t>(m->keyforms.forms.size());
+    for (const auto &form : m->keyforms.forms)
+    {
+      keyforms.push_back({static_cast<uint32_t>(keyformCoords.size()), static_cast<uint32_t>(keyformBlocks.size()),
+                          static_cast<uint32_t>(form.blocks.size()), 0});
+      keyformCoords.insert(keyformCoords.end(), form.key.begin(), form.key.end());
+      keyformBlocks.insert(keyformBlocks.end(), form.blocks.begin(), form.blocks.end());
+      for (size_t b = 0; b < form.blocks.size(); ++b)
+      {
+        keyformDeltas.insert(keyformDeltas.end(), form.dx.begin() + b * kSkinDeltaBlock,
+                             form.dx.begin() + (b + 1) * kSkinDeltaBlock);
+        keyformDeltas.insert(keyformDeltas.end(), form.dy.begin() + b * kSkinDeltaBlock,
+                             form.dy.begin() + (b + 1) * kSkinDeltaBlock);
+      }
+    }
+    meshRecords.push_back(rec);
+  }
+
+  std::vector<std::string> deformerIds;
+  for (const auto &kv : model.deformers)
+    deformerIds.push_back(kv.first);
+  std::sort(deformerIds.begin(), deformerIds.end());
+  std::vector<Lite2dDeformerRecord> deformerRecords;
+  for (const auto &id : deformerIds)
+  {
+    const Deformer &d = model.deformers.at(id);
+    Lite2dDeformerRecord rec{};
+    rec.id = strings.intern(d.id);
+    rec.parent = d.parent.empty() ? kLite2dNoString : strings.intern(d.parent);
+    rec.pos[0] = d.pos.x;
+    rec.pos[1] = d.pos.y;
+    rec.rot_deg = d.rot_deg;
+    rec.scale[0] = d.scale.x;
+    rec.scale[1] = d.scale.y;
+    deformerRecords.push_back(rec);
+  }
+
+  std::vector<Lite2dTagRecord> tags;
+  appendTags(model.mesh_face_parts, Lite2dTagKind::Face, strings, tags);
+  appendTags(model.mesh_body_parts, Lite2dTagKind::Body, strings, tags);
+  appendTags(model.mesh_seam_parts, Lite2dTagKind::Seam, strings, tags);
+
+  // Texture paths are stored relative to the output so the compiled model can move with its assets.
+  std::error_code ec;
+  const std::filesystem::path outDir = std::filesystem::absolute(outPath, ec).parent_path();
+  std::vector<std::string> textureIds;
+  for (const auto &kv : drawableTextures)
+    textureIds.push_back(kv.first);
+  std::sort(textureIds.begin(), textureIds.end());
+  std::vector<Lite2dTextureRecord> textures;
+  for (const auto &tid : textureIds)
+  {
+    std::filesystem::path abs = std::filesystem::absolute(drawableTextures.at(tid), ec);
+    std::filesystem::path rel = abs.lexically_normal().lexically_relative(outDir);
+    if (rel.empty())
+      rel = abs;
+    textures.push_back({strings.intern(tid), strings.intern(rel.generic_string())});
+  }
+
+  std::vector<Lite2dParamRecord> params;
+  params.reserve(model.params.size());
+  for (size_t h = 0; h < model.params.size(); ++h)
+  {
+    // Removed parameters keep their slot but lose their name; there is nothing to bind them by.
+    if (model.params.find(model.params.ids[h]) != h)
+      continue;
+    params.push_back({strings.intern(model.params.ids[h]), model.params.min[h], model.params.max[h],
+                      model.params.def[h]});
+  }
+
+  // The sidecars the model was built from, so a viewer given other ones does not use this file.
+  const uint32_t renderSettingsKey = strings.intern(sidecarKey(renderSettingsPath));
+  const uint32_t partsKey = strings.intern(sidecarKey(partsPath));
+
+  std::vector<uint32_t> stringOffsets;
+  std::string stringBlob;
+  stringOffsets.reserve(strings.strings.size() + 1);
+  for (const auto &s : strings.strings)
+  {
+    stringOffsets.push_back(static_cast<uint32_t>(stringBlob.size()));
+    stringBlob += s;
+  }
+  stringOffsets.push_back(static_cast<uint32_t>(stringBlob.size()));
+
+  Lite2dHeader header{};
+  std::memcpy(header.magic, kLite2dMagic, sizeof(header.magic));
+  header.version = kLite2dVersion;
+  header.endian_tag = kLite2dEndianTag;
+  header.canvas_w = canvas.x;
+  header.canvas_h = canvas.y;
+  header.string_count = static_cast<uint32_t>(strings.strings.size());
+  header.mesh_count = static_cast<uint32_t>(meshRecords.size());
+  header.vertex_count = static_cast<uint32_t>(positions.size() / 2);
+  header.index_count = static_cast<uint32_t>(indices.size());
+  header.skin_count = static_cast<uint32_t>(skins.size());
+  header.name_list_count = static_cast<uint32_t>(nameLists.size());
+  header.deformer_count = static_cast<uint32_t>(deformerRecords.size());
+  header.tag_count = static_cast<uint32_t>(tags.size());
+  header.texture_count = static_cast<uint32_t>(textures.size());
+  header.param_count = static_cast<uint32_t>(params.size());
+  header.keyform_axis_count = static_cast<uint32_t>(keyformAxes.size());
+  header.keyform_key_count = static_cast<uint32_t>(keyformKeys.size());
+  header.keyform_count = static_cast<uint32_t>(keyforms.size());
+  header.keyform_coord_count = static_cast<uint32_t>(keyformCoords.size());
+  header.keyform_block_count = static_cast<uint32_t>(keyformBlocks.size());
+  header.render_settings_path = renderSettingsKey;
+  header.parts_path = partsKey;
+
+  BinaryWriter w;
+  w.append(&header, 1);
+  header.string_table_offset = w.appendSection(stringOffsets);
+  w.append(stringBlob.data(), stringBlob.size());
+  header.mesh_table_offset = w.appendSection(meshRecords);
+  header.position_offset = w.appendSection(positions);
+  header.uv_offset = w.appendSection(uvs);
+  header.index_offset = w.appendSection(indices);
+  header.skin_offset = w.appendSection(skins);
+  header.name_list_offset = w.appendSection(nameLists);
+  header.deformer_offset = w.appendSection(deformerRecords);
+  header.tag_offset = w.appendSection(tags);
+  header.texture_offset = w.appendSection(textures);
+  header.param_offset = w.appendSection(params);
+  header.keyform_axis_offset = w.appendSection(keyformAxes);
+  header.keyform_key_offset = w.appendSection(keyformKeys);
+  header.keyform_offset = w.appendSection(keyforms);
+  header.keyform_coord_offset = w.appendSection(keyformCoords);
+  header.keyform_block_offset = w.appendSection(keyformBlocks);
+  header.keyform_delta_offset = w.appendSection(keyformDeltas);
+  header.file_size = w.bytes.size();
+  std::memcpy(w.bytes.data(), &header, sizeof(header));
+
+  // Write next to the target and rename, so a running viewer never maps a half-written file.
+  std::filesystem::path tmpPath = outPath;
+  tmpPath += ".tmp";
+  {
+    std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!ofs)
+    {
+      std::cerr << "Cannot open " << tmpPath << " for writing\n";
+      return false;
+    }
+    ofs.write(reinterpret_cast<const char *>(w.bytes.data()), static_cast<std::streamsize>(w.bytes.size()));
+    if (!ofs)
+    {
+      std::cerr << "Failed to write " << tmpPath << "\n";
+      return false;
+    }
+  }
+  std::filesystem::rename(tmpPath, outPath, ec);
+  if (ec)
+  {
+    std::cerr << "Failed to move " << tmpPath << " to " << outPath << ": " << ec.message() << "\n";
+    return false;
+  }
+
+  std::cerr << "Wrote " << meshRecords.size() << " meshes (" << header.vertex_count << " vertices, "
+            << indices.size() << " indices) to " << outPath << "\n";
+  return true;
+}
+
+bool loadModelFromLite2d(const std::filesystem::path &binPath,
+                         Engine &eng,
+                         std::unordered_map<std::string, std::filesystem::path> &drawableTextures)
+{
+  LoadPhaseScope phase("binary_decode");
+  MappedFile file;
+  if (!file.open(binPath))
+  {
+    std::cerr << "Cannot open compiled model: " << binPath << "\n";
+    return false;
+  }
+  phase.setItems(file.size);
+
+  BinaryView view;
+  view.base = file.data;
+  view.size = file.size;
+
+  const Lite2dHeader *hdr = view.section<Lite2dHeader>(0, 1);
+  if (!hdr || std::memcmp(hdr->magic, kLite2dMagic, sizeof(kLite2dMagic)) != 0)
+  {
+    std::cerr << "Not a lite2d compiled model: " << binPath << "\n";
+    return false;
+  }
+  if (hdr->version != kLite2dVersion || hdr->endian_tag != kLite2dEndianTag || hdr->file_size != file.size)
+  {
+    std::cerr << "Unsupported or truncated compiled model (version " << hdr->version << "): " << binPath << "\n";
+    return false;
+  }
+
+  const auto *meshRecs = view.section<Lite2dMeshRecord>(hdr->mesh_table_offset, hdr->mesh_count);
+  const auto *positions = view.section<uint16_t>(hdr->position_offset, uint64_t(hdr->vertex_count) * 2);
+  const auto *uvs = view.section<uint16_t>(hdr->uv_offset, uint64_t(hdr->vertex_count) * 2);
+  const auto *indices = view.section<uint32_t>(hdr->index_offset, hdr->index_count);
+  const auto *skins = view.section<Lite2dSkinRecord>(hdr->skin_offset, hdr->skin_count);
+  const auto *nameLists = view.section<uint32_t>(hdr->name_list_offset, hdr->name_list_count);
+  const auto *deformerRecs = view.section<Lite2dDeformerRecord>(hdr->deformer_offset, hdr->deformer_count);
+  const auto *tagRecs = view.section<Lite2dTagRecord>(hdr->tag_offset, hdr->tag_count);
+  const auto *texRecs = view.section<Lite2dTextureRecord>(hdr->texture_offset, hdr->texture_count);
+  const auto *paramRecs = view.section<Lite2dParamRecord>(hdr->param_offset, hdr->param_count);
+  const auto *keyformAxisRecs =
+      view.section<Lite2dKeyformAxisRecord>(hdr->keyform_axis_offset, hdr->keyform_axis_count);
+  const auto *keyformKeys = view.section<float>(hdr->keyform_key_offset, hdr->keyform_key_count);
+  const auto *keyformRecs = view.section<Lite2dKeyformRecord>(hdr->keyform_offset, hdr->keyform_count);
+  const auto *keyformCoords = view.section<uint32_t>(hdr->keyform_coord_offset, hdr->keyform_coord_count);
+  const auto *keyformBlocks = view.section<uint32_t>(hdr->keyform_block_offset, hdr->keyform_block_count);
+  const auto *keyformDeltas =
+      view.section<float>(hdr->keyform_delta_offset, uint64_t(hdr->keyform_block_count) * 2 * kSkinDeltaBlock);
+  if (!meshRecs || !positions || !uvs || !indices || !skins || !nameLists
+      || !deformerRecs || !tagRecs || !texRecs || !paramRecs || !keyformAxisRecs || !keyformKeys || !keyformRecs
+      || !keyformCoords || !keyformBlocks || !keyformDeltas)
+  {
+    std::cerr << "Corrupt section table in compiled model: " << binPath << "\n";
+    return false;
+  }
+  if (!view.bindStrings(*hdr))
+  {
+    std::cerr << "Corrupt string table in compiled model: " << binPath << "\n";
+    return false;
+  }
+
+  Model &model = eng.model;
+  drawableTextures.clear();
+  model.meshes.clear();
+  model.deformers.clear();
+  model.mesh_face_parts.clear();
+  model.mesh_body_parts.clear();
+  model.mesh_seam_parts.clear();
+  model.params.clear();
+
+  for (uint32_t i = 0; i < hdr->param_count; ++i)
+  {
+    const auto &rec = paramRecs[i];
+    if (view.validString(rec.id))
+      model.params.add(view.str(rec.id), rec.min, rec.max, rec.def);
+  }
+
+  for (uint32_t i = 0; i < hdr->deformer_count; ++i)
+  {
+    const auto &rec = deformerRecs[i];
+    Deformer d;
+    d.id = view.str(rec.id);
+    if (rec.parent != kLite2dNoString)
+      d.parent = view.str(rec.parent);
+    d.pos = {rec.pos[0], rec.pos[1]};
+    d.rot_deg = rec.rot_deg;
+    d.scale = {rec.scale[0], rec.scale[1]};
+    model.deformers.emplace(d.id, std::move(d));
+  }
+  for (auto &kv : model.deformers)
+  {
+    if (kv.second.parent.empty())
+      continue;
+    auto itParent = model.deformers.find(kv.second.parent);
+    if (itParent != model.deformers.end())
+      itParent->second.children.push_back(kv.first);
+  }
+
+  model.meshes.reserve(hdr->mesh_count);
+  for (uint32_t i = 0; i < hdr->mesh_count; ++i)
+  {
+    const auto &rec = meshRecs[i];
+    const bool rigid = (rec.flags & kLite2dMeshRigidSkin) != 0;
+    if (uint64_t(rec.vertex_first) + rec.vertex_count > hdr->vertex_count
+        || uint64_t(rec.index_first) + rec.index_count > hdr->index_count
+        || uint64_t(rec.deformer_first) + rec.deformer_count > hdr->name_list_count
+        || (!rigid && uint64_t(rec.skin_first) + rec.vertex_count > hdr->skin_count)
+        || uint64_t(rec.keyform_axis_first) + rec.keyform_axis_count > hdr->keyform_axis_count
+        || uint64_t(rec.keyform_first) + rec.keyform_count > hdr->keyform_count
+        || !view.validString(rec.id))
+    {
+      std::cerr << "Corrupt mesh record " << i << " in compiled model: " << binPath << "\n";
+      return false;
+    }
+
+    ArtMesh mesh;
+    mesh.id = view.str(rec.id);
+    mesh.texture_id = view.str(rec.texture_id);
+    if (rec.clipping_mask_id != kLite2dNoString)
+      mesh.clipping_mask_id = view.str(rec.clipping_mask_id);
+    mesh.draw_order = rec.draw_order;
+    mesh.blend_mode = rec.blend_mode;
+    mesh.opacity = rec.opacity;
+    mesh.visible = (rec.flags & kLite2dMeshVisible) != 0;
+
+    const glm::vec3 color{rec.color[0], rec.color[1], rec.color[2]};
+    mesh.verts.resize(rec.vertex_count);
+    for (uint32_t v = 0; v < rec.vertex_count; ++v)
+    {
+      Vertex &vtx = mesh.verts[v];
+      const size_t q = (size_t(rec.vertex_first) + v) * 2;
+      vtx.pos = {dequantizeUnorm16(positions[q], rec.pos_origin[0], rec.pos_extent[0]),
+                 dequantizeUnorm16(positions[q + 1], rec.pos_origin[1], rec.pos_extent[1])};
+      vtx.uv = {dequantizeUnorm16(uvs[q], rec.uv_origin[0], rec.uv_extent[0]),
+                dequantizeUnorm16(uvs[q + 1], rec.uv_origin[1], rec.uv_extent[1])};
+      vtx.color = color;
+      if (rigid)
+      {
+        vtx.bone = {0, 0};
+        vtx.weight = {1.0f, 0.0f};
+      }
+      else
+      {
+        const auto &s = skins[rec.skin_first + v];
+        vtx.bone = {s.bone[0], s.bone[1]};
+        vtx.weight = {s.weight[0], s.weight[1]};
+      }
+    }
+
+    mesh.indices.assign(indices + rec.index_first, indices + rec.index_first + rec.index_count);
+    for (uint32_t idx : mesh.indices)
+    {
+      if (idx >= rec.vertex_count)
+      {
+        std::cerr << "Index out of range in mesh " << mesh.id << " of " << binPath << "\n";
+        return false;
+      }
+    }
+
+    mesh.deformers.reserve(rec.deformer_count);
+    for (uint32_t d = 0; d < rec.deformer_count; ++d)
+    {
+      mesh.deformers.push_back(view.str(nameLists[rec.deformer_first + d]));
+      auto itDef = model.deformers.find(mesh.deformers.back());
+      if (itDef != model.deformers.end())
+        itDef->second.bound_meshes.push_back(mesh.id);
+    }
+    buildSkinStreams(mesh);
+
+    if (!readKeyforms(view, *hdr, rec, keyformAxisRecs, keyformKeys, keyformRecs, keyformCoords, keyformBlocks,
+                      keyformDeltas, mesh.keyforms))
+    {
+      std::cerr << "Corrupt keyforms in mesh " << mesh.id << " of " << binPath << "\n";
+      return false;
+    }
+
+    model.meshes.emplace(mesh.id, std::move(mesh));
+  }
+
+  for (uint32_t i = 0; i < hdr->tag_count; ++i)
+  {
+    const auto &rec = tagRecs[i];
+    std::string meshId = view.str(rec.mesh_id);
+    std::string tag = view.str(rec.tag);
+    switch (static_cast<Lite2dTagKind>(rec.kind))
+    {
+    case Lite2dTagKind::Face:
+      model.mesh_face_parts[meshId].insert(std::move(tag));
+      break;
+    case Lite2dTagKind::Body:
+      model.mesh_body_parts[meshId].insert(std::move(tag));
+      break;
+    case Lite2dTagKind::Seam:
+      model.mesh_seam_parts[meshId].insert(std::move(tag));
+      break;
+    }
+  }
+  classifyMeshRegions(model);
+  model.buildDeformerTree();
+
+  const std::filesystem::path baseDir = binPath.parent_path();
+  for (uint32_t i = 0; i < hdr->texture_count; ++i)
+  {
+    std::filesystem::path p = view.str(texRecs[i].path);
+    if (p.is_relative())
+      p = baseDir / p;
+    drawableTextures.try_emplace(view.str(texRecs[i].texture_id), p);
+  }
+
+  eng.canvas = {hdr->canvas_w, hdr->canvas_h};
+
+  if (model.meshes.empty())
+  {
+    std::cerr << "No meshes found in " << binPath << "\n";
+    return false;
+  }
+
+  std::cerr << "Loaded " << model.meshes.size() << " meshes from compiled model " << binPath << "\n";
+  return true;
+}
@@ -0,0 +1,202 @@
+#ifndef __LITE2D_MODEL_BINARY_H__
+#pragma once
+#define __LITE2D_MODEL_BINARY_H__
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+class Engine;
+struct Model;
+
+// ---------- Compiled binary model (.lite2d) ----------
+//
+// Layout (little-endian, every section 8-byte aligned, offsets from file start):
+//   Lite2dHeader
+//   string table   : uint32 offsets[string_count + 1], then the UTF-8 blob
+//   mesh table     : Lite2dMeshRecord[mesh_count]
+//   position block : uint16[2][total vertices], unorm relative to the mesh's pos_origin/pos_extent
+//   uv block       : uint16[2][total vertices], unorm relative to the mesh's uv_origin/uv_extent
+//   index block    : uint32[total indices], relative to the mesh's first vertex
+//   skin block     : Lite2dSkinRecord[] for meshes without kLite2dMeshRigidSkin
+//   name lists     : uint32 string indices (mesh deformer lists)
+//   deformer table : Lite2dDeformerRecord[deformer_count]
+//   tag table      : Lite2dTagRecord[tag_count] (face/body/seam part tags)
+//   texture table  : Lite2dTextureRecord[texture_count]
+//   param table    : Lite2dParamRecord[param_count], in handle order
+//   keyform axes   : Lite2dKeyformAxisRecord[keyform_axis_count]
+//   keyform keys   : float[keyform_key_count], key values of the axes
+//   keyform table  : Lite2dKeyformRecord[keyform_count]
+//   keyform coords : uint32[keyform_coord_count], key index per axis of each keyform
+//   keyform blocks : uint32[keyform_block_count], vertex block of each stored offset block
+//   keyform deltas : float[keyform_block_count][2][kSkinDeltaBlock], x offsets then y offsets
+//
+// Render-settings and parts sidecars are baked in: draw order and visibility are
+// stored on each mesh record and part tags are stored in the tag table. The header records
+// which sidecar files were used.
+//
+// Positions (already centered) and UVs (already V-flipped) use the 16-bit fixed-point encoding
+// from vertex_quant.h, which keeps sub-pixel precision relative to each mesh's own bounds.
+
+constexpr char kLite2dMagic[8] = {'L', 'I', 'T', 'E', '2', 'D', 'M', '\0'};
+constexpr uint32_t kLite2dVersion = 5;
+constexpr uint32_t kLite2dEndianTag = 0x01020304u;
+constexpr uint32_t kLite2dNoString = 0xFFFFFFFFu;
+
+enum Lite2dMeshFlags : uint32_t
+{
+  kLite2dMeshVisible = 1u << 0,
+  kLite2dMeshRigidSkin = 1u << 1, // every vertex is bone 0 with weight 1
+};
+
+enum class Lite2dTagKind : uint32_t
+{
+  Face = 0,
+  Body = 1,
+  Seam = 2,
+};
+
+struct Lite2dHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t endian_tag;
+  uint64_t file_size;
+  float canvas_w, canvas_h;
+  uint32_t string_count;
+  uint32_t mesh_count;
+  uint32_t vertex_count;
+  uint32_t index_count;
+  uint32_t skin_count;
+  uint32_t name_list_count;
+  uint32_t deformer_count;
+  uint32_t tag_count;
+  uint32_t texture_count;
+  uint32_t param_count;
+  uint32_t keyform_axis_count;
+  uint32_t keyform_key_count;
+  uint32_t keyform_count;
+  uint32_t keyform_coord_count;
+  uint32_t keyform_block_count;
+  uint32_t render_settings_path; // sidecars baked in, as absolute normalized paths
+  uint32_t parts_path;
+  uint32_t reserved;
+  uint64_t string_table_offset;
+  uint64_t mesh_table_offset;
+  uint64_t position_offset;
+  uint64_t uv_offset;
+  uint64_t index_offset;
+  uint64_t skin_offset;
+  uint64_t name_list_offset;
+  uint64_t deformer_offset;
+  uint64_t tag_offset;
+  uint64_t texture_offset;
+  uint64_t param_offset;
+  uint64_t keyform_axis_offset;
+  uint64_t keyform_key_offset;
+  uint64_t keyform_offset;
+  uint64_t keyform_coord_offset;
+  uint64_t keyform_block_offset;
+  uint64_t keyform_delta_offset;
+};
+
+struct Lite2dMeshRecord
+{
+  uint32_t id;
+  uint32_t texture_id;
+  uint32_t clipping_mask_id; // kLite2dNoString if none
+  uint32_t flags;
+  int32_t draw_order;
+  int32_t blend_mode;
+  float opacity;
+  float color[3];
+  uint32_t vertex_first, vertex_count;
+  uint32_t index_first, index_count;
+  uint32_t skin_first;     // into the skin block, unused for rigid meshes
+  uint32_t deformer_first; // into the name lists
+  uint32_t deformer_count;
+  uint32_t keyform_axis_first, keyform_axis_count;
+  uint32_t keyform_first, keyform_count;
+  float pos_origin[2], pos_extent[2];
+  float uv_origin[2], uv_extent[2];
+};
+
+struct Lite2dSkinRecord
+{
+  int32_t bone[2];
+  float weight[2];
+};
+
+struct Lite2dDeformerRecord
+{
+  uint32_t id;
+  uint32_t parent; // kLite2dNoString for roots
+  float pos[2];
+  float rot_deg;
+  float scale[2];
+  uint32_t reserved;
+};
+
+struct Lite2dTagRecord
+{
+  uint32_t mesh_id;
+  uint32_t tag;
+  uint32_t kind; // Lite2dTagKind
+};
+
+struct Lite2dTextureRecord
+{
+  uint32_t texture_id;
+  uint32_t path; // relative to the directory holding the .lite2d file
+};
+
+struct Lite2dParamRecord
+{
+  uint32_t id;
+  float min, max, def;
+};
+
+struct Lite2dKeyformAxisRecord
+{
+  uint32_t param;
+  uint32_t key_first; // into the keyform keys
+  uint32_t key_count;
+  uint32_t reserved;
+};
+
+struct Lite2dKeyformRecord
+{
+  uint32_t coord_first; // into the keyform coords, one per axis of the mesh
+  uint32_t block_first; // into the keyform blocks and deltas
+  uint32_t block_count;
+  uint32_t reserved;
+};
+
+// Returns the compiled model path next to a .moc3.json (foo.moc3.json -> foo.lite2d).
+std::filesystem::path getCompiledModelPath(const std::filesystem::path &moc3JsonPath);
+
+// True if compiledPath exists, is not older than the .moc3.json or any of its sidecars, and was
+// compiled from the same sidecars (empty paths mean the default siblings).
+bool isCompiledModelFresh(const std::filesystem::path &compiledPath,
+                          const std::filesystem::path &moc3JsonPath,
+                          const std::filesystem::path &renderSettingsPath = {},
+                          const std::filesystem::path &partsPath = {});
+
+// Writes a loaded model (parameters, meshes, deformers, baked sidecar data and texture paths) as a .lite2d file.
+// renderSettingsPath and partsPath are the sidecars the model was loaded with (resolved, not empty).
+bool writeModelBinary(const std::filesystem::path &outPath,
+                      const Model &model,
+                      const glm::vec2 &canvas,
+                      const std::unordered_map<std::string, std::filesystem::path> &drawableTextures,
+                      const std::filesystem::path &renderSettingsPath,
+                      const std::filesystem::path &partsPath);
+
+// Maps a .lite2d file and builds the Engine model from it without any text parsing.
+bool loadModelFromLite2d(const std::filesystem::path &binPath,
+                         Engine &eng,
+                         std::unordered_map<std::string, std::filesystem::path> &drawableTextures);
+
+#endif  // __LITE2D_MODEL_BINARY_H__
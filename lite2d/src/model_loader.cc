@@ -3,218 +3,742 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <string_view>
+#include <thread>
 #include <unordered_set>
 
 #include <glm/glm.hpp>
 #include "commons/json.hpp"
 
+#include "asset_index.h"
 #include "deformer.h"
 #include "engine.h"
+#include "job_system.h"
+#include "keyforms.h"
+#include "load_profile.h"
+#include "mapped_file.h"
+#include "mesh_optimize.h"
+#include "mesh_regions.h"
 #include "model.h"
+#include "sidecar_manifest.h"
+#include "skinning.h"
 #include "texture.h"
 
 using json = nlohmann::json;
 
 namespace
 {
-struct RenderSettings
+std::string readTexturePathFromJson(const std::string &jsonFile)
 {
-  std::vector<std::string> order;
-  std::unordered_set<std::string> hidden;
+  std::ifstream ifs(jsonFile);
+  if (!ifs)
+  {
+    std::cerr << "Cannot open atlas json: " << jsonFile << "\n";
+    return "";
+  }
+  try
+  {
+    nlohmann::json j;
+    ifs >> j;
+    if (j.contains("texture") && j["texture"].is_string())
+      return j["texture"].get<std::string>();
+    std::cerr << "No \"texture\" string field in " << jsonFile << "\n";
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to parse json " << jsonFile << ": " << e.what() << "\n";
+  }
+  return "";
+}
+/**
+ * A drawable as parsed from .moc3.json, before ids, draw order and visibility are resolved.
+ * Positions are still in model space; re-centering happens once the global bbox is known.
+ * @param mesh The mesh built so far (verts, indices, blend mode, opacity, id if present).
+ * @param textureIndex The texture_index field.
+ * @param hasId Whether the drawable carried its own id.
+ * @param usable Whether it had positions and indices arrays with at least one position entry.
+ * @param droppedKeyforms Keyforms left out because they did not fit the mesh or its keyform axes.
+ */
+struct ParsedDrawable
+{
+  ArtMesh mesh;
+  int textureIndex = 0;
+  bool hasId = false;
+  bool usable = false;
+  size_t droppedKeyforms = 0;
 };
 
-struct FacePartsSettings
+/**
+ * A keyform as it appears in a drawable's "keyforms" object. Vertices are source position indices
+ * until the drawable is finished.
+ */
+struct ParsedKeyform
 {
-  std::unordered_map<std::string, std::vector<std::string>> parts;
+  std::vector<uint32_t> key;
+  std::vector<uint32_t> vertices;
+  std::vector<glm::vec2> offsets;
 };
 
-struct BodyPartsSettings
+/**
+ * A parameter from the top-level "parameters" array, with the fallbacks used when a field is absent.
+ */
+struct ParsedParameter
 {
-  std::unordered_map<std::string, std::vector<std::string>> parts;
-  std::unordered_map<std::string, std::vector<std::string>> seams;
+  std::string id;
+  float min = -1.0f, max = 1.0f, def = 0.0f;
 };
 
-bool endsWith(const std::string &value, const std::string &suffix)
+/**
+ * Streaming SAX handler for .moc3.json.
+ * Positions, UVs and indices are written straight into the ArtMesh being built and the bbox is
+ * tracked as positions arrive, so no DOM is ever materialized. Each drawable is self-contained, so
+ * a handler can equally consume a whole document or one drawable object at a time.
+ * A drawable may carry keyforms (see keyforms.h):
+ *   "keyforms": {
+ *     "parameters": [{"id": "ParamMouthOpenY", "keys": [0, 1]}, ...],
+ *     "forms": [{"keys": [1, ...], "vertices": [3, 4], "offsets": [[0, -0.02], [0, -0.03]]}, ...]
+ *   }
+ * where a form's "keys" holds one key index per parameter, "vertices" indexes "positions", and
+ * "offsets" holds one offset per entry of "vertices". Malformed offsets and vertices are ignored.
+ * @param drawables Parsed drawables, in document order.
+ * @param parameters Parsed parameters, in document order.
+ * @param bbMin Minimum corner of all valid positions.
+ * @param bbMax Maximum corner of all valid positions.
+ * @param totalVerts Number of valid positions across all drawables.
+ * @param canvasW The declared canvas width (2 if absent).
+ * @param canvasH The declared canvas height (2 if absent).
+ * @param sawDrawables Whether a top-level "drawables" array was found.
+ * @param error Parse error message, if any.
+ */
+class Moc3SaxHandler
 {
-  if (suffix.size() > value.size())
+public:
+  using number_integer_t = json::number_integer_t;
+  using number_unsigned_t = json::number_unsigned_t;
+  using number_float_t = json::number_float_t;
+  using string_t = json::string_t;
+  using binary_t = json::binary_t;
+
+  std::vector<ParsedDrawable> drawables;
+  std::vector<ParsedParameter> parameters;
+  glm::vec2 bbMin{1e9f}, bbMax{-1e9f};
+  size_t totalVerts = 0;
+  float canvasW = 2.0f, canvasH = 2.0f;
+  bool sawDrawables = false;
+  std::string error;
+
+  // Prepare to parse a single drawable object rather than a whole document.
+  void beginDrawableSpan()
+  {
+    stack_.clear();
+    stack_.push_back(Ctx::Drawables);
+  }
+
+  bool null() { return value(Scalar{}); }
+  bool boolean(bool) { return value(Scalar{}); }
+  bool number_integer(number_integer_t v) { return value(Scalar{true, static_cast<double>(v)}); }
+  bool number_unsigned(number_unsigned_t v) { return value(Scalar{true, static_cast<double>(v)}); }
+  bool number_float(number_float_t v, const string_t &) { return value(Scalar{true, v}); }
+  bool binary(binary_t &) { return value(Scalar{}); }
+
+  bool string(string_t &v)
+  {
+    if (!stack_.empty() && top() == Ctx::Drawable && key_ == "id")
+    {
+      cur().mesh.id = std::move(v);
+      cur().hasId = true;
+    }
+    else if (!stack_.empty() && top() == Ctx::Parameter && key_ == "id")
+    {
+      parameters.back().id = std::move(v);
+    }
+    else if (!stack_.empty() && top() == Ctx::KeyformAxis && key_ == "id")
+    {
+      cur().mesh.keyforms.axes.back().param_id = std::move(v);
+    }
+    return value(Scalar{});
+  }
+
+  bool key(string_t &k)
+  {
+    if (top() != Ctx::Skip)
+      key_ = std::move(k);
+    return true;
+  }
+
+  bool start_object(size_t)
+  {
+    const Ctx parent = stack_.empty() ? Ctx::None : top();
+    Ctx next = Ctx::Skip;
+    if (parent == Ctx::None)
+      next = Ctx::Root;
+    else if (parent == Ctx::Root && key_ == "canvas")
+      next = Ctx::Canvas;
+    else if (parent == Ctx::Drawables)
+      next = Ctx::Drawable;
+    else if (parent == Ctx::Parameters)
+      next = Ctx::Parameter;
+    else if (parent == Ctx::Drawable && key_ == "keyforms")
+      next = Ctx::Keyforms;
+    else if (parent == Ctx::KeyformAxes)
+      next = Ctx::KeyformAxis;
+    else if (parent == Ctx::KeyformForms)
+      next = Ctx::KeyformForm;
+    else
+      entryInvalid(parent);
+    if (next == Ctx::Drawable)
+      beginDrawable();
+    else if (next == Ctx::Parameter)
+      parameters.emplace_back();
+    else if (next == Ctx::KeyformAxis)
+      cur().mesh.keyforms.axes.emplace_back();
+    else if (next == Ctx::KeyformForm)
+      beginKeyform();
+    stack_.push_back(next);
+    return true;
+  }
+
+  bool end_object()
+  {
+    const Ctx ctx = pop();
+    if (ctx == Ctx::Drawable)
+      finishDrawable();
+    return true;
+  }
+
+  bool start_array(size_t)
+  {
+    const Ctx parent = stack_.empty() ? Ctx::None : top();
+    Ctx next = Ctx::Skip;
+    if (parent == Ctx::Root && key_ == "drawables")
+    {
+      next = Ctx::Drawables;
+      sawDrawables = true;
+    }
+    else if (parent == Ctx::Root && key_ == "parameters")
+    {
+      next = Ctx::Parameters;
+    }
+    else if (parent == Ctx::Drawable && key_ == "positions")
+    {
+      next = Ctx::Positions;
+      hasPositions_ = true;
+    }
+    else if (parent == Ctx::Drawable && key_ == "uvs")
+    {
+      next = Ctx::Uvs;
+    }
+    else if (parent == Ctx::Drawable && key_ == "indices")
+    {
+      next = Ctx::Indices;
+      hasIndices_ = true;
+    }
+    else if (parent == Ctx::Keyforms && key_ == "parameters")
+    {
+      next = Ctx::KeyformAxes;
+    }
+    else if (parent == Ctx::Keyforms && key_ == "forms")
+    {
+      next = Ctx::KeyformForms;
+    }
+    else if (parent == Ctx::KeyformAxis && key_ == "keys")
+    {
+      next = Ctx::KeyformAxisKeys;
+    }
+    else if (parent == Ctx::KeyformForm && key_ == "keys")
+    {
+      next = Ctx::KeyformFormKeys;
+    }
+    else if (parent == Ctx::KeyformForm && key_ == "vertices")
+    {
+      next = Ctx::KeyformVertices;
+    }
+    else if (parent == Ctx::KeyformForm && key_ == "offsets")
+    {
+      next = Ctx::KeyformOffsets;
+    }
+    else if (parent == Ctx::Positions || parent == Ctx::Uvs || parent == Ctx::KeyformOffsets)
+    {
+      next = parent == Ctx::Positions ? Ctx::Point : parent == Ctx::Uvs ? Ctx::UvPoint : Ctx::OffsetPoint;
+      pointCount_ = 0;
+      pointValid_ = true;
+    }
+    else
+    {
+      entryInvalid(parent);
+    }
+    stack_.push_back(next);
+    return true;
+  }
+
+  bool end_array()
+  {
+    const Ctx ctx = pop();
+    if (ctx == Ctx::Point)
+      finishPosition();
+    else if (ctx == Ctx::UvPoint)
+      finishUv();
+    else if (ctx == Ctx::OffsetPoint)
+      finishOffset();
+    else if (ctx == Ctx::Positions)
+      positionsDone_ = true;
+    return true;
+  }
+
+  bool parse_error(size_t, const std::string &, const nlohmann::detail::exception &ex)
+  {
+    error = ex.what();
     return false;
-  return std::equal(suffix.rbegin(), suffix.rend(), value.rbegin());
-}
+  }
 
-std::filesystem::path getRenderSettingsPath(const std::filesystem::path &moc3JsonPath)
-{
-  const std::string suffix = ".moc3.json";
-  const std::string pathStr = moc3JsonPath.string();
-  if (endsWith(pathStr, suffix))
-    return std::filesystem::path(pathStr.substr(0, pathStr.size() - suffix.size()) + ".moc3.render-settings.json");
-  return std::filesystem::path(pathStr + ".moc3.render-settings.json");
-}
+private:
+  enum class Ctx
+  {
+    None,
+    Root,
+    Canvas,
+    Parameters,
+    Parameter,
+    Drawables,
+    Drawable,
+    Positions,
+    Point,
+    Uvs,
+    UvPoint,
+    Indices,
+    Keyforms,
+    KeyformAxes,
+    KeyformAxis,
+    KeyformAxisKeys,
+    KeyformForms,
+    KeyformForm,
+    KeyformFormKeys,
+    KeyformVertices,
+    KeyformOffsets,
+    OffsetPoint,
+    Skip,
+  };
 
-std::filesystem::path getPartsPath(const std::filesystem::path &moc3JsonPath)
-{
-  const std::string suffix = ".moc3.json";
-  const std::string pathStr = moc3JsonPath.string();
-  if (endsWith(pathStr, suffix))
-    return std::filesystem::path(pathStr.substr(0, pathStr.size() - suffix.size()) + ".moc3.parts.json");
-  return std::filesystem::path(pathStr + ".moc3.parts.json");
-}
+  struct Scalar
+  {
+    bool isNumber = false;
+    double v = 0.0;
+  };
 
-RenderSettings loadRenderSettings(const std::filesystem::path &moc3JsonPath,
-                                  const std::filesystem::path &explicitPath)
-{
-  RenderSettings settings;
-  const auto settingsPath = explicitPath.empty() ? getRenderSettingsPath(moc3JsonPath)
-                                                 : explicitPath;
-  std::ifstream ifs(settingsPath);
-  if (!ifs)
-    return settings;
-  try
+  std::vector<Ctx> stack_;
+  std::string key_;
+
+  // Per-drawable state, reused across drawables so steady-state parsing does not allocate.
+  bool hasPositions_ = false, hasIndices_ = false, positionsDone_ = false;
+  size_t srcPositions_ = 0, srcUvs_ = 0;
+  std::vector<int32_t> vertOfSrc_;   // source position index -> vertex, -1 if the entry was invalid
+  std::vector<glm::vec2> uvScratch_; // only used when uvs precede positions
+  std::vector<char> uvValid_;
+  float point_[2] = {0.0f, 0.0f};
+  int pointCount_ = 0;
+  bool pointValid_ = true;
+  std::vector<ParsedKeyform> keyforms_; // the first keyformCount_ belong to this drawable
+  size_t keyformCount_ = 0;
+
+  Ctx top() const { return stack_.back(); }
+  ParsedDrawable &cur() { return drawables.back(); }
+  ParsedKeyform &curKeyform() { return keyforms_[keyformCount_ - 1]; }
+
+  static uint32_t toIndex(const Scalar &s)
   {
-    nlohmann::json j;
-    ifs >> j;
-    if (j.contains("order") && j["order"].is_array())
+    return s.isNumber && s.v >= 0.0 && s.v < 4294967295.0 ? static_cast<uint32_t>(s.v) : UINT32_MAX;
+  }
+
+  Ctx pop()
+  {
+    Ctx ctx = stack_.back();
+    stack_.pop_back();
+    return ctx;
+  }
+
+  // A positions/uvs entry that is not a 2-number array is dropped, as the DOM loader did.
+  void entryInvalid(Ctx parent)
+  {
+    if (parent == Ctx::Positions)
+      vertOfSrc_.push_back(-1), ++srcPositions_;
+    else if (parent == Ctx::Uvs)
+      storeUv(srcUvs_++, nullptr);
+    else if (parent == Ctx::KeyformOffsets)
+      curKeyform().offsets.emplace_back(0.0f);
+    else if (parent == Ctx::KeyformVertices)
+      curKeyform().vertices.push_back(UINT32_MAX);
+    else if (parent == Ctx::KeyformFormKeys)
+      curKeyform().key.push_back(UINT32_MAX);
+    else if (parent == Ctx::Point || parent == Ctx::UvPoint || parent == Ctx::OffsetPoint)
+      pointValid_ = false;
+  }
+
+  bool value(const Scalar &s)
+  {
+    if (stack_.empty())
+      return true;
+    switch (top())
     {
-      for (const auto &id : j["order"])
-      {
-        if (id.is_string())
-          settings.order.push_back(id.get<std::string>());
-      }
+    case Ctx::Canvas:
+      if (s.isNumber && key_ == "width")
+        canvasW = static_cast<float>(s.v);
+      else if (s.isNumber && key_ == "height")
+        canvasH = static_cast<float>(s.v);
+      break;
+    case Ctx::Parameter:
+      if (!s.isNumber)
+        break;
+      if (key_ == "minimum")
+        parameters.back().min = static_cast<float>(s.v);
+      else if (key_ == "maximum")
+        parameters.back().max = static_cast<float>(s.v);
+      else if (key_ == "default")
+        parameters.back().def = static_cast<float>(s.v);
+      break;
+    case Ctx::Drawable:
+      if (!s.isNumber)
+        break;
+      if (key_ == "texture_index")
+        cur().textureIndex = static_cast<int>(s.v);
+      else if (key_ == "blend_mode")
+        cur().mesh.blend_mode = static_cast<int>(s.v);
+      else if (key_ == "opacity")
+        cur().mesh.opacity = static_cast<float>(s.v);
+      else if (key_ == "vertex_count" && s.v > 0 && cur().mesh.verts.empty())
+        cur().mesh.verts.reserve(static_cast<size_t>(s.v));
+      else if (key_ == "index_count" && s.v > 0 && cur().mesh.indices.empty())
+        cur().mesh.indices.reserve(static_cast<size_t>(s.v));
+      break;
+    case Ctx::KeyformAxisKeys:
+      if (s.isNumber)
+        cur().mesh.keyforms.axes.back().keys.push_back(static_cast<float>(s.v));
+      break;
+    case Ctx::KeyformFormKeys:
+      curKeyform().key.push_back(toIndex(s));
+      break;
+    case Ctx::KeyformVertices:
+      curKeyform().vertices.push_back(toIndex(s));
+      break;
+    case Ctx::KeyformOffsets:
+      entryInvalid(Ctx::KeyformOffsets);
+      break;
+    case Ctx::Point:
+    case Ctx::UvPoint:
+    case Ctx::OffsetPoint:
+      if (!s.isNumber)
+        pointValid_ = false;
+      else if (pointCount_ < 2)
+        point_[pointCount_] = static_cast<float>(s.v);
+      ++pointCount_;
+      break;
+    case Ctx::Indices:
+      // Out-of-range values are filtered once the vertex count is final.
+      if (s.isNumber)
+        cur().mesh.indices.push_back(toIndex(s));
+      break;
+    case Ctx::Positions:
+      entryInvalid(Ctx::Positions);
+      break;
+    case Ctx::Uvs:
+      entryInvalid(Ctx::Uvs);
+      break;
+    default:
+      break;
     }
-    if (j.contains("hidden") && j["hidden"].is_array())
+    return true;
+  }
+
+  void beginDrawable()
+  {
+    drawables.emplace_back();
+    hasPositions_ = hasIndices_ = positionsDone_ = false;
+    srcPositions_ = srcUvs_ = 0;
+    vertOfSrc_.clear();
+    uvScratch_.clear();
+    uvValid_.clear();
+    keyformCount_ = 0;
+  }
+
+  void beginKeyform()
+  {
+    if (keyformCount_ == keyforms_.size())
+      keyforms_.emplace_back();
+    ParsedKeyform &k = keyforms_[keyformCount_++];
+    k.key.clear();
+    k.vertices.clear();
+    k.offsets.clear();
+  }
+
+  void finishOffset()
+  {
+    const bool ok = pointValid_ && pointCount_ >= 2;
+    curKeyform().offsets.push_back(ok ? glm::vec2(point_[0], point_[1]) : glm::vec2(0.0f));
+  }
+
+  void finishPosition()
+  {
+    ++srcPositions_;
+    if (!pointValid_ || pointCount_ < 2)
     {
-      for (const auto &id : j["hidden"])
-      {
-        if (id.is_string())
-          settings.hidden.insert(id.get<std::string>());
-      }
+      vertOfSrc_.push_back(-1);
+      return;
     }
+    const float px = point_[0];
+    const float py = point_[1];
+    bbMin.x = std::min(bbMin.x, px);
+    bbMin.y = std::min(bbMin.y, py);
+    bbMax.x = std::max(bbMax.x, px);
+    bbMax.y = std::max(bbMax.y, py);
+    ++totalVerts;
+
+    auto &verts = cur().mesh.verts;
+    vertOfSrc_.push_back(static_cast<int32_t>(verts.size()));
+    Vertex vtx;
+    vtx.pos = {px, py};
+    vtx.uv = {0.0f, 1.0f};
+    vtx.color = {1.0f, 1.0f, 1.0f};
+    vtx.bone = {0, 0};
+    vtx.weight = {1.0f, 0.0f};
+    verts.push_back(vtx);
   }
-  catch (const std::exception &e)
+
+  void finishUv()
   {
-    std::cerr << "Failed to parse render settings: " << e.what() << "\n";
+    const bool ok = pointValid_ && pointCount_ >= 2;
+    storeUv(srcUvs_++, ok ? point_ : nullptr);
   }
-  return settings;
-}
 
-FacePartsSettings loadFacePartsSettings(const std::filesystem::path &moc3JsonPath,
-                                        const std::filesystem::path &explicitPath)
-{
-  FacePartsSettings settings;
-  const auto settingsPath = explicitPath.empty() ? getPartsPath(moc3JsonPath)
-                                                 : explicitPath;
-  std::ifstream ifs(settingsPath);
-  if (!ifs)
-    return settings;
-  try
+  void storeUv(size_t src, const float *uv)
   {
-    nlohmann::json j;
-    ifs >> j;
-    if (j.contains("face_parts") && j["face_parts"].is_object())
+    if (positionsDone_)
     {
-      const auto &partsObj = j["face_parts"];
-      for (auto it = partsObj.begin(); it != partsObj.end(); ++it)
-      {
-        if (!it.value().is_array())
-          continue;
-        std::vector<std::string> ids;
-        for (const auto &id : it.value())
-        {
-          if (id.is_string())
-            ids.push_back(id.get<std::string>());
-        }
-        if (!ids.empty())
-          settings.parts[it.key()] = std::move(ids);
-      }
+      // Common case (converter output): positions came first, write in place.
+      if (uv && src < vertOfSrc_.size() && vertOfSrc_[src] >= 0)
+        cur().mesh.verts[vertOfSrc_[src]].uv = {uv[0], 1.0f - uv[1]};
+      return;
     }
+    uvScratch_.push_back(uv ? glm::vec2(uv[0], uv[1]) : glm::vec2(0.0f));
+    uvValid_.push_back(uv ? 1 : 0);
   }
-  catch (const std::exception &e)
+
+  void finishDrawable()
   {
-    std::cerr << "Failed to parse face parts settings: " << e.what() << "\n";
+    ParsedDrawable &d = cur();
+    d.usable = hasPositions_ && hasIndices_ && srcPositions_ > 0;
+    if (!d.usable)
+    {
+      d.mesh.verts = {};
+      d.mesh.indices = {};
+      d.mesh.keyforms = {};
+      return;
+    }
+
+    ArtMesh &mesh = d.mesh;
+    for (size_t src = 0; src < uvScratch_.size() && src < vertOfSrc_.size(); ++src)
+    {
+      if (uvValid_[src] && vertOfSrc_[src] >= 0)
+        mesh.verts[vertOfSrc_[src]].uv = {uvScratch_[src].x, 1.0f - uvScratch_[src].y};
+    }
+
+    const uint32_t vcount = static_cast<uint32_t>(mesh.verts.size());
+    mesh.indices.erase(std::remove_if(mesh.indices.begin(), mesh.indices.end(),
+                                      [vcount](uint32_t iv)
+                                      { return iv >= vcount; }),
+                       mesh.indices.end());
+
+    for (size_t f = 0; f < keyformCount_; ++f)
+    {
+      ParsedKeyform &k = keyforms_[f];
+      for (uint32_t &v : k.vertices)
+        v = v < vertOfSrc_.size() && vertOfSrc_[v] >= 0 ? static_cast<uint32_t>(vertOfSrc_[v]) : UINT32_MAX;
+      mesh.keyforms.forms.push_back(makeKeyform(k.key, k.vertices, k.offsets, vcount));
+    }
+    d.droppedKeyforms = dropInvalidKeyforms(mesh.keyforms, vcount);
   }
-  return settings;
-}
+};
 
-BodyPartsSettings loadBodyPartsSettings(const std::filesystem::path &moc3JsonPath,
-                                        const std::filesystem::path &explicitPath)
+/**
+ * Locates the top-level "drawables" array of a .moc3.json text and the byte span of each object
+ * in it, without parsing any values. Strings are skipped with escape handling so brackets inside
+ * ids cannot confuse the depth count.
+ * @param arrBegin Offset of the opening '[' of the drawables array.
+ * @param arrEnd Offset one past the closing ']'.
+ * @param spans [begin, end) byte ranges of the drawable objects, in order.
+ */
+struct DrawableSpanScanner
 {
-  BodyPartsSettings settings;
-  std::filesystem::path settingsPath = explicitPath;
-  if (settingsPath.empty())
+  const char *text;
+  size_t size;
+  size_t arrBegin = 0, arrEnd = 0;
+  std::vector<std::pair<size_t, size_t>> spans;
+
+  bool scan()
   {
-    settingsPath = getPartsPath(moc3JsonPath);
+    size_t i = skipWs(0);
+    if (i >= size || text[i] != '{')
+      return false;
+    i = skipWs(i + 1);
+    while (i < size && text[i] != '}')
+    {
+      if (text[i] != '"')
+        return false;
+      const size_t keyBegin = i + 1;
+      i = skipString(i);
+      if (i == npos)
+        return false;
+      const size_t keyEnd = i - 1;
+      i = skipWs(i);
+      if (i >= size || text[i] != ':')
+        return false;
+      i = skipWs(i + 1);
+      if (i < size && text[i] == '[' && std::string_view(text + keyBegin, keyEnd - keyBegin) == "drawables")
+        return scanDrawables(i);
+      i = skipValue(i);
+      if (i == npos)
+        return false;
+      i = skipWs(i);
+      if (i < size && text[i] == ',')
+        i = skipWs(i + 1);
+    }
+    return false;
   }
 
-  std::ifstream ifs(settingsPath);
-  if (!ifs)
-    return settings;
-  try
+private:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  size_t skipWs(size_t i) const
   {
-    nlohmann::json j;
-    ifs >> j;
-    if (j.contains("body_parts") && j["body_parts"].is_object())
+    while (i < size && (text[i] == ' ' || text[i] == '\n' || text[i] == '\r' || text[i] == '\t'))
+      ++i;
+    return i;
+  }
+
+  // i points at the opening quote; returns the offset after the closing quote.
+  size_t skipString(size_t i) const
+  {
+    for (++i; i < size; ++i)
     {
-      const auto &partsObj = j["body_parts"];
-      for (auto it = partsObj.begin(); it != partsObj.end(); ++it)
-      {
-        if (!it.value().is_array())
-          continue;
-        std::vector<std::string> ids;
-        for (const auto &id : it.value())
-        {
-          if (id.is_string())
-            ids.push_back(id.get<std::string>());
-        }
-        if (!ids.empty())
-          settings.parts[it.key()] = std::move(ids);
-      }
+      if (text[i] == '\\')
+        ++i;
+      else if (text[i] == '"')
+        return i + 1;
+    }
+    return npos;
+  }
+
+  size_t skipValue(size_t i) const
+  {
+    if (i >= size)
+      return npos;
+    if (text[i] == '"')
+      return skipString(i);
+    if (text[i] != '{' && text[i] != '[')
+    {
+      // Scalars run to the next delimiter; an empty one means the text is malformed.
+      const size_t begin = i;
+      while (i < size && text[i] != ',' && text[i] != '}' && text[i] != ']')
+        ++i;
+      return i == begin ? npos : i;
     }
-    if (j.contains("seam_parts") && j["seam_parts"].is_object())
+    int depth = 0;
+    for (; i < size; ++i)
     {
-      const auto &seamObj = j["seam_parts"];
-      for (auto it = seamObj.begin(); it != seamObj.end(); ++it)
+      const char c = text[i];
+      if (c == '"')
       {
-        if (!it.value().is_array())
-          continue;
-        std::vector<std::string> ids;
-        for (const auto &id : it.value())
-        {
-          if (id.is_string())
-            ids.push_back(id.get<std::string>());
-        }
-        if (!ids.empty())
-          settings.seams[it.key()] = std::move(ids);
+        i = skipString(i);
+        if (i == npos)
+          return npos;
+        --i;
       }
+      else if (c == '{' || c == '[')
+        ++depth;
+      else if ((c == '}' || c == ']') && --depth == 0)
+        return i + 1;
     }
+    return npos;
   }
-  catch (const std::exception &e)
+
+  bool scanDrawables(size_t i)
   {
-    std::cerr << "Failed to parse body parts settings: " << e.what() << "\n";
+    arrBegin = i;
+    i = skipWs(i + 1);
+    while (i < size && text[i] != ']')
+    {
+      const size_t end = skipValue(i);
+      if (end == npos)
+        return false;
+      // Non-object entries are not drawables; the DOM loader skipped them as well.
+      if (text[i] == '{')
+        spans.emplace_back(i, end);
+      i = skipWs(end);
+      if (i < size && text[i] == ',')
+        i = skipWs(i + 1);
+    }
+    if (i >= size)
+      return false;
+    arrEnd = i + 1;
+    return true;
   }
-  return settings;
+};
+
+// Pool the loader runs its loops on when the caller does not pass one; kept across loads so
+// reloading a model does not spawn a fresh set of threads each time.
+JobSystem &loaderJobs(unsigned workerCount)
+{
+  static JobSystem jobs(workerCount);
+  const unsigned wanted = workerCount ? workerCount : std::max(1u, std::thread::hardware_concurrency());
+  if (jobs.threadCount() != wanted)
+    jobs.setThreadCount(wanted);
+  return jobs;
 }
 
-std::string readTexturePathFromJson(const std::string &jsonFile)
+/**
+ * Applies render settings (draw order, hidden) and part tags to a model's meshes.
+ * Draw order follows the render-settings order; drawables it does not list are numbered in file
+ * order, which is why the model keeps its drawable source list.
+ */
+void applySidecars(Model &model, const SidecarManifest &sidecars)
 {
-  std::ifstream ifs(jsonFile);
-  if (!ifs)
+  const RenderSettings &renderSettings = *sidecars.renderSettings;
+  const PartsSettings &partsSettings = *sidecars.parts;
+  int fallbackOrder = renderSettings.order.empty() ? 0 : -1;
+  for (const auto &source : model.drawable_sources)
   {
-    std::cerr << "Cannot open atlas json: " << jsonFile << "\n";
-    return "";
+    auto itOrder = renderSettings.orderIndex.find(source.id);
+    const int order = (itOrder != renderSettings.orderIndex.end()) ? itOrder->second : fallbackOrder++;
+    if (!source.kept)
+      continue;
+    auto itMesh = model.meshes.find(source.id);
+    if (itMesh == model.meshes.end())
+      continue;
+    itMesh->second.draw_order = order;
+    itMesh->second.visible = renderSettings.hidden.count(source.id) == 0;
   }
-  try
+
+  model.mesh_face_parts = partsSettings.mesh_face_parts;
+  model.mesh_body_parts = partsSettings.mesh_body_parts;
+  model.mesh_seam_parts = partsSettings.mesh_seam_parts;
+  classifyMeshRegions(model);
+  if (!partsSettings.mesh_face_parts.empty())
   {
-    nlohmann::json j;
-    ifs >> j;
-    if (j.contains("texture") && j["texture"].is_string())
-      return j["texture"].get<std::string>();
-    std::cerr << "No \"texture\" string field in " << jsonFile << "\n";
+    std::cerr << "Face parts mapping loaded: " << partsSettings.faceTagCount << " tags, "
+              << partsSettings.faceMeshCount << " meshes";
+    if (partsSettings.hasFaceElements)
+      std::cerr << " (face elements detected)";
+    std::cerr << "\n";
   }
-  catch (const std::exception &e)
+  else
   {
-    std::cerr << "Failed to parse json " << jsonFile << ": " << e.what() << "\n";
+    std::cerr << "No face parts mapping found (face elements not identified).\n";
   }
-  return "";
+  if (partsSettings.bodyTagCount > 0)
+    std::cerr << "Body parts mapping loaded: " << partsSettings.bodyTagCount << " tags\n";
+  if (partsSettings.seamTagCount > 0)
+    std::cerr << "Seam parts mapping loaded: " << partsSettings.seamTagCount << " tags\n";
+
 }
+
 } // namespace
 
 bool loadAtlasTextureFromJson(Engine &eng,
@@ -245,21 +769,10 @@ bool loadAtlasTextureFromJson(Engine &eng,
 
   // Fallback: look for texture_00.png near the moc3 json directory
   std::filesystem::path fallback;
-  std::string targetName = "texture_00.png";
-  if (std::filesystem::is_directory(baseDir))
-  {
-    for (auto it = std::filesystem::recursive_directory_iterator(baseDir);
-         it != std::filesystem::recursive_directory_iterator(); ++it)
-    {
-      if (!it->is_regular_file())
-        continue;
-      if (it->path().filename() == targetName)
-      {
-        fallback = it->path();
-        break;
-      }
-    }
-  }
+  const auto assets = getAssetIndex(baseDir);
+  const std::filesystem::path fallbackRel = assets->findFile("texture_00.png");
+  if (!fallbackRel.empty())
+    fallback = baseDir / fallbackRel;
 
   if (!fallback.empty() && tryLoad(fallback))
     return true;
@@ -272,276 +785,215 @@ bool loadModelFromMoc3Json(const std::filesystem::path &jsonPath,
                            Engine &eng,
                            std::unordered_map<std::string, std::filesystem::path> &drawableTextures,
                            const std::filesystem::path &renderSettingsPath,
-                           const std::filesystem::path &partsPath)
+                           const std::filesystem::path &partsPath,
+                           const ModelLoadOptions &options)
 {
-  std::ifstream ifs(jsonPath);
-  if (!ifs)
+  MappedFile file;
+  if (!file.open(jsonPath))
   {
     std::cerr << "Cannot open model json: " << jsonPath << "\n";
     return false;
   }
+  const char *text = reinterpret_cast<const char *>(file.data);
 
-  json j;
-  try
-  {
-    ifs >> j;
-  }
-  catch (const std::exception &e)
+  std::filesystem::path baseDir = jsonPath.parent_path();
+  std::unordered_map<int, std::filesystem::path> indexedTextures;
+  if (!baseDir.empty())
   {
-    std::cerr << "JSON parse error in " << jsonPath << ": " << e.what() << "\n";
-    return false;
+    LoadPhaseScope phase("asset_index");
+    const auto assets = getAssetIndex(baseDir);
+    phase.setItems(assets->files.size());
+    indexedTextures.reserve(assets->indexedTextures.size());
+    for (const auto &kv : assets->indexedTextures)
+      indexedTextures.emplace(kv.first, baseDir / kv.second);
   }
 
-  if (!j.contains("drawables") || !j["drawables"].is_array())
-  {
-    std::cerr << "No drawables array in " << jsonPath << "\n";
-    return false;
-  }
+  JobSystem &jobs = options.jobs ? *options.jobs : loaderJobs(options.workerCount);
 
-  drawableTextures.clear();
-  const RenderSettings renderSettings = loadRenderSettings(jsonPath, renderSettingsPath);
-  const FacePartsSettings facePartsSettings = loadFacePartsSettings(jsonPath, partsPath);
-  const BodyPartsSettings bodyPartsSettings = loadBodyPartsSettings(jsonPath, partsPath);
-  std::unordered_map<std::string, int> orderIndex;
-  orderIndex.reserve(renderSettings.order.size());
-  for (size_t i = 0; i < renderSettings.order.size(); ++i)
+  // Split the drawables array into per-object spans so ranges of drawables can be parsed and
+  // converted on separate threads. The rest of the document is parsed with the array emptied.
+  LoadPhaseScope parsePhase("json_parse", file.size);
+  DrawableSpanScanner scanner{text, file.size};
+  Moc3SaxHandler handler;
+  std::vector<ParsedDrawable> drawables;
+  if (jobs.threadCount() > 1 && scanner.scan())
   {
-    int reversedIndex = static_cast<int>(renderSettings.order.size() - 1 - i);
-    orderIndex[renderSettings.order[i]] = reversedIndex;
-  }
-  int fallbackOrder = renderSettings.order.empty() ? 0 : -1;
-  std::filesystem::path baseDir = jsonPath.parent_path();
-  std::unordered_map<int, std::filesystem::path> indexedTextures;
-  if (!baseDir.empty())
-  {
-    for (auto it = std::filesystem::recursive_directory_iterator(baseDir);
-         it != std::filesystem::recursive_directory_iterator(); ++it)
+    std::string outer;
+    outer.reserve(file.size - (scanner.arrEnd - scanner.arrBegin) + 2);
+    outer.append(text, scanner.arrBegin);
+    outer.append("[]");
+    outer.append(text + scanner.arrEnd, file.size - scanner.arrEnd);
+    if (!json::sax_parse(outer, &handler))
     {
-      if (!it->is_regular_file())
-        continue;
-      std::string name = it->path().filename().string();
-      if (name.rfind("texture_", 0) != 0)
-        continue;
-      size_t dot = name.find_last_of('.');
-      if (dot == std::string::npos || dot <= 8)
-        continue;
-      std::string indexStr = name.substr(8, dot - 8);
-      try
-      {
-        int index = std::stoi(indexStr);
-        indexedTextures[index] = it->path();
-      }
-      catch (...)
+      std::cerr << "JSON parse error in " << jsonPath << ": " << handler.error << "\n";
+      return false;
+    }
+
+    const size_t spanCount = scanner.spans.size();
+    const size_t chunk = 8;
+    const size_t chunkCount = (spanCount + chunk - 1) / chunk;
+    drawables.resize(spanCount);
+    // JobSystem chunks start at multiples of a grain no smaller than `chunk`, so begin / chunk
+    // names a handler no other chunk uses.
+    std::vector<Moc3SaxHandler> partial(chunkCount);
+    jobs.parallelFor(spanCount, chunk, [&](size_t begin, size_t end)
+                     {
+                       Moc3SaxHandler &h = partial[begin / chunk];
+                       for (size_t i = begin; i < end && h.error.empty(); ++i)
+                       {
+                         h.beginDrawableSpan();
+                         const char *b = text + scanner.spans[i].first;
+                         const char *e = text + scanner.spans[i].second;
+                         if (json::sax_parse(b, e, &h) && !h.drawables.empty())
+                           drawables[i] = std::move(h.drawables.back());
+                         h.drawables.clear();
+                       }
+                     });
+    for (const auto &h : partial)
+    {
+      if (!h.error.empty())
       {
+        std::cerr << "JSON parse error in " << jsonPath << ": " << h.error << "\n";
+        return false;
       }
+      handler.bbMin.x = std::min(handler.bbMin.x, h.bbMin.x);
+      handler.bbMin.y = std::min(handler.bbMin.y, h.bbMin.y);
+      handler.bbMax.x = std::max(handler.bbMax.x, h.bbMax.x);
+      handler.bbMax.y = std::max(handler.bbMax.y, h.bbMax.y);
+      handler.totalVerts += h.totalVerts;
     }
   }
-
-  float canvas_w = j.value("canvas", json::object()).value("width", 2.0f);
-  float canvas_h = j.value("canvas", json::object()).value("height", 2.0f);
-
-  // First pass: compute global bounding box to center the model.
-  glm::vec2 bbMin(1e9f), bbMax(-1e9f);
-  size_t totalVerts = 0;
-  for (const auto &drawable : j["drawables"])
+  else
   {
-    if (!drawable.contains("positions") || !drawable["positions"].is_array())
-      continue;
-    for (const auto &p : drawable["positions"])
+    // Single streaming pass over the whole document.
+    if (!json::sax_parse(text, text + file.size, &handler))
     {
-      if (!p.is_array() || p.size() < 2)
-        continue;
-      float px = p[0].get<float>();
-      float py = p[1].get<float>();
-      bbMin.x = std::min(bbMin.x, px);
-      bbMin.y = std::min(bbMin.y, py);
-      bbMax.x = std::max(bbMax.x, px);
-      bbMax.y = std::max(bbMax.y, py);
-      ++totalVerts;
+      std::cerr << "JSON parse error in " << jsonPath << ": " << handler.error << "\n";
+      return false;
     }
+    drawables = std::move(handler.drawables);
+  }
+
+  parsePhase.end();
+
+  if (!handler.sawDrawables)
+  {
+    std::cerr << "No drawables array in " << jsonPath << "\n";
+    return false;
   }
 
-  if (totalVerts == 0)
+  if (handler.totalVerts == 0)
   {
     std::cerr << "No vertices found in " << jsonPath << "\n";
     return false;
   }
 
-  glm::vec2 bbCenter = (bbMin + bbMax) * 0.5f;
-  glm::vec2 bbSize = bbMax - bbMin;
+  const glm::vec2 bbCenter = (handler.bbMin + handler.bbMax) * 0.5f;
+  const glm::vec2 bbSize = handler.bbMax - handler.bbMin;
 
+  // Re-center around the global bbox; keep model Y as-is to avoid vertical flip.
+  {
+    LoadPhaseScope phase("recenter", handler.totalVerts);
+    jobs.parallelFor(drawables.size(), 32, [&](size_t begin, size_t end)
+                     {
+                       for (size_t i = begin; i < end; ++i)
+                         for (auto &v : drawables[i].mesh.verts)
+                           v.pos -= bbCenter;
+                     });
+  }
+
+  std::vector<MeshOptimizeStats> optimizeStats;
+  if (options.optimizeMeshes)
+  {
+    LoadPhaseScope phase("mesh_optimize", drawables.size());
+    optimizeStats.resize(drawables.size());
+    jobs.parallelFor(drawables.size(), 8, [&](size_t begin, size_t end)
+                     {
+                       for (size_t i = begin; i < end; ++i)
+                         if (drawables[i].usable)
+                           optimizeStats[i] = optimizeMesh(drawables[i].mesh);
+                     });
+  }
+
+  LoadPhaseScope mergePhase("drawable_merge", drawables.size());
+  drawableTextures.clear();
   eng.model.meshes.clear();
   eng.model.deformers.clear();
   eng.model.mesh_face_parts.clear();
   eng.model.mesh_body_parts.clear();
   eng.model.mesh_seam_parts.clear();
+  eng.model.drawable_sources.clear();
+  eng.model.drawable_sources.reserve(drawables.size());
+  eng.model.params.clear();
+  for (const auto &p : handler.parameters)
+  {
+    if (!p.id.empty())
+      eng.model.params.add(p.id, p.min, p.max, p.def);
+  }
 
   Deformer root;
   root.id = "def_root";
   eng.model.deformers.emplace(root.id, root);
+  auto &rootBound = eng.model.deformers[root.id].bound_meshes;
+  rootBound.reserve(drawables.size());
+  eng.model.meshes.reserve(drawables.size());
 
+  // Ids and textures depend on the drawables before them, so the merge stays sequential and the
+  // result does not depend on the worker count.
   int meshCounter = 0;
-  for (const auto &drawable : j["drawables"])
+  double trisTotal = 0.0, missesBefore = 0.0, missesAfter = 0.0;
+  for (size_t di = 0; di < drawables.size(); ++di)
   {
-    if (!drawable.contains("positions") || !drawable.contains("indices"))
-      continue;
-
-    const auto &posArr = drawable["positions"];
-    const auto &idxArr = drawable["indices"];
-    const auto &uvArr = drawable.contains("uvs") ? drawable["uvs"] : json::array();
-    if (!posArr.is_array() || !idxArr.is_array())
-      continue;
-
-    size_t vcount = posArr.size();
-    if (vcount == 0)
+    auto &d = drawables[di];
+    if (!d.usable)
       continue;
-
-    auto normPos = [&](float x, float y) -> glm::vec2
-    {
-      // Center around global bbox; keep model Y as-is to avoid vertical flip.
-      float nx = (x - bbCenter.x);
-      float ny = (y - bbCenter.y);
-      return glm::vec2(nx, ny);
-    };
-
-    ArtMesh mesh;
-    mesh.id = drawable.value("id", std::string("mesh_") + std::to_string(meshCounter));
-    if (!renderSettings.hidden.empty() && renderSettings.hidden.count(mesh.id))
-      mesh.visible = false;
-    int tex_idx = drawable.value("texture_index", 0);
-    std::string texId = std::string("tex_idx_") + std::to_string(tex_idx);
-    mesh.texture_id = texId;
-    auto itTex = indexedTextures.find(tex_idx);
+    ArtMesh &mesh = d.mesh;
+    if (!d.hasId)
+      mesh.id = std::string("mesh_") + std::to_string(meshCounter);
+    std::string texId = std::string("tex_idx_") + std::to_string(d.textureIndex);
+    auto itTex = indexedTextures.find(d.textureIndex);
     if (itTex != indexedTextures.end())
       drawableTextures.try_emplace(texId, itTex->second);
-    auto itOrder = orderIndex.find(mesh.id);
-    mesh.draw_order = (itOrder != orderIndex.end()) ? itOrder->second : fallbackOrder++;
-    mesh.blend_mode = drawable.value("blend_mode", 0);
-    mesh.opacity = drawable.value("opacity", 1.0f);
+    mesh.texture_id = std::move(texId);
+    if (d.droppedKeyforms > 0)
+      std::cerr << "Dropped " << d.droppedKeyforms << " malformed keyforms of " << mesh.id << "\n";
     mesh.deformers = {root.id};
+    buildSkinStreams(mesh);
 
-    mesh.verts.reserve(vcount);
-    for (size_t i = 0; i < vcount; ++i)
-    {
-      const auto &p = posArr[i];
-      if (!p.is_array() || p.size() < 2)
-        continue;
-      float px = p[0].get<float>();
-      float py = p[1].get<float>();
-
-      Vertex vtx;
-      vtx.pos = normPos(px, py);
-
-      float ux = 0.0f;
-      float uy = 0.0f;
-      if (i < uvArr.size() && uvArr[i].is_array() && uvArr[i].size() >= 2)
-      {
-        ux = uvArr[i][0].get<float>();
-        uy = uvArr[i][1].get<float>();
-      }
-      vtx.uv = {ux, 1.0f - uy};
-      vtx.color = {1.0f, 1.0f, 1.0f};
-      vtx.bone = {0, 0};
-      vtx.weight = {1.0f, 0.0f};
-      mesh.verts.push_back(vtx);
-    }
-
-    mesh.indices.reserve(idxArr.size());
-    for (const auto &idxVal : idxArr)
-    {
-      if (!idxVal.is_number())
-        continue;
-      int iv = idxVal.get<int>();
-      if (iv >= 0 && iv < static_cast<int>(mesh.verts.size()))
-        mesh.indices.push_back(static_cast<uint32_t>(iv));
-    }
-
+    auto &source = eng.model.drawable_sources.emplace_back(DrawableSource{mesh.id, false});
     if (mesh.verts.empty() || mesh.indices.size() < 3)
       continue;
 
-    eng.model.meshes.emplace(mesh.id, mesh);
-    eng.model.deformers[root.id].bound_meshes.push_back(mesh.id);
-    ++meshCounter;
-  }
-
-  if (!facePartsSettings.parts.empty())
-  {
-    for (const auto &kv : facePartsSettings.parts)
-    {
-      for (const auto &meshId : kv.second)
-      {
-        eng.model.mesh_face_parts[meshId].insert(kv.first);
-      }
-    }
-    std::unordered_set<std::string> tags;
-    std::unordered_set<std::string> meshes;
-    for (const auto &kv : eng.model.mesh_face_parts)
+    if (!optimizeStats.empty())
     {
-      meshes.insert(kv.first);
-      for (const auto &tag : kv.second)
-        tags.insert(tag);
-    }
-    const bool hasFaceTags = tags.count("eye_left") || tags.count("eye_right") || tags.count("eye")
-                             || tags.count("mouth") || tags.count("brow_left") || tags.count("brow_right")
-                             || tags.count("eye_white_left") || tags.count("eye_white_right")
-                             || tags.count("eye_ball_left") || tags.count("eye_ball_right");
-    std::cerr << "Face parts mapping loaded: " << tags.size() << " tags, " << meshes.size() << " meshes";
-    if (hasFaceTags)
-      std::cerr << " (face elements detected)";
-    std::cerr << "\n";
-  }
-  else
-  {
-    std::cerr << "No face parts mapping found (face elements not identified).\n";
-  }
-
-  if (!bodyPartsSettings.parts.empty())
-  {
-    for (const auto &kv : bodyPartsSettings.parts)
-    {
-      for (const auto &meshId : kv.second)
-      {
-        eng.model.mesh_body_parts[meshId].insert(kv.first);
-      }
+      const MeshOptimizeStats &st = optimizeStats[di];
+      trisTotal += double(st.triangles);
+      missesBefore += double(st.acmrBefore) * double(st.triangles);
+      missesAfter += double(st.acmrAfter) * double(st.triangles);
+      if (options.reportAcmr)
+        std::cerr << "ACMR " << mesh.id << ": " << st.acmrBefore << " -> " << st.acmrAfter << " (" << st.triangles
+                  << " triangles)\n";
     }
-    std::cerr << "Body parts mapping loaded: " << bodyPartsSettings.parts.size() << " tags\n";
-  }
 
-  if (!bodyPartsSettings.seams.empty())
-  {
-    for (const auto &kv : bodyPartsSettings.seams)
-    {
-      for (const auto &meshId : kv.second)
-      {
-        eng.model.mesh_seam_parts[meshId].insert(kv.first);
-      }
-    }
-    std::cerr << "Seam parts mapping loaded: " << bodyPartsSettings.seams.size() << " tags\n";
+    rootBound.push_back(mesh.id);
+    std::string id = mesh.id;
+    source.kept = eng.model.meshes.emplace(std::move(id), std::move(mesh)).second;
+    ++meshCounter;
   }
+  drawables.clear();
+  mergePhase.end();
+  if (trisTotal > 0.0)
+    std::cerr << "Mesh optimization: ACMR " << missesBefore / trisTotal << " -> " << missesAfter / trisTotal
+              << " over " << static_cast<size_t>(trisTotal) << " triangles\n";
 
-  if (bodyPartsSettings.parts.empty() && bodyPartsSettings.seams.empty() && !facePartsSettings.parts.empty())
   {
-    const std::unordered_set<std::string> bodyTags = {
-        "head", "neck", "shoulder_left", "shoulder_right", "torso", "chest", "body",
-        "hair", "hair_front", "hair_back", "hair_side", "ear_left", "ear_right"};
-    const std::unordered_set<std::string> seamTags = {"neck_seam", "jaw_seam"};
-    for (const auto &kv : facePartsSettings.parts)
-    {
-      if (bodyTags.count(kv.first))
-      {
-        for (const auto &meshId : kv.second)
-          eng.model.mesh_body_parts[meshId].insert(kv.first);
-      }
-      if (seamTags.count(kv.first))
-      {
-        for (const auto &meshId : kv.second)
-          eng.model.mesh_seam_parts[meshId].insert(kv.first);
-      }
-    }
+    LoadPhaseScope phase("sidecars", eng.model.meshes.size());
+    applySidecars(eng.model, loadSidecarManifest(jsonPath, renderSettingsPath, partsPath));
   }
+  eng.model.buildDeformerTree();
 
   // Use whichever is larger: declared canvas or actual bbox size, to keep aspect-fit sane.
-  eng.canvas = {std::max(canvas_w, bbSize.x), std::max(canvas_h, bbSize.y)};
+  eng.canvas = {std::max(handler.canvasW, bbSize.x), std::max(handler.canvasH, bbSize.y)};
 
   if (meshCounter == 0)
   {
@@ -549,6 +1001,18 @@ bool loadModelFromMoc3Json(const std::filesystem::path &jsonPath,
     return false;
   }
 
-  std::cerr << "Loaded " << meshCounter << " drawables from " << jsonPath << "\n";
+  std::cerr << "Loaded " << meshCounter << " drawables and " << eng.model.params.size() << " parameters from "
+            << jsonPath << "\n";
+  return true;
+}
+
+bool reloadModelSidecars(const std::filesystem::path &jsonPath,
+                         Model &model,
+                         const std::filesystem::path &renderSettingsPath,
+                         const std::filesystem::path &partsPath)
+{
+  if (model.drawable_sources.empty())
+    return false;
+  applySidecars(model, loadSidecarManifest(jsonPath, renderSettingsPath, partsPath));
   return true;
 }
@@ -5,13 +5,39 @@
 #include <unordered_map>
 
 class Engine;
+class JobSystem;
+struct Model;
+
+/**
+ * Options for loadModelFromMoc3Json.
+ * @param workerCount Threads used to parse and build drawables (0 = hardware concurrency, 1 = serial).
+ * @param jobs Job system to run the load on instead of the loader's own pool; workerCount is then
+ *             ignored. Must not be running another loop while the model loads.
+ * @param optimizeMeshes Reorder triangles and vertices for the vertex cache (see mesh_optimize.h).
+ * @param reportAcmr Print before/after ACMR for every mesh, not just the model total.
+ */
+struct ModelLoadOptions
+{
+  unsigned workerCount = 0;
+  JobSystem *jobs = nullptr;
+  bool optimizeMeshes = true;
+  bool reportAcmr = false;
+};
 
 // Loads a model from a .moc3.json file into the Engine. Also returns a map of texture IDs to file paths.
 bool loadModelFromMoc3Json(const std::filesystem::path &jsonPath,
                            Engine &eng,
                            std::unordered_map<std::string, std::filesystem::path> &drawableTextures,
                            const std::filesystem::path &renderSettingsPath = {},
-                           const std::filesystem::path &partsPath = {});
+                           const std::filesystem::path &partsPath = {},
+                           const ModelLoadOptions &options = {});
+
+// Re-applies the render settings and parts files of jsonPath to a model previously loaded from it,
+// without re-reading the .moc3.json. Returns false if the model has no drawable source list.
+bool reloadModelSidecars(const std::filesystem::path &jsonPath,
+                         Model &model,
+                         const std::filesystem::path &renderSettingsPath = {},
+                         const std::filesystem::path &partsPath = {});
 
 // Loads an atlas texture from a Live2D atlas JSON file and registers it in the Engine.
 bool loadAtlasTextureFromJson(Engine &eng,
@@ -0,0 +1,102 @@
+#ifndef __LITE2D_PARAM_STORE_H__
+#pragma once
+#define __LITE2D_PARAM_STORE_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Index of a parameter in a ParamStore. Stays valid for the lifetime of the store's layout: adding
+// parameters appends, and removing one only drops its name.
+using ParamHandle = uint32_t;
+constexpr ParamHandle kInvalidParam = 0xFFFFFFFFu;
+
+/**
+ * Model parameters as parallel arrays indexed by ParamHandle. Names are only used to resolve
+ * handles (at load, or from external APIs); per-frame code reads and writes the arrays directly.
+ * @param ids Parameter id per handle.
+ * @param cur Current value per handle.
+ * @param min Minimum value per handle.
+ * @param max Maximum value per handle.
+ * @param def Default value per handle.
+ */
+class ParamStore
+{
+public:
+  std::vector<std::string> ids;
+  std::vector<float> cur, min, max, def;
+
+  size_t size() const { return ids.size(); }
+  bool empty() const { return ids.empty(); }
+
+  // Bumped whenever handles are added, unnamed or cleared; cached handles are stale when it moves.
+  uint32_t layoutVersion() const { return layout; }
+
+  // Adds a parameter, or updates the range and default of an existing one (keeping its value).
+  ParamHandle add(const std::string &id, float mn, float mx, float df)
+  {
+    auto it = byName.find(id);
+    if (it != byName.end())
+    {
+      const ParamHandle h = it->second;
+      min[h] = mn;
+      max[h] = mx;
+      def[h] = df;
+      set(h, cur[h]);
+      return h;
+    }
+    const ParamHandle h = static_cast<ParamHandle>(ids.size());
+    ids.push_back(id);
+    cur.push_back(df);
+    min.push_back(mn);
+    max.push_back(mx);
+    def.push_back(df);
+    byName.emplace(id, h);
+    ++layout;
+    return h;
+  }
+
+  // The slot stays allocated so other handles keep their meaning; it just can no longer be found.
+  void remove(const std::string &id)
+  {
+    if (byName.erase(id))
+      ++layout;
+  }
+
+  void clear()
+  {
+    ids.clear();
+    cur.clear();
+    min.clear();
+    max.clear();
+    def.clear();
+    byName.clear();
+    ++layout;
+  }
+
+  ParamHandle find(const std::string &id) const
+  {
+    auto it = byName.find(id);
+    return it == byName.end() ? kInvalidParam : it->second;
+  }
+
+  float value(ParamHandle h, float fallback = 0.0f) const { return h < cur.size() ? cur[h] : fallback; }
+
+  void set(ParamHandle h, float v)
+  {
+    if (h < cur.size())
+      cur[h] = glm::clamp(v, min[h], max[h]);
+  }
+
+  void resetAll() { std::copy(def.begin(), def.end(), cur.begin()); }
+
+private:
+  std::unordered_map<std::string, ParamHandle> byName;
+  uint32_t layout = 0;
+};
+
+#endif  // __LITE2D_PARAM_STORE_H__
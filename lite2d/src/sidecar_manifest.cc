@@ -0,0 +1,258 @@
+#include "sidecar_manifest.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+
+#include "commons/json.hpp"
+
+using json = nlohmann::json;
+
+namespace
+{
+/**
+ * A compiled sidecar file remembered between loads.
+ * @param mtime Last write time when the file was compiled or last revalidated.
+ * @param size File size at that time.
+ * @param hash FNV-1a hash of the file content.
+ * @param value The compiled result.
+ */
+template <typename T>
+struct CacheEntry
+{
+  std::filesystem::file_time_type mtime;
+  uintmax_t size = 0;
+  uint64_t hash = 0;
+  std::shared_ptr<const T> value;
+};
+
+std::mutex cacheMutex;
+std::unordered_map<std::string, CacheEntry<RenderSettings>> renderSettingsCache;
+std::unordered_map<std::string, CacheEntry<PartsSettings>> partsCache;
+
+bool endsWith(const std::string &value, const std::string &suffix)
+{
+  if (suffix.size() > value.size())
+    return false;
+  return std::equal(suffix.rbegin(), suffix.rend(), value.rbegin());
+}
+
+std::filesystem::path siblingPath(const std::filesystem::path &moc3JsonPath, const char *ext)
+{
+  const std::string suffix = ".moc3.json";
+  const std::string pathStr = moc3JsonPath.string();
+  if (endsWith(pathStr, suffix))
+    return std::filesystem::path(pathStr.substr(0, pathStr.size() - suffix.size()) + ext);
+  return std::filesystem::path(pathStr + ext);
+}
+
+uint64_t fnv1a(const std::string &bytes)
+{
+  uint64_t h = 1469598103934665603ull;
+  for (unsigned char c : bytes)
+  {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+// Reads "key": { tag: [mesh ids...] } into per-mesh tag sets. Returns the number of non-empty tags.
+size_t invertTagObject(const json &j, const char *key, MeshTagMap &out)
+{
+  if (!j.contains(key) || !j[key].is_object())
+    return 0;
+  size_t tags = 0;
+  const auto &obj = j[key];
+  for (auto it = obj.begin(); it != obj.end(); ++it)
+  {
+    if (!it.value().is_array())
+      continue;
+    bool any = false;
+    for (const auto &id : it.value())
+    {
+      if (!id.is_string())
+        continue;
+      out[id.get<std::string>()].insert(it.key());
+      any = true;
+    }
+    if (any)
+      ++tags;
+  }
+  return tags;
+}
+
+RenderSettings compileRenderSettings(const std::string &bytes)
+{
+  RenderSettings settings;
+  try
+  {
+    json j = json::parse(bytes);
+    if (j.contains("order") && j["order"].is_array())
+    {
+      for (const auto &id : j["order"])
+      {
+        if (id.is_string())
+          settings.order.push_back(id.get<std::string>());
+      }
+    }
+    if (j.contains("hidden") && j["hidden"].is_array())
+    {
+      for (const auto &id : j["hidden"])
+      {
+        if (id.is_string())
+          settings.hidden.insert(id.get<std::string>());
+      }
+    }
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to parse render settings: " << e.what() << "\n";
+    return RenderSettings{};
+  }
+
+  settings.orderIndex.reserve(settings.order.size());
+  for (size_t i = 0; i < settings.order.size(); ++i)
+  {
+    int reversedIndex = static_cast<int>(settings.order.size() - 1 - i);
+    settings.orderIndex[settings.order[i]] = reversedIndex;
+  }
+  return settings;
+}
+
+PartsSettings compilePartsSettings(const std::string &bytes)
+{
+  PartsSettings settings;
+  try
+  {
+    json j = json::parse(bytes);
+    invertTagObject(j, "face_parts", settings.mesh_face_parts);
+    settings.bodyTagCount = invertTagObject(j, "body_parts", settings.mesh_body_parts);
+    settings.seamTagCount = invertTagObject(j, "seam_parts", settings.mesh_seam_parts);
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Failed to parse parts settings: " << e.what() << "\n";
+    return PartsSettings{};
+  }
+
+  std::unordered_set<std::string> faceTags;
+  for (const auto &kv : settings.mesh_face_parts)
+    faceTags.insert(kv.second.begin(), kv.second.end());
+  settings.faceTagCount = faceTags.size();
+  settings.faceMeshCount = settings.mesh_face_parts.size();
+  for (const char *tag : {"eye_left", "eye_right", "eye", "mouth", "brow_left", "brow_right",
+                          "eye_white_left", "eye_white_right", "eye_ball_left", "eye_ball_right"})
+  {
+    if (faceTags.count(tag))
+    {
+      settings.hasFaceElements = true;
+      break;
+    }
+  }
+
+  // Older parts files only have face_parts; pick body and seam tags out of it.
+  if (settings.mesh_body_parts.empty() && settings.mesh_seam_parts.empty())
+  {
+    static const std::unordered_set<std::string> bodyTags = {
+        "head", "neck", "shoulder_left", "shoulder_right", "torso", "chest", "body",
+        "hair", "hair_front", "hair_back", "hair_side", "ear_left", "ear_right"};
+    static const std::unordered_set<std::string> seamTags = {"neck_seam", "jaw_seam"};
+    for (const auto &kv : settings.mesh_face_parts)
+    {
+      for (const auto &tag : kv.second)
+      {
+        if (bodyTags.count(tag))
+          settings.mesh_body_parts[kv.first].insert(tag);
+        if (seamTags.count(tag))
+          settings.mesh_seam_parts[kv.first].insert(tag);
+      }
+    }
+  }
+  return settings;
+}
+
+/**
+ * Returns the compiled form of a sidecar file, consulting and refreshing the cache.
+ * Missing files yield an empty result and evict any stale entry.
+ */
+template <typename T, typename CompileFn>
+std::shared_ptr<const T> loadCached(const std::filesystem::path &path,
+                                    std::unordered_map<std::string, CacheEntry<T>> &cache,
+                                    CompileFn compile)
+{
+  static const auto empty = std::make_shared<const T>();
+  std::error_code ec;
+  const std::string key = std::filesystem::absolute(path, ec).lexically_normal().string();
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  const uintmax_t size = ec ? 0 : std::filesystem::file_size(path, ec);
+  if (ec)
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.erase(key);
+    return empty;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = cache.find(key);
+    if (it != cache.end() && it->second.mtime == mtime && it->second.size == size)
+      return it->second.value;
+  }
+
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs)
+    return empty;
+  const std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  const uint64_t hash = fnv1a(bytes);
+
+  {
+    // Touched but unchanged (e.g. re-saved by the editor): keep the compiled result.
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = cache.find(key);
+    if (it != cache.end() && it->second.hash == hash && it->second.size == bytes.size())
+    {
+      it->second.mtime = mtime;
+      return it->second.value;
+    }
+  }
+
+  auto value = std::make_shared<const T>(compile(bytes));
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  cache[key] = CacheEntry<T>{mtime, bytes.size(), hash, value};
+  return value;
+}
+} // namespace
+
+std::filesystem::path getRenderSettingsPath(const std::filesystem::path &moc3JsonPath)
+{
+  return siblingPath(moc3JsonPath, ".moc3.render-settings.json");
+}
+
+std::filesystem::path getPartsPath(const std::filesystem::path &moc3JsonPath)
+{
+  return siblingPath(moc3JsonPath, ".moc3.parts.json");
+}
+
+SidecarManifest loadSidecarManifest(const std::filesystem::path &moc3JsonPath,
+                                    const std::filesystem::path &renderSettingsPath,
+                                    const std::filesystem::path &partsPath)
+{
+  SidecarManifest manifest;
+  manifest.renderSettingsPath = renderSettingsPath.empty() ? getRenderSettingsPath(moc3JsonPath)
+                                                           : renderSettingsPath;
+  manifest.partsPath = partsPath.empty() ? getPartsPath(moc3JsonPath) : partsPath;
+  manifest.renderSettings = loadCached<RenderSettings>(manifest.renderSettingsPath, renderSettingsCache,
+                                                       compileRenderSettings);
+  manifest.parts = loadCached<PartsSettings>(manifest.partsPath, partsCache, compilePartsSettings);
+  return manifest;
+}
+
+void clearSidecarCache()
+{
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  renderSettingsCache.clear();
+  partsCache.clear();
+}
@@ -0,0 +1,83 @@
+#ifndef __LITE2D_SIDECAR_MANIFEST_H__
+#pragma once
+#define __LITE2D_SIDECAR_MANIFEST_H__
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// mesh id -> set of part tags, the shape Model stores them in.
+using MeshTagMap = std::unordered_map<std::string, std::unordered_set<std::string>>;
+
+/**
+ * Compiled .moc3.render-settings.json.
+ * @param order Mesh ids as listed in "order" (first = frontmost).
+ * @param hidden Mesh ids listed in "hidden".
+ * @param orderIndex Mesh id -> draw_order (the reverse of its position in order).
+ */
+struct RenderSettings
+{
+  std::vector<std::string> order;
+  std::unordered_set<std::string> hidden;
+  std::unordered_map<std::string, int> orderIndex;
+};
+
+/**
+ * Compiled .moc3.parts.json, with face, body and seam tags already inverted to per-mesh maps.
+ * When the file has no body_parts/seam_parts, body and seam tags found under face_parts are used.
+ * @param mesh_face_parts Mesh id -> face part tags.
+ * @param mesh_body_parts Mesh id -> body part tags.
+ * @param mesh_seam_parts Mesh id -> seam tags.
+ * @param faceTagCount Distinct face tags that map to at least one mesh.
+ * @param faceMeshCount Meshes with at least one face tag.
+ * @param hasFaceElements Whether eye/mouth/brow tags are present.
+ * @param bodyTagCount Non-empty body_parts entries in the file.
+ * @param seamTagCount Non-empty seam_parts entries in the file.
+ */
+struct PartsSettings
+{
+  MeshTagMap mesh_face_parts;
+  MeshTagMap mesh_body_parts;
+  MeshTagMap mesh_seam_parts;
+  size_t faceTagCount = 0;
+  size_t faceMeshCount = 0;
+  bool hasFaceElements = false;
+  size_t bodyTagCount = 0;
+  size_t seamTagCount = 0;
+};
+
+/**
+ * The sidecar data of one model. Both halves are shared with the process-wide cache and must be
+ * treated as immutable.
+ * @param renderSettings Compiled render settings (empty if the file is missing or invalid).
+ * @param parts Compiled parts mapping (empty if the file is missing or invalid).
+ * @param renderSettingsPath The render settings file that was consulted.
+ * @param partsPath The parts file that was consulted.
+ */
+struct SidecarManifest
+{
+  std::shared_ptr<const RenderSettings> renderSettings;
+  std::shared_ptr<const PartsSettings> parts;
+  std::filesystem::path renderSettingsPath;
+  std::filesystem::path partsPath;
+};
+
+// Default sidecar locations next to a .moc3.json (foo.moc3.json -> foo.moc3.render-settings.json / foo.moc3.parts.json).
+std::filesystem::path getRenderSettingsPath(const std::filesystem::path &moc3JsonPath);
+std::filesystem::path getPartsPath(const std::filesystem::path &moc3JsonPath);
+
+// Loads the render settings and parts sidecars of a model, each parsed at most once per content.
+// Results are cached by path; a cached entry is reused while mtime and size are unchanged, or when
+// the file was touched but its content hash still matches. Explicit paths override the defaults.
+SidecarManifest loadSidecarManifest(const std::filesystem::path &moc3JsonPath,
+                                    const std::filesystem::path &renderSettingsPath = {},
+                                    const std::filesystem::path &partsPath = {});
+
+// Drops every cached sidecar.
+void clearSidecarCache();
+
+#endif  // __LITE2D_SIDECAR_MANIFEST_H__
@@ -0,0 +1,63 @@
+#include "sim_clock.h"
+
+#include <algorithm>
+#include <cmath>
+
+SimClock::SimClock(float rate, int maxSteps)
+{
+  setRate(rate);
+  setMaxSteps(maxSteps);
+}
+
+void SimClock::setRate(float rate)
+{
+  stepRate = rate > 0.0f ? rate : 0.0f;
+  if (stepRate == 0.0f)
+    accumulator = 0.0;
+}
+
+void SimClock::setMaxSteps(int steps)
+{
+  stepLimit = std::max(1, steps);
+}
+
+int SimClock::advance(float frameSeconds)
+{
+  // Negative or NaN frame times (a clock that jumped back) advance nothing.
+  const double frame = frameSeconds > 0.0f ? frameSeconds : 0.0;
+  if (stepRate == 0.0f)
+  {
+    step = frame;
+    steps = 1;
+    time += frame;
+    blend = 1.0f;
+    return steps;
+  }
+
+  step = 1.0 / stepRate;
+  accumulator += frame;
+  double due = std::floor(accumulator / step);
+  if (due > stepLimit)
+  {
+    // Catching up would take longer than the frame that fell behind; skip ahead instead.
+    dropped += (due - stepLimit) * step;
+    ++droppedCount;
+    accumulator -= (due - stepLimit) * step;
+    due = stepLimit;
+  }
+  steps = static_cast<int>(due);
+  accumulator = std::max(0.0, accumulator - due * step);
+  time += due * step;
+  blend = static_cast<float>(std::min(1.0, accumulator / step));
+  return steps;
+}
+
+void SimClock::reset()
+{
+  steps = 0;
+  accumulator = 0.0;
+  time = 0.0;
+  blend = 1.0f;
+  dropped = 0.0;
+  droppedCount = 0;
+}
@@ -0,0 +1,60 @@
+#ifndef __LITE2D_SIM_CLOCK_H__
+#pragma once
+#define __LITE2D_SIM_CLOCK_H__
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fixed-timestep clock for the simulation (animation, blinking, springs). Frame time goes into an
+ * accumulator, and the simulation runs in whole steps of stepSeconds() until less than one step is
+ * left. What remains, as a fraction of a step, is how far the rendered frame lies between the last
+ * two simulated states. At most maxSteps steps run per frame: after a stall the surplus time is
+ * dropped rather than caught up, so a slow frame cannot cause an even slower one.
+ * A rate of 0 steps once per frame with the frame's own duration.
+ */
+class SimClock
+{
+public:
+  static constexpr float kDefaultRate = 120.0f;
+  static constexpr int kDefaultMaxSteps = 8;
+
+  explicit SimClock(float rate = kDefaultRate, int maxSteps = kDefaultMaxSteps);
+
+  // Steps per second; 0 for one step per frame. Keeps the accumulated time.
+  void setRate(float rate);
+  float rate() const { return stepRate; }
+  void setMaxSteps(int steps);
+  int maxSteps() const { return stepLimit; }
+
+  // Adds frameSeconds and returns the number of steps to run for it.
+  int advance(float frameSeconds);
+
+  // Duration of the steps the last advance() returned.
+  float stepSeconds() const { return static_cast<float>(step); }
+  // Simulated time at the end of step i (from 0) of the last advance().
+  double stepEnd(int i) const { return time - step * (steps - 1 - i); }
+  // Simulated time of the latest state, after all steps of the last advance().
+  double now() const { return time; }
+  // Position of the rendered frame between the previous state (0) and the latest (1).
+  float alpha() const { return blend; }
+
+  // Frame time thrown away by the step cap since construction or reset().
+  double droppedSeconds() const { return dropped; }
+  uint64_t droppedFrames() const { return droppedCount; }
+
+  void reset();
+
+private:
+  float stepRate;
+  int stepLimit;
+  double step = 0.0;
+  int steps = 0;
+  double accumulator = 0.0;
+  double time = 0.0;
+  float blend = 1.0f;
+  double dropped = 0.0;
+  uint64_t droppedCount = 0;
+};
+
+#endif  // __LITE2D_SIM_CLOCK_H__
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "engine.h"
+#include "model_binary.h"
+#include "model_loader.h"
+#include "skinning.h"
+
+// ---------- lite2d_skin_bench: CPU skinning throughput, old per-vertex lookup vs. SoA kernels ----------
+
+static void printUsage(const char *argv0)
+{
+  std::cerr << "Usage: " << argv0 << " [options]\n"
+            << "Options:\n"
+            << "  -m, --moc3=FILE             Skin the meshes of a .moc3.json or .lite2d model\n"
+            << "      --meshes=N              Synthetic meshes when no model is given (default 150)\n"
+            << "      --verts=N               Vertices per synthetic mesh (default 256)\n"
+            << "      --bones=N               Influences per synthetic vertex, 1 or 2 (default 2)\n"
+            << "  -n, --iterations=N          Timed passes over all meshes (default 200)\n"
+            << "  -h, --help                  Show this help\n";
+}
+
+static bool parseOptionValue(const std::string &arg, const std::string &longName, std::string &out)
+{
+  const std::string prefix = "--" + longName + "=";
+  if (arg.rfind(prefix, 0) == 0)
+  {
+    out = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+static bool parseShortOptionValue(const std::string &arg, const std::string &shortName, std::string &out)
+{
+  const std::string prefix = "-" + shortName + "=";
+  if (arg.rfind(prefix, 0) == 0)
+  {
+    out = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+// Engine::deformMesh before the SoA rewrite: AoS vertices, one map lookup per influence.
+static void legacyDeformMesh(const std::unordered_map<std::string, glm::mat3> &worldM, const ArtMesh &m,
+                             std::span<glm::vec2> out)
+{
+  for (size_t i = 0; i < m.verts.size(); ++i)
+  {
+    const auto &v = m.verts[i];
+    glm::vec3 hp{v.pos.x, v.pos.y, 1.0f};
+    glm::vec3 acc{0, 0, 0};
+    for (int j = 0; j < 2; j++)
+    {
+      int boneIdx = v.bone[j];
+      float w = v.weight[j];
+      if (w <= 0)
+        continue;
+      if (boneIdx < 0 || boneIdx >= (int)m.deformers.size())
+        continue;
+      auto itM = worldM.find(m.deformers[boneIdx]);
+      if (itM == worldM.end())
+        continue;
+      acc += (itM->second * hp) * w;
+    }
+    out[i] = glm::vec2(acc.x, acc.y);
+  }
+}
+
+// A deformer chain and meshes bound to random pairs of its links.
+static void makeSyntheticModel(Model &model, int meshCount, int vertsPerMesh, int bones)
+{
+  constexpr int kDeformers = 32;
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+
+  for (int d = 0; d < kDeformers; ++d)
+  {
+    Deformer def;
+    def.id = "def_" + std::to_string(d);
+    def.parent = d > 0 ? "def_" + std::to_string(d - 1) : "";
+    def.pos = {unit(rng) * 0.1f, unit(rng) * 0.1f};
+    def.rot_deg = unit(rng) * 10.0f;
+    def.scale = {1.0f + unit(rng) * 0.05f, 1.0f + unit(rng) * 0.05f};
+    if (d + 1 < kDeformers)
+      def.children.push_back("def_" + std::to_string(d + 1));
+    model.deformers.emplace(def.id, def);
+  }
+
+  for (int i = 0; i < meshCount; ++i)
+  {
+    ArtMesh m;
+    m.id = "mesh_" + std::to_string(i);
+    m.deformers = {"def_" + std::to_string(rng() % kDeformers), "def_" + std::to_string(rng() % kDeformers)};
+    m.verts.resize(vertsPerMesh);
+    for (auto &v : m.verts)
+    {
+      v.pos = {unit(rng), unit(rng)};
+      if (bones == 1)
+      {
+        v.bone = {int(rng() % 2), 0};
+        v.weight = {1.0f, 0.0f};
+      }
+      else
+      {
+        const float w = weight(rng);
+        v.bone = {0, 1};
+        v.weight = {w, 1.0f - w};
+      }
+    }
+    model.meshes.emplace(m.id, std::move(m));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::filesystem::path modelPath;
+  int meshCount = 150;
+  int vertsPerMesh = 256;
+  int bones = 2;
+  int iterations = 200;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help")
+    {
+      printUsage(argv[0]);
+      return 0;
+    }
+
+    std::string value;
+    if (parseOptionValue(arg, "moc3", value) || parseShortOptionValue(arg, "m", value))
+    {
+      modelPath = value;
+      continue;
+    }
+    if (parseOptionValue(arg, "meshes", value))
+    {
+      meshCount = std::atoi(value.c_str());
+      continue;
+    }
+    if (parseOptionValue(arg, "verts", value))
+    {
+      vertsPerMesh = std::atoi(value.c_str());
+      continue;
+    }
+    if (parseOptionValue(arg, "bones", value))
+    {
+      bones = std::atoi(value.c_str());
+      continue;
+    }
+    if (parseOptionValue(arg, "iterations", value) || parseShortOptionValue(arg, "n", value))
+    {
+      iterations = std::atoi(value.c_str());
+      continue;
+    }
+
+    if ((arg == "-m" || arg == "--moc3") && i + 1 < argc)
+    {
+      modelPath = argv[++i];
+      continue;
+    }
+    if ((arg == "-n" || arg == "--iterations") && i + 1 < argc)
+    {
+      iterations = std::atoi(argv[++i]);
+      continue;
+    }
+
+    std::cerr << "Unknown option: " << arg << "\n";
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  if (iterations <= 0 || meshCount <= 0 || vertsPerMesh <= 0 || (bones != 1 && bones != 2))
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  // Loading only touches the model; no GL context is needed.
+  Engine eng;
+  if (!modelPath.empty())
+  {
+    std::unordered_map<std::string, std::filesystem::path> drawableTextures;
+    const bool ok = modelPath.extension() == ".lite2d"
+                        ? loadModelFromLite2d(modelPath, eng, drawableTextures)
+                        : loadModelFromMoc3Json(modelPath, eng, drawableTextures, {}, {});
+    if (!ok)
+    {
+      std::cerr << "Failed to load " << modelPath << "\n";
+      return 1;
+    }
+  }
+  else
+  {
+    makeSyntheticModel(eng.model, meshCount, vertsPerMesh, bones);
+    buildSkinStreams(eng.model);
+  }
+  eng.computeDeformers();
+  std::unordered_map<std::string, glm::mat3> worldM;
+  for (int32_t d = 0; d < static_cast<int32_t>(eng.model.deformerTree.size()); ++d)
+    worldM.emplace(eng.model.deformerTree.id(d), eng.model.deformerTree.world(d));
+
+  std::vector<const ArtMesh *> meshes;
+  size_t vertexCount = 0;
+  size_t kindCount[3] = {};
+  for (const auto &kv : eng.model.meshes)
+  {
+    meshes.push_back(&kv.second);
+    vertexCount += kv.second.verts.size();
+    ++kindCount[static_cast<int>(kv.second.skin.kind)];
+  }
+  std::cout << meshes.size() << " meshes, " << vertexCount << " vertices (" << kindCount[0] << " rigid, "
+            << kindCount[1] << " one-bone, " << kindCount[2] << " two-bone)\n";
+  if (vertexCount == 0)
+    return 1;
+
+  std::vector<std::vector<glm::vec2>> expected(meshes.size()), actual(meshes.size());
+  for (size_t i = 0; i < meshes.size(); ++i)
+  {
+    expected[i].resize(meshes[i]->verts.size());
+    actual[i].resize(meshes[i]->verts.size());
+    legacyDeformMesh(worldM, *meshes[i], expected[i]);
+  }
+
+  // Median time of one pass over every mesh.
+  auto timePasses = [&](auto &&skinAll)
+  {
+    std::vector<double> ms(iterations);
+    skinAll(); // warm caches
+    for (int it = 0; it < iterations; ++it)
+    {
+      const auto t0 = std::chrono::steady_clock::now();
+      skinAll();
+      ms[it] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    std::sort(ms.begin(), ms.end());
+    return ms[ms.size() / 2];
+  };
+
+  std::cout << std::left << std::setw(10) << "kernel" << std::right << std::setw(12) << "median ms" << std::setw(10)
+            << "ns/vert" << std::setw(10) << "speedup" << std::setw(12) << "max error" << "\n";
+  const double legacyMs = timePasses(
+      [&]
+      {
+        for (size_t i = 0; i < meshes.size(); ++i)
+          legacyDeformMesh(worldM, *meshes[i], actual[i]);
+      });
+  auto report = [&](const char *name, double ms, float maxError)
+  {
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << ms << std::setprecision(2) << std::setw(10) << ms * 1e6 / double(vertexCount)
+              << std::setw(9) << legacyMs / ms << "x" << std::scientific << std::setprecision(1) << std::setw(12)
+              << maxError << std::defaultfloat << "\n";
+  };
+  report("legacy", legacyMs, 0.0f);
+
+  for (SkinKernel kernel : {SkinKernel::Scalar, SkinKernel::SSE41, SkinKernel::AVX2})
+  {
+    if (!isSkinKernelSupported(kernel))
+    {
+      std::cout << std::left << std::setw(10) << skinKernelName(kernel) << "  not supported on this CPU\n";
+      continue;
+    }
+    eng.skinKernel = kernel;
+    const double ms = timePasses(
+        [&]
+        {
+          for (size_t i = 0; i < meshes.size(); ++i)
+            eng.deformMesh(*meshes[i], actual[i]);
+        });
+    float maxError = 0.0f;
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+      for (size_t v = 0; v < actual[i].size(); ++v)
+      {
+        const glm::vec2 d = actual[i][v] - expected[i][v];
+        maxError = std::max(maxError, std::max(std::abs(d.x), std::abs(d.y)));
+      }
+    }
+    report(skinKernelName(kernel), ms, maxError);
+  }
+  std::cout << "Engine default: " << skinKernelName(bestSkinKernel()) << "\n";
+  return 0;
+}
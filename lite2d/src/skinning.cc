@@ -0,0 +1,445 @@
+#include "skinning.h"
+
+#include <algorithm>
+
+#include "glmesh.h"
+#include "model.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define LITE2D_SKIN_X86 1
+#include <immintrin.h>
+// Kernels are compiled for their instruction set individually and only called after the CPU check,
+// so the rest of the library keeps the baseline target.
+#define LITE2D_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define LITE2D_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+static_assert(sizeof(SkinBone) == 6 * sizeof(float), "kernels index the palette as a float array");
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "kernels write positions as a float array");
+
+namespace
+{
+// Float offsets of the SkinBone fields.
+constexpr int kBoneA = 0, kBoneB = 1, kBoneC = 2, kBoneD = 3, kBoneTx = 4, kBoneTy = 5;
+constexpr int kBoneStride = 6;
+
+// ---------- Scalar ----------
+
+void skinRangeScalar(const SkinStreams &s, const float *x, const float *y, const SkinBone *pal, float *out,
+                     size_t begin, size_t end)
+{
+  switch (s.kind)
+  {
+  case SkinKind::Rigid:
+  {
+    const SkinBone m = pal[s.rigidBone];
+    for (size_t i = begin; i < end; ++i)
+    {
+      out[2 * i] = m.a * x[i] + m.c * y[i] + m.tx;
+      out[2 * i + 1] = m.b * x[i] + m.d * y[i] + m.ty;
+    }
+    break;
+  }
+  case SkinKind::OneBone:
+    for (size_t i = begin; i < end; ++i)
+    {
+      const SkinBone &m = pal[s.bone0[i]];
+      const float w = s.weight0[i];
+      out[2 * i] = w * (m.a * x[i] + m.c * y[i] + m.tx);
+      out[2 * i + 1] = w * (m.b * x[i] + m.d * y[i] + m.ty);
+    }
+    break;
+  case SkinKind::TwoBone:
+    for (size_t i = begin; i < end; ++i)
+    {
+      const SkinBone &m0 = pal[s.bone0[i]];
+      const SkinBone &m1 = pal[s.bone1[i]];
+      const float w0 = s.weight0[i], w1 = s.weight1[i];
+      // Blend the matrices, then transform once.
+      const float a = w0 * m0.a + w1 * m1.a, b = w0 * m0.b + w1 * m1.b;
+      const float c = w0 * m0.c + w1 * m1.c, d = w0 * m0.d + w1 * m1.d;
+      const float tx = w0 * m0.tx + w1 * m1.tx, ty = w0 * m0.ty + w1 * m1.ty;
+      out[2 * i] = a * x[i] + c * y[i] + tx;
+      out[2 * i + 1] = b * x[i] + d * y[i] + ty;
+    }
+    break;
+  }
+}
+
+void addDeltaBlocksScalar(float w, const uint32_t *blocks, size_t count, const float *dx, const float *dy, float *x,
+                          float *y)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    float *bx = x + size_t(blocks[i]) * kSkinDeltaBlock;
+    float *by = y + size_t(blocks[i]) * kSkinDeltaBlock;
+    const float *sx = dx + i * kSkinDeltaBlock;
+    const float *sy = dy + i * kSkinDeltaBlock;
+    for (size_t k = 0; k < kSkinDeltaBlock; ++k)
+    {
+      bx[k] += w * sx[k];
+      by[k] += w * sy[k];
+    }
+  }
+}
+
+#ifdef LITE2D_SKIN_X86
+
+// ---------- SSE4.1: 4 vertices per iteration ----------
+
+LITE2D_TARGET_SSE41 inline __m128 gatherSSE41(const float *pal, __m128i offsets)
+{
+  return _mm_setr_ps(pal[_mm_extract_epi32(offsets, 0)], pal[_mm_extract_epi32(offsets, 1)],
+                     pal[_mm_extract_epi32(offsets, 2)], pal[_mm_extract_epi32(offsets, 3)]);
+}
+
+LITE2D_TARGET_SSE41 inline void storeSSE41(float *out, __m128 ox, __m128 oy)
+{
+  _mm_storeu_ps(out, _mm_unpacklo_ps(ox, oy));
+  _mm_storeu_ps(out + 4, _mm_unpackhi_ps(ox, oy));
+}
+
+LITE2D_TARGET_SSE41 size_t skinSSE41(const SkinStreams &s, const float *xs, const float *ys, const SkinBone *palette,
+                                     float *out)
+{
+  const float *pal = &palette[0].a;
+  const size_t n = s.size() & ~size_t(3);
+  const __m128i stride = _mm_set1_epi32(kBoneStride);
+  for (size_t i = 0; i < n; i += 4)
+  {
+    const __m128 x = _mm_loadu_ps(xs + i);
+    const __m128 y = _mm_loadu_ps(ys + i);
+    __m128 a, b, c, d, tx, ty;
+    if (s.kind == SkinKind::Rigid)
+    {
+      const SkinBone &m = palette[s.rigidBone];
+      a = _mm_set1_ps(m.a), b = _mm_set1_ps(m.b), c = _mm_set1_ps(m.c), d = _mm_set1_ps(m.d);
+      tx = _mm_set1_ps(m.tx), ty = _mm_set1_ps(m.ty);
+    }
+    else
+    {
+      const __m128i o0 =
+          _mm_mullo_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s.bone0.data() + i)), stride);
+      const __m128 w0 = _mm_loadu_ps(s.weight0.data() + i);
+      a = _mm_mul_ps(w0, gatherSSE41(pal + kBoneA, o0));
+      b = _mm_mul_ps(w0, gatherSSE41(pal + kBoneB, o0));
+      c = _mm_mul_ps(w0, gatherSSE41(pal + kBoneC, o0));
+      d = _mm_mul_ps(w0, gatherSSE41(pal + kBoneD, o0));
+      tx = _mm_mul_ps(w0, gatherSSE41(pal + kBoneTx, o0));
+      ty = _mm_mul_ps(w0, gatherSSE41(pal + kBoneTy, o0));
+      if (s.kind == SkinKind::TwoBone)
+      {
+        const __m128i o1 =
+            _mm_mullo_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s.bone1.data() + i)), stride);
+        const __m128 w1 = _mm_loadu_ps(s.weight1.data() + i);
+        a = _mm_add_ps(a, _mm_mul_ps(w1, gatherSSE41(pal + kBoneA, o1)));
+        b = _mm_add_ps(b, _mm_mul_ps(w1, gatherSSE41(pal + kBoneB, o1)));
+        c = _mm_add_ps(c, _mm_mul_ps(w1, gatherSSE41(pal + kBoneC, o1)));
+        d = _mm_add_ps(d, _mm_mul_ps(w1, gatherSSE41(pal + kBoneD, o1)));
+        tx = _mm_add_ps(tx, _mm_mul_ps(w1, gatherSSE41(pal + kBoneTx, o1)));
+        ty = _mm_add_ps(ty, _mm_mul_ps(w1, gatherSSE41(pal + kBoneTy, o1)));
+      }
+    }
+    const __m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(c, y)), tx);
+    const __m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, x), _mm_mul_ps(d, y)), ty);
+    storeSSE41(out + 2 * i, ox, oy);
+  }
+  return n;
+}
+
+LITE2D_TARGET_SSE41 void addDeltaBlocksSSE41(float w, const uint32_t *blocks, size_t count, const float *dx,
+                                             const float *dy, float *x, float *y)
+{
+  static_assert(kSkinDeltaBlock == 8, "one block is two SSE registers per stream");
+  const __m128 wv = _mm_set1_ps(w);
+  for (size_t i = 0; i < count; ++i)
+  {
+    float *bx = x + size_t(blocks[i]) * kSkinDeltaBlock;
+    float *by = y + size_t(blocks[i]) * kSkinDeltaBlock;
+    const float *sx = dx + i * kSkinDeltaBlock;
+    const float *sy = dy + i * kSkinDeltaBlock;
+    _mm_storeu_ps(bx, _mm_add_ps(_mm_loadu_ps(bx), _mm_mul_ps(wv, _mm_loadu_ps(sx))));
+    _mm_storeu_ps(bx + 4, _mm_add_ps(_mm_loadu_ps(bx + 4), _mm_mul_ps(wv, _mm_loadu_ps(sx + 4))));
+    _mm_storeu_ps(by, _mm_add_ps(_mm_loadu_ps(by), _mm_mul_ps(wv, _mm_loadu_ps(sy))));
+    _mm_storeu_ps(by + 4, _mm_add_ps(_mm_loadu_ps(by + 4), _mm_mul_ps(wv, _mm_loadu_ps(sy + 4))));
+  }
+}
+
+// ---------- AVX2: 8 vertices per iteration ----------
+
+LITE2D_TARGET_AVX2 inline void storeAVX2(float *out, __m256 ox, __m256 oy)
+{
+  // unpack works per 128-bit half: lo = v0 v1 | v4 v5, hi = v2 v3 | v6 v7.
+  const __m256 lo = _mm256_unpacklo_ps(ox, oy);
+  const __m256 hi = _mm256_unpackhi_ps(ox, oy);
+  _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));
+  _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+LITE2D_TARGET_AVX2 size_t skinAVX2(const SkinStreams &s, const float *xs, const float *ys, const SkinBone *palette,
+                                   float *out)
+{
+  const float *pal = &palette[0].a;
+  const size_t n = s.size() & ~size_t(7);
+  const __m256i stride = _mm256_set1_epi32(kBoneStride);
+  for (size_t i = 0; i < n; i += 8)
+  {
+    const __m256 x = _mm256_loadu_ps(xs + i);
+    const __m256 y = _mm256_loadu_ps(ys + i);
+    __m256 a, b, c, d, tx, ty;
+    if (s.kind == SkinKind::Rigid)
+    {
+      const SkinBone &m = palette[s.rigidBone];
+      a = _mm256_set1_ps(m.a), b = _mm256_set1_ps(m.b), c = _mm256_set1_ps(m.c), d = _mm256_set1_ps(m.d);
+      tx = _mm256_set1_ps(m.tx), ty = _mm256_set1_ps(m.ty);
+    }
+    else
+    {
+      const __m256i o0 =
+          _mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s.bone0.data() + i)), stride);
+      const __m256 w0 = _mm256_loadu_ps(s.weight0.data() + i);
+      a = _mm256_mul_ps(w0, _mm256_i32gather_ps(pal + kBoneA, o0, 4));
+      b = _mm256_mul_ps(w0, _mm256_i32gather_ps(pal + kBoneB, o0, 4));
+      c = _mm256_mul_ps(w0, _mm256_i32gather_ps(pal + kBoneC, o0, 4));
+      d = _mm256_mul_ps(w0, _mm256_i32gather_ps(pal + kBoneD, o0, 4));
+      tx = _mm256_mul_ps(w0, _mm256_i32gather_ps(pal + kBoneTx, o0, 4));
+      ty = _mm256_mul_ps(w0, _mm256_i32gather_ps(pal + kBoneTy, o0, 4));
+      if (s.kind == SkinKind::TwoBone)
+      {
+        const __m256i o1 =
+            _mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s.bone1.data() + i)), stride);
+        const __m256 w1 = _mm256_loadu_ps(s.weight1.data() + i);
+        a = _mm256_fmadd_ps(w1, _mm256_i32gather_ps(pal + kBoneA, o1, 4), a);
+        b = _mm256_fmadd_ps(w1, _mm256_i32gather_ps(pal + kBoneB, o1, 4), b);
+        c = _mm256_fmadd_ps(w1, _mm256_i32gather_ps(pal + kBoneC, o1, 4), c);
+        d = _mm256_fmadd_ps(w1, _mm256_i32gather_ps(pal + kBoneD, o1, 4), d);
+        tx = _mm256_fmadd_ps(w1, _mm256_i32gather_ps(pal + kBoneTx, o1, 4), tx);
+        ty = _mm256_fmadd_ps(w1, _mm256_i32gather_ps(pal + kBoneTy, o1, 4), ty);
+      }
+    }
+    const __m256 ox = _mm256_fmadd_ps(a, x, _mm256_fmadd_ps(c, y, tx));
+    const __m256 oy = _mm256_fmadd_ps(b, x, _mm256_fmadd_ps(d, y, ty));
+    storeAVX2(out + 2 * i, ox, oy);
+  }
+  return n;
+}
+
+LITE2D_TARGET_AVX2 void addDeltaBlocksAVX2(float w, const uint32_t *blocks, size_t count, const float *dx,
+                                           const float *dy, float *x, float *y)
+{
+  static_assert(kSkinDeltaBlock == 8, "one block is one AVX register per stream");
+  const __m256 wv = _mm256_set1_ps(w);
+  for (size_t i = 0; i < count; ++i)
+  {
+    float *bx = x + size_t(blocks[i]) * kSkinDeltaBlock;
+    float *by = y + size_t(blocks[i]) * kSkinDeltaBlock;
+    _mm256_storeu_ps(bx, _mm256_fmadd_ps(wv, _mm256_loadu_ps(dx + i * kSkinDeltaBlock), _mm256_loadu_ps(bx)));
+    _mm256_storeu_ps(by, _mm256_fmadd_ps(wv, _mm256_loadu_ps(dy + i * kSkinDeltaBlock), _mm256_loadu_ps(by)));
+  }
+}
+
+#endif // LITE2D_SKIN_X86
+
+// Andrew's monotone chain; collinear points are dropped.
+std::vector<glm::vec2> convexHull(std::vector<glm::vec2> pts)
+{
+  std::sort(pts.begin(), pts.end(),
+            [](glm::vec2 a, glm::vec2 b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+  pts.erase(std::unique(pts.begin(), pts.end()), pts.end());
+  if (pts.size() < 3)
+    return pts;
+  auto cross = [](glm::vec2 o, glm::vec2 a, glm::vec2 b)
+  { return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x); };
+  std::vector<glm::vec2> hull(2 * pts.size());
+  size_t k = 0;
+  for (size_t i = 0; i < pts.size(); ++i)
+  {
+    while (k >= 2 && cross(hull[k - 2], hull[k - 1], pts[i]) <= 0.0f)
+      --k;
+    hull[k++] = pts[i];
+  }
+  for (size_t i = pts.size() - 1, lower = k + 1; i-- > 0;)
+  {
+    while (k >= lower && cross(hull[k - 2], hull[k - 1], pts[i]) <= 0.0f)
+      --k;
+    hull[k++] = pts[i];
+  }
+  hull.resize(k - 1);
+  return hull;
+}
+
+SkinKernel detectSkinKernel()
+{
+  if (isSkinKernelSupported(SkinKernel::AVX2))
+    return SkinKernel::AVX2;
+  if (isSkinKernelSupported(SkinKernel::SSE41))
+    return SkinKernel::SSE41;
+  return SkinKernel::Scalar;
+}
+} // namespace
+
+SkinKernel bestSkinKernel()
+{
+  static const SkinKernel kernel = detectSkinKernel();
+  return kernel;
+}
+
+bool isSkinKernelSupported(SkinKernel kernel)
+{
+  switch (kernel)
+  {
+  case SkinKernel::Scalar:
+    return true;
+#ifdef LITE2D_SKIN_X86
+  case SkinKernel::SSE41:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+  case SkinKernel::AVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+  default:
+    return false;
+  }
+}
+
+const char *skinKernelName(SkinKernel kernel)
+{
+  switch (kernel)
+  {
+  case SkinKernel::SSE41:
+    return "sse4.1";
+  case SkinKernel::AVX2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+
+void buildSkinStreams(ArtMesh &mesh)
+{
+  SkinStreams &s = mesh.skin;
+  const size_t n = mesh.verts.size();
+  const int32_t zeroSlot = static_cast<int32_t>(mesh.deformers.size());
+  s.x.resize(n);
+  s.y.resize(n);
+  s.bone0.assign(n, zeroSlot);
+  s.bone1.assign(n, zeroSlot);
+  s.weight0.assign(n, 0.0f);
+  s.weight1.assign(n, 0.0f);
+
+  bool twoBones = false, unitWeights = true, sameBone = true;
+  for (size_t i = 0; i < n; ++i)
+  {
+    const Vertex &v = mesh.verts[i];
+    s.x[i] = v.pos.x;
+    s.y[i] = v.pos.y;
+    // Compact the usable influences to the front; unusable ones stay on the zero slot.
+    int used = 0;
+    for (int j = 0; j < 2; ++j)
+    {
+      if (v.weight[j] <= 0.0f || v.bone[j] < 0 || v.bone[j] >= zeroSlot)
+        continue;
+      (used == 0 ? s.bone0[i] : s.bone1[i]) = v.bone[j];
+      (used == 0 ? s.weight0[i] : s.weight1[i]) = v.weight[j];
+      ++used;
+    }
+    twoBones |= used == 2;
+    unitWeights &= used == 1 && s.weight0[i] == 1.0f;
+    sameBone &= s.bone0[i] == s.bone0[0];
+  }
+
+  if (twoBones)
+    s.kind = SkinKind::TwoBone;
+  else if (unitWeights && sameBone)
+    s.kind = SkinKind::Rigid;
+  else
+    s.kind = SkinKind::OneBone;
+  s.rigidBone = n > 0 ? s.bone0[0] : zeroSlot;
+
+  // Keep only the streams the kernel reads.
+  if (s.kind != SkinKind::TwoBone)
+  {
+    std::vector<int32_t>().swap(s.bone1);
+    std::vector<float>().swap(s.weight1);
+  }
+  if (s.kind == SkinKind::Rigid)
+  {
+    std::vector<int32_t>().swap(s.bone0);
+    std::vector<float>().swap(s.weight0);
+    std::vector<glm::vec2> rest(n);
+    for (size_t i = 0; i < n; ++i)
+      rest[i] = mesh.verts[i].pos;
+    s.hull = convexHull(std::move(rest));
+  }
+  else
+  {
+    std::vector<glm::vec2>().swap(s.hull);
+  }
+}
+
+void buildSkinStreams(Model &model)
+{
+  for (auto &kv : model.meshes)
+    buildSkinStreams(kv.second);
+}
+
+size_t skinPaletteSize(const ArtMesh &mesh)
+{
+  return mesh.deformers.size() + 1;
+}
+
+void skinVertices(const SkinStreams &skin, std::span<const SkinBone> palette, std::span<glm::vec2> out,
+                  SkinKernel kernel)
+{
+  skinVertices(skin, skin.x, skin.y, palette, out, kernel);
+}
+
+void skinVertices(const SkinStreams &skin, std::span<const float> x, std::span<const float> y,
+                  std::span<const SkinBone> palette, std::span<glm::vec2> out, SkinKernel kernel)
+{
+  float *dst = reinterpret_cast<float *>(out.data());
+  size_t done = 0;
+#ifdef LITE2D_SKIN_X86
+  if (kernel == SkinKernel::AVX2)
+    done = skinAVX2(skin, x.data(), y.data(), palette.data(), dst);
+  else if (kernel == SkinKernel::SSE41)
+    done = skinSSE41(skin, x.data(), y.data(), palette.data(), dst);
+#else
+  (void)kernel;
+#endif
+  skinRangeScalar(skin, x.data(), y.data(), palette.data(), dst, done, skin.size());
+}
+
+void addDeltaBlocks(float w, std::span<const uint32_t> blocks, const float *dx, const float *dy, float *x, float *y,
+                    SkinKernel kernel)
+{
+#ifdef LITE2D_SKIN_X86
+  if (kernel == SkinKernel::AVX2)
+    return addDeltaBlocksAVX2(w, blocks.data(), blocks.size(), dx, dy, x, y);
+  if (kernel == SkinKernel::SSE41)
+    return addDeltaBlocksSSE41(w, blocks.data(), blocks.size(), dx, dy, x, y);
+#else
+  (void)kernel;
+#endif
+  addDeltaBlocksScalar(w, blocks.data(), blocks.size(), dx, dy, x, y);
+}
+
+void skinVerticesAoS(const ArtMesh &mesh, std::span<const SkinBone> palette, std::span<glm::vec2> out)
+{
+  const int zeroSlot = static_cast<int>(mesh.deformers.size());
+  for (size_t i = 0; i < mesh.verts.size(); ++i)
+  {
+    const Vertex &v = mesh.verts[i];
+    glm::vec2 acc{0.0f};
+    for (int j = 0; j < 2; ++j)
+    {
+      if (v.weight[j] <= 0.0f || v.bone[j] < 0 || v.bone[j] >= zeroSlot)
+        continue;
+      const SkinBone &m = palette[v.bone[j]];
+      acc.x += v.weight[j] * (m.a * v.pos.x + m.c * v.pos.y + m.tx);
+      acc.y += v.weight[j] * (m.b * v.pos.x + m.d * v.pos.y + m.ty);
+    }
+    out[i] = acc;
+  }
+}
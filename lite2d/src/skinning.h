@@ -0,0 +1,115 @@
+#ifndef __LITE2D_SKINNING_H__
+#pragma once
+#define __LITE2D_SKINNING_H__
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct ArtMesh;
+struct Model;
+
+// ---------- CPU skinning ----------
+//
+// Meshes keep a structure-of-arrays copy of their skinning inputs (SkinStreams) next to the AoS
+// vertices. Per frame the engine resolves each mesh's bones to a palette of affine matrices once,
+// and a SIMD kernel picked at startup (AVX2, SSE4.1 or scalar) blends and applies them.
+
+/**
+ * 2D affine bone matrix: x' = a*x + c*y + tx, y' = b*x + d*y + ty.
+ */
+struct SkinBone
+{
+  float a = 0.0f, b = 0.0f, c = 0.0f, d = 0.0f, tx = 0.0f, ty = 0.0f;
+
+  bool operator==(const SkinBone &) const = default;
+};
+
+// How many influences a mesh's vertices use, which picks the kernel variant.
+enum class SkinKind : uint8_t
+{
+  Rigid,   // every vertex is bone rigidBone with weight 1
+  OneBone, // one influence per vertex, bone varies
+  TwoBone, // up to two influences per vertex
+};
+
+/**
+ * Skinning inputs of one mesh as parallel arrays, built by buildSkinStreams.
+ * Influences with a non-positive weight or a bone outside ArtMesh::deformers point at palette slot
+ * deformers.size() (an all-zero matrix) with weight 0, so kernels never branch per vertex.
+ * @param x Rest position x per vertex.
+ * @param y Rest position y per vertex.
+ * @param bone0 First palette index per vertex.
+ * @param bone1 Second palette index per vertex (empty unless kind is TwoBone).
+ * @param weight0 First weight per vertex (empty if kind is Rigid).
+ * @param weight1 Second weight per vertex (empty unless kind is TwoBone).
+ * @param kind Kernel variant the mesh needs.
+ * @param rigidBone Palette index used by every vertex when kind is Rigid.
+ * @param hull Convex hull of the rest positions when kind is Rigid; bounds of the skinned mesh are
+ *             the bounds of the skinned hull.
+ */
+struct SkinStreams
+{
+  std::vector<float> x, y;
+  std::vector<int32_t> bone0, bone1;
+  std::vector<float> weight0, weight1;
+  SkinKind kind = SkinKind::Rigid;
+  int32_t rigidBone = 0;
+  std::vector<glm::vec2> hull;
+
+  size_t size() const { return x.size(); }
+};
+
+enum class SkinKernel : uint8_t
+{
+  Scalar,
+  SSE41,
+  AVX2,
+};
+
+// Fastest kernel this CPU supports; decided once.
+SkinKernel bestSkinKernel();
+bool isSkinKernelSupported(SkinKernel kernel);
+const char *skinKernelName(SkinKernel kernel);
+
+// Rebuilds ArtMesh::skin from the mesh's vertices. Call again after verts or deformers change.
+void buildSkinStreams(ArtMesh &mesh);
+void buildSkinStreams(Model &model);
+
+// Palette size skinVertices expects for a mesh: one entry per deformer plus the zero slot.
+size_t skinPaletteSize(const ArtMesh &mesh);
+
+/**
+ * Skins skin into out (skin.size() positions) with the given kernel.
+ * @param palette Bone matrices indexed like ArtMesh::deformers, followed by the zero slot.
+ */
+void skinVertices(const SkinStreams &skin, std::span<const SkinBone> palette, std::span<glm::vec2> out,
+                  SkinKernel kernel = bestSkinKernel());
+
+// Same, with rest positions taken from x and y (skin.size() each) instead of skin.x and skin.y.
+void skinVertices(const SkinStreams &skin, std::span<const float> x, std::span<const float> y,
+                  std::span<const SkinBone> palette, std::span<glm::vec2> out, SkinKernel kernel = bestSkinKernel());
+
+// Same result from the AoS vertices, for meshes whose SkinStreams are out of date.
+void skinVerticesAoS(const ArtMesh &mesh, std::span<const SkinBone> palette, std::span<glm::vec2> out);
+
+// Vertices per block of addDeltaBlocks.
+constexpr size_t kSkinDeltaBlock = 8;
+
+/**
+ * Adds w times blocks of offsets to position streams, with the given kernel:
+ * x[kSkinDeltaBlock * blocks[i] + k] += w * dx[kSkinDeltaBlock * i + k] for k < kSkinDeltaBlock, and
+ * the same for y. x and y must hold every block named in blocks in full.
+ */
+void addDeltaBlocks(float w, std::span<const uint32_t> blocks, const float *dx, const float *dy, float *x, float *y,
+                    SkinKernel kernel = bestSkinKernel());
+
+// The palette entry of a deformer world matrix.
+inline SkinBone toSkinBone(const glm::mat3 &m)
+{
+  return SkinBone{m[0][0], m[0][1], m[1][0], m[1][1], m[2][0], m[2][1]};
+}
+
+#endif  // __LITE2D_SKINNING_H__
@@ -3,15 +3,31 @@
 #include <iostream>
 #include <string>
 
+#include "load_profile.h"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
+unsigned char *decodeImageRGBA(const std::string &path, int &w, int &h)
+{
+  LoadPhaseScope phase("texture_decode");
+  int n=0;
+  unsigned char* data = stbi_load(path.c_str(), &w, &h, &n, 4);
+  if (data) phase.setItems(uint64_t(w) * uint64_t(h));
+  return data;
+}
+
+void freeImagePixels(unsigned char *pixels)
+{
+  stbi_image_free(pixels);
+}
+
 Texture Texture::fromFilePath(const std::string &path)
 {
   Texture t;
-  int n=0;
-  unsigned char* data = stbi_load(path.c_str(), &t.w, &t.h, &n, 4);
+  unsigned char* data = decodeImageRGBA(path, t.w, t.h);
   if (!data) { std::cerr << "Failed load " << path << "\n"; return t; }
+  LoadPhaseScope phase("texture_upload", uint64_t(t.w) * uint64_t(t.h) * 4);
   glGenTextures(1, &t.id);
   glBindTexture(GL_TEXTURE_2D, t.id);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, t.w, t.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
@@ -19,6 +35,6 @@ Texture Texture::fromFilePath(const std::string &path)
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  stbi_image_free(data);
+  freeImagePixels(data);
   return t;
 }
@@ -15,4 +15,9 @@ public:
   Texture fromFilePath(const std::string &path);
 };
 
+// Decodes an image file to tightly packed RGBA8 without touching GL. Returns nullptr on failure;
+// release the pixels with freeImagePixels.
+unsigned char *decodeImageRGBA(const std::string &path, int &w, int &h);
+void freeImagePixels(unsigned char *pixels);
+
 #endif  // __LITE2D_TEXTURE_H__
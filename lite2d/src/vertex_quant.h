@@ -0,0 +1,66 @@
+#ifndef __LITE2D_VERTEX_QUANT_H__
+#pragma once
+#define __LITE2D_VERTEX_QUANT_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// ---------- 16-bit fixed-point vertex attributes ----------
+//
+// Positions and UVs are stored as unsigned 16-bit values relative to a per-mesh range:
+//   value = origin + q / 65535 * extent
+// which is exactly what a normalized GL_UNSIGNED_SHORT attribute gives the shader before it
+// applies origin/extent from a uniform.
+
+/**
+ * The range a set of 2D values is quantized against.
+ * @param origin The minimum corner.
+ * @param extent The size of the range (0 on an axis where every value is equal).
+ */
+struct QuantRange
+{
+  glm::vec2 origin{0.0f};
+  glm::vec2 extent{0.0f};
+};
+
+// Bounds of count values read from first with the given byte stride.
+inline QuantRange quantRangeOf(const glm::vec2 *first, size_t count, size_t strideBytes = sizeof(glm::vec2))
+{
+  QuantRange r;
+  if (count == 0)
+    return r;
+  const auto *bytes = reinterpret_cast<const unsigned char *>(first);
+  glm::vec2 lo = *first, hi = *first;
+  for (size_t i = 1; i < count; ++i)
+  {
+    const glm::vec2 &v = *reinterpret_cast<const glm::vec2 *>(bytes + i * strideBytes);
+    lo = glm::min(lo, v);
+    hi = glm::max(hi, v);
+  }
+  r.origin = lo;
+  r.extent = hi - lo;
+  return r;
+}
+
+inline uint16_t quantizeUnorm16(float v, float origin, float extent)
+{
+  if (!(extent > 0.0f))
+    return 0;
+  const float t = std::clamp((v - origin) / extent, 0.0f, 1.0f);
+  return static_cast<uint16_t>(std::lround(t * 65535.0f));
+}
+
+inline float dequantizeUnorm16(uint16_t q, float origin, float extent)
+{
+  return origin + (static_cast<float>(q) / 65535.0f) * extent;
+}
+
+inline uint8_t quantizeUnorm8(float v)
+{
+  return static_cast<uint8_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+}
+
+#endif  // __LITE2D_VERTEX_QUANT_H__